@@ -0,0 +1,516 @@
+//! Embedded font programs for `Corpus::FontHeavy`, so its text goes through
+//! font parsing and glyph rasterization rather than the standard-14
+//! fallbacks. The faces are generated: half TrueType (`FontFile2`), half
+//! CFF (`FontFile3 /Type1C`), each with its own seeded outlines. Glyphs are
+//! quadratic blobs, not letters; only the work to draw them matters.
+
+use super::Lcg;
+use lopdf::{Document, Object, Stream, dictionary};
+
+const FIRST_CHAR: u8 = 32;
+const LAST_CHAR: u8 = 126;
+const UNITS_PER_EM: u16 = 1000;
+const ASCENT: i16 = 800;
+const DESCENT: i16 = -200;
+
+/// Adds `count` embedded faces to `doc`, returning references to their font
+/// dictionaries.
+pub fn embed_faces(doc: &mut Document, count: usize) -> Vec<Object> {
+    (0..count)
+        .map(|face| {
+            let glyphs = glyphs(face as u64);
+            let widths: Vec<Object> = glyphs[1..]
+                .iter()
+                .map(|g| Object::Integer(i64::from(g.advance)))
+                .collect();
+            let bbox = glyphs.iter().fold([0i16; 4], |acc, g| {
+                let b = g.bbox();
+                [
+                    acc[0].min(b[0]),
+                    acc[1].min(b[1]),
+                    acc[2].max(b[2]),
+                    acc[3].max(b[3]),
+                ]
+            });
+            let bbox: Vec<Object> = bbox.iter().map(|&v| Object::Integer(v.into())).collect();
+            let (name, subtype, file_key, file) = if face % 2 == 0 {
+                let program = truetype(&glyphs);
+                let length = program.len() as i64;
+                (
+                    format!("BenchSerif{face}"),
+                    "TrueType",
+                    "FontFile2",
+                    Stream::new(dictionary! { "Length1" => length }, program),
+                )
+            } else {
+                let name = format!("BenchSans{face}");
+                let program = cff(&name, &glyphs);
+                (
+                    name,
+                    "Type1",
+                    "FontFile3",
+                    Stream::new(dictionary! { "Subtype" => "Type1C" }, program),
+                )
+            };
+            let file_id = doc.add_object(file);
+            let descriptor_id = doc.add_object(dictionary! {
+                "Type" => "FontDescriptor",
+                "FontName" => name.as_str(),
+                "Flags" => 32i64,
+                "FontBBox" => bbox,
+                "ItalicAngle" => 0i64,
+                "Ascent" => i64::from(ASCENT),
+                "Descent" => i64::from(DESCENT),
+                "CapHeight" => 700i64,
+                "StemV" => 80i64,
+                file_key => file_id,
+            });
+            doc.add_object(dictionary! {
+                "Type" => "Font",
+                "Subtype" => subtype,
+                "BaseFont" => name.as_str(),
+                "FirstChar" => i64::from(FIRST_CHAR),
+                "LastChar" => i64::from(LAST_CHAR),
+                "Widths" => widths,
+                "Encoding" => "WinAnsiEncoding",
+                "FontDescriptor" => descriptor_id,
+            })
+            .into()
+        })
+        .collect()
+}
+
+/// A glyph's advance and closed contours. Each contour alternates on-curve
+/// and off-curve points, starting on the curve, as quadratic TrueType
+/// outlines do; the CFF writer turns every segment into a cubic.
+struct Glyph {
+    advance: u16,
+    contours: Vec<Vec<(i16, i16)>>,
+}
+
+impl Glyph {
+    fn bbox(&self) -> [i16; 4] {
+        let mut points = self.contours.iter().flatten();
+        let Some(&(x, y)) = points.next() else {
+            return [0; 4];
+        };
+        points.fold([x, y, x, y], |b, &(x, y)| {
+            [b[0].min(x), b[1].min(y), b[2].max(x), b[3].max(y)]
+        })
+    }
+}
+
+/// `.notdef` followed by one glyph per code in `FIRST_CHAR..=LAST_CHAR`.
+fn glyphs(face: u64) -> Vec<Glyph> {
+    let mut rng = Lcg(0x5eed_f0e7 ^ (face << 16));
+    let mut glyphs = vec![Glyph {
+        advance: 500,
+        contours: Vec::new(),
+    }];
+    for code in FIRST_CHAR..=LAST_CHAR {
+        if code == b' ' {
+            glyphs.push(Glyph {
+                advance: 250,
+                contours: Vec::new(),
+            });
+            continue;
+        }
+        let advance = 450 + rng.below(300) as u16;
+        let (cx, cy) = (f64::from(advance) / 2.0, 330.0);
+        let (rx, ry) = (cx - 40.0, 280.0 + rng.below(60) as f64);
+        // Opposite windings, so the counter is a hole under either fill rule.
+        let segments = 6 + rng.below(10);
+        let mut contours = vec![blob(&mut rng, (cx, cy), (rx, ry), segments, true)];
+        if rng.below(2) == 0 {
+            let segments = 4 + rng.below(5);
+            let inner = (rx * 0.35, ry * 0.35);
+            contours.push(blob(&mut rng, (cx, cy), inner, segments, false));
+        }
+        glyphs.push(Glyph { advance, contours });
+    }
+    glyphs
+}
+
+/// `segments` quadratic segments around an ellipse, with jittered radii.
+fn blob(
+    rng: &mut Lcg,
+    (cx, cy): (f64, f64),
+    (rx, ry): (f64, f64),
+    segments: usize,
+    clockwise: bool,
+) -> Vec<(i16, i16)> {
+    let step = std::f64::consts::PI / segments as f64;
+    (0..segments * 2)
+        .map(|k| {
+            let angle = (if clockwise { -step } else { step }) * k as f64;
+            let jitter = rng.below(20) as f64 / 100.0;
+            let reach = if k % 2 == 0 {
+                0.8 + jitter
+            } else {
+                1.05 + jitter
+            };
+            (
+                (cx + rx * reach * angle.cos()).round() as i16,
+                (cy + ry * reach * angle.sin()).round() as i16,
+            )
+        })
+        .collect()
+}
+
+trait Put {
+    fn u16(&mut self, v: u16);
+    fn i16(&mut self, v: i16);
+    fn u32(&mut self, v: u32);
+}
+
+impl Put for Vec<u8> {
+    fn u16(&mut self, v: u16) {
+        self.extend_from_slice(&v.to_be_bytes());
+    }
+    fn i16(&mut self, v: i16) {
+        self.extend_from_slice(&v.to_be_bytes());
+    }
+    fn u32(&mut self, v: u32) {
+        self.extend_from_slice(&v.to_be_bytes());
+    }
+}
+
+fn truetype(glyphs: &[Glyph]) -> Vec<u8> {
+    let num_glyphs = glyphs.len() as u16;
+    let bbox = glyphs.iter().fold([0i16; 4], |acc, g| {
+        let b = g.bbox();
+        [
+            acc[0].min(b[0]),
+            acc[1].min(b[1]),
+            acc[2].max(b[2]),
+            acc[3].max(b[3]),
+        ]
+    });
+
+    let mut glyf = Vec::new();
+    let mut loca = Vec::new();
+    for glyph in glyphs {
+        loca.u32(glyf.len() as u32);
+        simple_glyph(&mut glyf, glyph);
+        while glyf.len() % 4 != 0 {
+            glyf.push(0);
+        }
+    }
+    loca.u32(glyf.len() as u32);
+
+    // (1, 0) byte encoding and (3, 1) Unicode, both mapping the printable
+    // ASCII codes to glyphs 1.. in order.
+    let mut cmap = Vec::new();
+    cmap.u16(0);
+    cmap.u16(2);
+    cmap.u16(1);
+    cmap.u16(0);
+    cmap.u32(20);
+    cmap.u16(3);
+    cmap.u16(1);
+    cmap.u32(20 + 262);
+    cmap.u16(0);
+    cmap.u16(262);
+    cmap.u16(0);
+    cmap.extend((0..=255u8).map(|code| {
+        if (FIRST_CHAR..=LAST_CHAR).contains(&code) {
+            code - FIRST_CHAR + 1
+        } else {
+            0
+        }
+    }));
+    cmap.u16(4);
+    cmap.u16(32);
+    cmap.u16(0);
+    cmap.u16(4); // segCountX2
+    cmap.u16(4); // searchRange
+    cmap.u16(1); // entrySelector
+    cmap.u16(0); // rangeShift
+    cmap.u16(u16::from(LAST_CHAR));
+    cmap.u16(0xFFFF);
+    cmap.u16(0);
+    cmap.u16(u16::from(FIRST_CHAR));
+    cmap.u16(0xFFFF);
+    cmap.u16(1u16.wrapping_sub(u16::from(FIRST_CHAR)));
+    cmap.u16(1);
+    cmap.u16(0);
+    cmap.u16(0);
+
+    let mut head = Vec::new();
+    head.u32(0x0001_0000);
+    head.u32(0x0001_0000);
+    head.u32(0); // checkSumAdjustment, patched below
+    head.u32(0x5F0F_3CF5);
+    head.u16(0x000B);
+    head.u16(UNITS_PER_EM);
+    head.extend_from_slice(&[0; 16]); // created, modified
+    for v in bbox {
+        head.i16(v);
+    }
+    head.u16(0); // macStyle
+    head.u16(8); // lowestRecPPEM
+    head.i16(2); // fontDirectionHint
+    head.i16(1); // indexToLocFormat: long
+    head.i16(0);
+
+    let max_advance = glyphs.iter().map(|g| g.advance).max().unwrap_or(0);
+    let mut hhea = Vec::new();
+    hhea.u32(0x0001_0000);
+    hhea.i16(ASCENT);
+    hhea.i16(DESCENT);
+    hhea.i16(0);
+    hhea.u16(max_advance);
+    hhea.i16(bbox[0]);
+    hhea.i16(0);
+    hhea.i16(bbox[2]);
+    hhea.i16(1);
+    hhea.i16(0);
+    hhea.i16(0);
+    hhea.extend_from_slice(&[0; 8]);
+    hhea.i16(0);
+    hhea.u16(num_glyphs);
+
+    let mut hmtx = Vec::new();
+    for glyph in glyphs {
+        hmtx.u16(glyph.advance);
+        hmtx.i16(glyph.bbox()[0]);
+    }
+
+    let max_points = glyphs
+        .iter()
+        .map(|g| g.contours.iter().map(Vec::len).sum::<usize>())
+        .max()
+        .unwrap_or(0);
+    let max_contours = glyphs.iter().map(|g| g.contours.len()).max().unwrap_or(0);
+    let mut maxp = Vec::new();
+    maxp.u32(0x0001_0000);
+    maxp.u16(num_glyphs);
+    maxp.u16(max_points as u16);
+    maxp.u16(max_contours as u16);
+    maxp.u16(0);
+    maxp.u16(0);
+    maxp.u16(2); // maxZones
+    maxp.extend_from_slice(&[0; 16]);
+
+    let mut post = Vec::new();
+    post.u32(0x0003_0000);
+    post.extend_from_slice(&[0; 28]);
+
+    let mut font = sfnt(&mut [
+        (*b"cmap", cmap),
+        (*b"glyf", glyf),
+        (*b"head", head),
+        (*b"hhea", hhea),
+        (*b"hmtx", hmtx),
+        (*b"loca", loca),
+        (*b"maxp", maxp),
+        (*b"post", post),
+    ]);
+    let record = (0..8)
+        .map(|i| 12 + i * 16)
+        .find(|&record| &font[record..record + 4] == b"head")
+        .expect("head table");
+    let head_offset =
+        u32::from_be_bytes(font[record + 8..record + 12].try_into().unwrap()) as usize;
+    let adjustment = 0xB1B0_AFBAu32.wrapping_sub(checksum(&font));
+    font[head_offset + 8..head_offset + 12].copy_from_slice(&adjustment.to_be_bytes());
+    font
+}
+
+fn simple_glyph(out: &mut Vec<u8>, glyph: &Glyph) {
+    if glyph.contours.is_empty() {
+        return;
+    }
+    out.i16(glyph.contours.len() as i16);
+    for v in glyph.bbox() {
+        out.i16(v);
+    }
+    let mut end = 0;
+    for contour in &glyph.contours {
+        end += contour.len();
+        out.u16(end as u16 - 1);
+    }
+    out.u16(0); // instructionLength
+    for contour in &glyph.contours {
+        out.extend((0..contour.len()).map(|i| u8::from(i % 2 == 0)));
+    }
+    for axis in [0, 1] {
+        let mut last = 0i16;
+        for &(x, y) in glyph.contours.iter().flatten() {
+            let v = if axis == 0 { x } else { y };
+            out.i16(v - last);
+            last = v;
+        }
+    }
+}
+
+fn sfnt(tables: &mut [([u8; 4], Vec<u8>)]) -> Vec<u8> {
+    let count = tables.len() as u16;
+    let entry_selector = 15 - count.leading_zeros() as u16;
+    let search_range = 16 << entry_selector;
+    let mut font = Vec::new();
+    font.u32(0x0001_0000);
+    font.u16(count);
+    font.u16(search_range);
+    font.u16(entry_selector);
+    font.u16(count * 16 - search_range);
+    let mut offset = 12 + 16 * tables.len();
+    for (tag, data) in tables.iter() {
+        font.extend_from_slice(tag);
+        font.u32(checksum(data));
+        font.u32(offset as u32);
+        font.u32(data.len() as u32);
+        offset += data.len().next_multiple_of(4);
+    }
+    for (_, data) in tables.iter_mut() {
+        data.resize(data.len().next_multiple_of(4), 0);
+        font.extend_from_slice(data);
+    }
+    font
+}
+
+fn checksum(data: &[u8]) -> u32 {
+    data.chunks(4).fold(0u32, |sum, chunk| {
+        let mut word = [0; 4];
+        word[..chunk.len()].copy_from_slice(chunk);
+        sum.wrapping_add(u32::from_be_bytes(word))
+    })
+}
+
+/// A bare CFF font: no subroutines, the standard encoding and a charset
+/// naming glyph `n` by standard string `n`, which is `space`..`asciitilde`
+/// for the printable ASCII codes.
+fn cff(name: &str, glyphs: &[Glyph]) -> Vec<u8> {
+    let names = cff_index(&[name.as_bytes().to_vec()]);
+    let strings = cff_index(&[]);
+    let global_subrs = cff_index(&[]);
+
+    let mut charset = vec![0u8];
+    for sid in 1..glyphs.len() as u16 {
+        charset.u16(sid);
+    }
+    let charstrings = cff_index(&glyphs.iter().map(charstring).collect::<Vec<_>>());
+    let private = {
+        let mut dict = Vec::new();
+        dict_int(&mut dict, 0);
+        dict.push(21); // nominalWidthX
+        dict
+    };
+
+    // Every Top DICT operand uses the fixed five-byte form, so its size is
+    // known before the offsets it holds.
+    let top_dict_len = 5 * 4 + 3;
+    let top_index_len = 2 + 1 + 2 * 4 + top_dict_len;
+    let charset_offset = 4 + names.len() + top_index_len + strings.len() + global_subrs.len();
+    let charstrings_offset = charset_offset + charset.len();
+    let private_offset = charstrings_offset + charstrings.len();
+    let mut top_dict = Vec::new();
+    dict_offset(&mut top_dict, charset_offset);
+    top_dict.push(15);
+    dict_offset(&mut top_dict, charstrings_offset);
+    top_dict.push(17);
+    dict_offset(&mut top_dict, private.len());
+    dict_offset(&mut top_dict, private_offset);
+    top_dict.push(18);
+    let top = cff_index(&[top_dict]);
+    debug_assert_eq!(top.len(), top_index_len);
+
+    let mut font = vec![1, 0, 4, 4];
+    for part in [
+        names,
+        top,
+        strings,
+        global_subrs,
+        charset,
+        charstrings,
+        private,
+    ] {
+        font.extend(part);
+    }
+    font
+}
+
+fn cff_index(items: &[Vec<u8>]) -> Vec<u8> {
+    let mut out = Vec::new();
+    out.u16(items.len() as u16);
+    if items.is_empty() {
+        return out;
+    }
+    out.push(4);
+    let mut offset = 1u32;
+    out.u32(offset);
+    for item in items {
+        offset += item.len() as u32;
+        out.u32(offset);
+    }
+    for item in items {
+        out.extend_from_slice(item);
+    }
+    out
+}
+
+fn dict_int(out: &mut Vec<u8>, v: i32) {
+    match v {
+        -107..=107 => out.push((v + 139) as u8),
+        _ => {
+            out.push(28);
+            out.i16(v as i16);
+        }
+    }
+}
+
+fn dict_offset(out: &mut Vec<u8>, v: usize) {
+    out.push(29);
+    out.u32(v as u32);
+}
+
+/// Type 2 charstring drawing `glyph`'s quadratic segments as cubics.
+fn charstring(glyph: &Glyph) -> Vec<u8> {
+    let mut out = Vec::new();
+    charstring_int(&mut out, i32::from(glyph.advance));
+    let mut current = (0i32, 0i32);
+    for contour in &glyph.contours {
+        let point = |i: usize| {
+            let (x, y) = contour[i % contour.len()];
+            (i32::from(x), i32::from(y))
+        };
+        let start = point(0);
+        charstring_int(&mut out, start.0 - current.0);
+        charstring_int(&mut out, start.1 - current.1);
+        out.push(21); // rmoveto
+        current = start;
+        for i in (0..contour.len()).step_by(2) {
+            let (p0, c, p1) = (point(i), point(i + 1), point(i + 2));
+            let c1 = (p0.0 + (c.0 - p0.0) * 2 / 3, p0.1 + (c.1 - p0.1) * 2 / 3);
+            let c2 = (p1.0 + (c.0 - p1.0) * 2 / 3, p1.1 + (c.1 - p1.1) * 2 / 3);
+            for next in [c1, c2, p1] {
+                charstring_int(&mut out, next.0 - current.0);
+                charstring_int(&mut out, next.1 - current.1);
+                current = next;
+            }
+            out.push(8); // rrcurveto
+        }
+    }
+    out.push(14); // endchar
+    out
+}
+
+fn charstring_int(out: &mut Vec<u8>, v: i32) {
+    match v {
+        -107..=107 => out.push((v + 139) as u8),
+        108..=1131 => {
+            let v = v - 108;
+            out.push((v >> 8) as u8 + 247);
+            out.push(v as u8);
+        }
+        -1131..=-108 => {
+            let v = -v - 108;
+            out.push((v >> 8) as u8 + 251);
+            out.push(v as u8);
+        }
+        _ => {
+            out.push(28);
+            out.i16(v as i16);
+        }
+    }
+}
@@ -0,0 +1,384 @@
+//! Deterministic PDFs for the benchmarks, generated with lopdf on first use
+//! so every machine measures the same documents.
+#![allow(dead_code)]
+
+mod fonts;
+
+use lopdf::content::{Content, Operation};
+use lopdf::{Dictionary, Document, Object, Stream, dictionary};
+use std::path::PathBuf;
+
+/// Bump when a generator changes, so stale files in the temp dir are ignored.
+const VERSION: u32 = 2;
+const PAGE_WIDTH: f32 = 612.0;
+const PAGE_HEIGHT: f32 = 792.0;
+/// Word the text generators plant on every seventh line, for search benches.
+pub const NEEDLE: &str = "invoice";
+
+/// Embedded faces `Corpus::FontHeavy` cycles through, line by line.
+const EMBEDDED_FACES: usize = 12;
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Corpus {
+    /// Hundreds of pages of running text.
+    Large,
+    /// Every line in a different embedded TrueType or CFF font and size.
+    FontHeavy,
+    /// Several full-colour photos per page.
+    ImageHeavy,
+    /// Thousands of stroked and filled curves per page.
+    VectorHeavy,
+    /// Ruled grids of cells, for table detection.
+    Tables,
+}
+
+pub const ALL: [Corpus; 5] = [
+    Corpus::Large,
+    Corpus::FontHeavy,
+    Corpus::ImageHeavy,
+    Corpus::VectorHeavy,
+    Corpus::Tables,
+];
+
+impl std::fmt::Display for Corpus {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.write_str(self.name())
+    }
+}
+
+impl Corpus {
+    fn name(self) -> &'static str {
+        match self {
+            Self::Large => "large",
+            Self::FontHeavy => "font_heavy",
+            Self::ImageHeavy => "image_heavy",
+            Self::VectorHeavy => "vector_heavy",
+            Self::Tables => "tables",
+        }
+    }
+
+    pub fn page_count(self) -> usize {
+        match self {
+            Self::Large => 400,
+            Self::FontHeavy => 20,
+            Self::ImageHeavy => 8,
+            Self::VectorHeavy => 10,
+            Self::Tables => 10,
+        }
+    }
+
+    /// Path of the generated file, writing it first if it is missing.
+    pub fn path(self) -> PathBuf {
+        let dir = std::env::temp_dir().join("pdfbull_bench_corpus");
+        let path = dir.join(format!("{}-v{VERSION}.pdf", self.name()));
+        if !path.exists() {
+            std::fs::create_dir_all(&dir).expect("create corpus dir");
+            // Written aside and renamed, so parallel bench binaries never
+            // read a half-written file.
+            let tmp = dir.join(format!("{}-{}.tmp", self.name(), std::process::id()));
+            self.build().save(&tmp).expect("write corpus file");
+            std::fs::rename(&tmp, &path).expect("publish corpus file");
+        }
+        path
+    }
+
+    pub fn path_string(self) -> String {
+        self.path().to_string_lossy().into_owned()
+    }
+
+    fn build(self) -> Document {
+        let mut rng = Lcg((u64::from(VERSION) << 32) | self as u64);
+        let mut doc = Document::with_version("1.7");
+        let faces = match self {
+            Self::FontHeavy => fonts::embed_faces(&mut doc, EMBEDDED_FACES),
+            _ => vec![font("Helvetica")],
+        };
+        let pages = (0..self.page_count())
+            .map(|page| match self {
+                Self::Large | Self::FontHeavy => text_page(page, &mut rng, &faces),
+                Self::ImageHeavy => image_page(&mut rng),
+                Self::VectorHeavy => vector_page(&mut rng),
+                Self::Tables => table_page(page),
+            })
+            .collect();
+        assemble(doc, pages)
+    }
+}
+
+/// What one generated page draws: its content and its resources, with
+/// image XObjects still to be added to the document.
+struct PageSpec {
+    operations: Vec<Operation>,
+    fonts: Dictionary,
+    images: Vec<Stream>,
+}
+
+/// Adds `pages` to `doc`, which may already hold objects they reference.
+fn assemble(mut doc: Document, pages: Vec<PageSpec>) -> Document {
+    let pages_id = doc.new_object_id();
+    let mut kids: Vec<Object> = Vec::with_capacity(pages.len());
+    for spec in pages {
+        let mut xobjects = Dictionary::new();
+        for (i, image) in spec.images.into_iter().enumerate() {
+            xobjects.set(format!("Im{i}"), doc.add_object(image));
+        }
+        let content = Content {
+            operations: spec.operations,
+        }
+        .encode()
+        .expect("encode content");
+        let content_id = doc.add_object(Stream::new(Dictionary::new(), content));
+        let page_id = doc.add_object(dictionary! {
+            "Type" => "Page",
+            "Parent" => pages_id,
+            "Contents" => content_id,
+            "MediaBox" => vec![real(0.0), real(0.0), real(PAGE_WIDTH), real(PAGE_HEIGHT)],
+            "Resources" => dictionary! {
+                "Font" => spec.fonts,
+                "XObject" => xobjects,
+            },
+        });
+        kids.push(page_id.into());
+    }
+    let count = kids.len() as i64;
+    doc.objects.insert(
+        pages_id,
+        Object::Dictionary(dictionary! {
+            "Type" => "Pages",
+            "Kids" => kids,
+            "Count" => count,
+        }),
+    );
+    let catalog_id = doc.add_object(dictionary! {
+        "Type" => "Catalog",
+        "Pages" => pages_id,
+    });
+    doc.trailer.set("Root", catalog_id);
+    doc.compress();
+    doc
+}
+
+fn font(base: &str) -> Object {
+    Object::Dictionary(dictionary! {
+        "Type" => "Font",
+        "Subtype" => "Type1",
+        "BaseFont" => base,
+    })
+}
+
+fn op(operator: &str, operands: Vec<Object>) -> Operation {
+    Operation::new(operator, operands)
+}
+
+fn real(v: f32) -> Object {
+    Object::Real(v)
+}
+
+const WORDS: [&str; 16] = [
+    "the",
+    "quarterly",
+    "report",
+    "shows",
+    "revenue",
+    "growth",
+    "across",
+    "all",
+    "regions",
+    "with",
+    "margins",
+    "holding",
+    "steady",
+    "despite",
+    "rising",
+    "costs",
+];
+
+/// Fifty lines of text; with more than one font in `faces`, every line
+/// switches face and size.
+fn text_page(page: usize, rng: &mut Lcg, faces: &[Object]) -> PageSpec {
+    let mut fonts = Dictionary::new();
+    for (i, face) in faces.iter().enumerate() {
+        fonts.set(format!("F{i}"), face.clone());
+    }
+    let mixed_fonts = faces.len() > 1;
+
+    let mut operations = vec![
+        op("BT", vec![]),
+        op("Tf", vec!["F0".into(), real(10.0)]),
+        op("TL", vec![real(14.0)]),
+        op("Td", vec![real(50.0), real(PAGE_HEIGHT - 50.0)]),
+    ];
+    for line in 0..50 {
+        if mixed_fonts {
+            let size = 7.0 + rng.below(8) as f32;
+            let face = format!("F{}", line % faces.len());
+            operations.push(op("Tf", vec![Object::Name(face.into_bytes()), real(size)]));
+        }
+        let mut text: Vec<&str> = (0..12).map(|_| WORDS[rng.below(WORDS.len())]).collect();
+        if (page * 50 + line) % 7 == 0 {
+            text[3] = NEEDLE;
+        }
+        operations.push(op("Tj", vec![Object::string_literal(text.join(" "))]));
+        operations.push(op("T*", vec![]));
+    }
+    operations.push(op("ET", vec![]));
+    PageSpec {
+        operations,
+        fonts,
+        images: Vec::new(),
+    }
+}
+
+const IMAGE_SIZE: u32 = 512;
+
+fn image_page(rng: &mut Lcg) -> PageSpec {
+    let mut operations = Vec::new();
+    let mut images = Vec::new();
+    for i in 0..4 {
+        let mut pixels = Vec::with_capacity((IMAGE_SIZE * IMAGE_SIZE * 3) as usize);
+        let tint = rng.below(256) as u32;
+        for y in 0..IMAGE_SIZE {
+            for x in 0..IMAGE_SIZE {
+                // Smooth gradients with grain, roughly how photos compress.
+                let grain = rng.below(24) as u32;
+                pixels.push(((x + tint) / 2 + grain) as u8);
+                pixels.push(((y + tint) / 2 + grain) as u8);
+                pixels.push(((x + y) / 4 + grain) as u8);
+            }
+        }
+        images.push(Stream::new(
+            dictionary! {
+                "Type" => "XObject",
+                "Subtype" => "Image",
+                "Width" => i64::from(IMAGE_SIZE),
+                "Height" => i64::from(IMAGE_SIZE),
+                "ColorSpace" => "DeviceRGB",
+                "BitsPerComponent" => 8i64,
+            },
+            pixels,
+        ));
+        let x = 40.0 + (i % 2) as f32 * 276.0;
+        let y = 60.0 + (i / 2) as f32 * 356.0;
+        operations.extend([
+            op("q", vec![]),
+            op(
+                "cm",
+                vec![
+                    real(256.0),
+                    real(0.0),
+                    real(0.0),
+                    real(336.0),
+                    real(x),
+                    real(y),
+                ],
+            ),
+            op("Do", vec![Object::Name(format!("Im{i}").into_bytes())]),
+            op("Q", vec![]),
+        ]);
+    }
+    PageSpec {
+        operations,
+        fonts: Dictionary::new(),
+        images,
+    }
+}
+
+fn vector_page(rng: &mut Lcg) -> PageSpec {
+    let mut operations = Vec::new();
+    for i in 0..3000 {
+        let colour = |rng: &mut Lcg| real(rng.below(100) as f32 / 100.0);
+        let (r, g, b) = (colour(rng), colour(rng), colour(rng));
+        let at = |rng: &mut Lcg| {
+            [
+                real(rng.below(PAGE_WIDTH as usize) as f32),
+                real(rng.below(PAGE_HEIGHT as usize) as f32),
+            ]
+        };
+        let [x0, y0] = at(rng);
+        let [x1, y1] = at(rng);
+        let [x2, y2] = at(rng);
+        let [x3, y3] = at(rng);
+        operations.push(op("m", vec![x0, y0]));
+        operations.push(op("c", vec![x1, y1, x2, y2, x3, y3]));
+        if i % 3 == 0 {
+            operations.push(op("rg", vec![r, g, b]));
+            operations.push(op("f", vec![]));
+        } else {
+            operations.push(op("RG", vec![r, g, b]));
+            operations.push(op("w", vec![real(0.5 + rng.below(4) as f32)]));
+            operations.push(op("S", vec![]));
+        }
+    }
+    PageSpec {
+        operations,
+        fonts: Dictionary::new(),
+        images: Vec::new(),
+    }
+}
+
+fn table_page(page: usize) -> PageSpec {
+    const ROWS: usize = 25;
+    const COLS: usize = 5;
+    const CELL_W: f32 = 100.0;
+    const CELL_H: f32 = 24.0;
+    let (left, top) = (56.0, PAGE_HEIGHT - 80.0);
+
+    let mut operations = vec![op("w", vec![real(0.75)])];
+    for row in 0..=ROWS {
+        let y = top - row as f32 * CELL_H;
+        operations.push(op("m", vec![real(left), real(y)]));
+        operations.push(op("l", vec![real(left + COLS as f32 * CELL_W), real(y)]));
+    }
+    for col in 0..=COLS {
+        let x = left + col as f32 * CELL_W;
+        operations.push(op("m", vec![real(x), real(top)]));
+        operations.push(op("l", vec![real(x), real(top - ROWS as f32 * CELL_H)]));
+    }
+    operations.push(op("S", vec![]));
+
+    operations.push(op("BT", vec![]));
+    operations.push(op("Tf", vec!["F0".into(), real(9.0)]));
+    for row in 0..ROWS {
+        for col in 0..COLS {
+            let x = left + col as f32 * CELL_W + 4.0;
+            let y = top - (row + 1) as f32 * CELL_H + 8.0;
+            let text = if row == 0 {
+                format!("Column {}", col + 1)
+            } else {
+                format!(
+                    "{}.{:02}",
+                    page * 1000 + row * COLS + col,
+                    (row * 7 + col) % 100
+                )
+            };
+            operations.push(op(
+                "Tm",
+                vec![real(1.0), real(0.0), real(0.0), real(1.0), real(x), real(y)],
+            ));
+            operations.push(op("Tj", vec![Object::string_literal(text)]));
+        }
+    }
+    operations.push(op("ET", vec![]));
+
+    let mut fonts = Dictionary::new();
+    fonts.set("F0", font("Helvetica"));
+    PageSpec {
+        operations,
+        fonts,
+        images: Vec::new(),
+    }
+}
+
+/// Small fixed-seed generator; the corpus must not depend on a crate's
+/// RNG algorithm staying the same across versions.
+struct Lcg(u64);
+
+impl Lcg {
+    fn below(&mut self, bound: usize) -> usize {
+        self.0 = self
+            .0
+            .wrapping_mul(6_364_136_223_846_793_005)
+            .wrapping_add(1_442_695_040_888_963_407);
+        ((self.0 >> 33) % bound as u64) as usize
+    }
+}
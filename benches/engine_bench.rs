@@ -0,0 +1,207 @@
+//! Benchmarks of the engine's hot paths through `DocumentStore`, over the
+//! generated corpus in `corpus.rs`. Cold cases rebuild their store in the
+//! untimed setup, so only the operation itself is measured.
+
+mod corpus;
+
+use corpus::Corpus;
+use divan::Bencher;
+use pdfbull::models::DocumentId;
+use pdfbull::pdf_engine::{
+    DocumentStore, RenderFilter, RenderOptions, RenderQuality, create_render_cache,
+};
+
+fn main() {
+    divan::main();
+}
+
+const DOC: DocumentId = DocumentId(1);
+
+/// A store with an empty in-memory cache and no disk tier, so results do not
+/// depend on what earlier runs left behind.
+fn store() -> DocumentStore {
+    DocumentStore::new(create_render_cache(200, 512, 0))
+}
+
+fn opened(corpus: Corpus) -> DocumentStore {
+    let mut store = store();
+    store
+        .open_document(&corpus.path_string(), None, DOC)
+        .expect("open corpus document");
+    store
+}
+
+fn options(scale: f32, quality: RenderQuality) -> RenderOptions {
+    RenderOptions {
+        scale,
+        rotation: 0,
+        filter: RenderFilter::None,
+        auto_crop: false,
+        quality,
+    }
+}
+
+#[divan::bench(args = corpus::ALL)]
+fn open_document(bencher: Bencher, corpus: Corpus) {
+    let path = corpus.path_string();
+    bencher
+        .with_inputs(store)
+        .bench_local_refs(|store| store.open_document(&path, None, DOC).unwrap());
+}
+
+#[divan::bench(args = corpus::ALL)]
+fn render_miss(bencher: Bencher, corpus: Corpus) {
+    bencher
+        .with_inputs(|| opened(corpus))
+        .bench_local_refs(|store| {
+            store
+                .render_page(DOC, 0, options(1.0, RenderQuality::Medium))
+                .unwrap()
+        });
+}
+
+#[divan::bench(args = [0.5, 1.0, 2.0, 4.0])]
+fn render_scale(bencher: Bencher, scale: f32) {
+    bencher
+        .with_inputs(|| opened(Corpus::VectorHeavy))
+        .bench_local_refs(|store| {
+            store
+                .render_page(DOC, 0, options(scale, RenderQuality::Medium))
+                .unwrap()
+        });
+}
+
+#[divan::bench(args = [RenderQuality::Low, RenderQuality::Medium, RenderQuality::High])]
+fn render_quality(bencher: Bencher, quality: RenderQuality) {
+    bencher
+        .with_inputs(|| opened(Corpus::FontHeavy))
+        .bench_local_refs(|store| store.render_page(DOC, 0, options(1.5, quality)).unwrap());
+}
+
+#[divan::bench]
+fn render_hit(bencher: Bencher) {
+    let mut store = opened(Corpus::Large);
+    store
+        .render_page(DOC, 0, options(1.0, RenderQuality::Medium))
+        .unwrap();
+    bencher.bench_local(|| {
+        store
+            .render_page(DOC, 0, options(1.0, RenderQuality::Medium))
+            .unwrap()
+    });
+}
+
+/// One page worth of pixels from the image-heavy corpus, with its size.
+fn rendered_page() -> (Vec<u8>, u32, u32) {
+    let mut store = opened(Corpus::ImageHeavy);
+    let page = store
+        .render_page(DOC, 0, options(1.5, RenderQuality::Medium))
+        .unwrap();
+    (page.data.to_vec(), page.width, page.height)
+}
+
+#[divan::bench(args = [
+    RenderFilter::Grayscale,
+    RenderFilter::Inverted,
+    RenderFilter::Eco,
+    RenderFilter::BlackWhite,
+    RenderFilter::Lighten,
+    RenderFilter::NoShadow,
+    RenderFilter::Sepia,
+])]
+fn apply_filter(bencher: Bencher, filter: RenderFilter) {
+    let (pixels, _, _) = rendered_page();
+    bencher
+        .with_inputs(|| pixels.clone())
+        .bench_local_refs(|data| DocumentStore::apply_filter(data, filter));
+}
+
+#[divan::bench]
+fn detect_content_bbox(bencher: Bencher) {
+    let (pixels, width, height) = rendered_page();
+    bencher.bench_local(|| DocumentStore::detect_content_bbox_parallel(&pixels, width, height));
+}
+
+/// A sidebar thumbnail box-filtered from a page render.
+#[divan::bench]
+fn downsample_thumbnail(bencher: Bencher) {
+    let (pixels, width, height) = rendered_page();
+    let (thumb_width, thumb_height) = (width / 8, height / 8);
+    bencher.bench_local(|| {
+        DocumentStore::downsample_box(&pixels, width, height, thumb_width, thumb_height)
+    });
+}
+
+/// First search of a document, which extracts the text of every page.
+#[divan::bench(sample_count = 10)]
+fn search_cold(bencher: Bencher) {
+    bencher
+        .with_inputs(|| opened(Corpus::Large))
+        .bench_local_refs(|store| store.search(DOC, corpus::NEEDLE).unwrap());
+}
+
+#[divan::bench]
+fn search_warm(bencher: Bencher) {
+    let store = opened(Corpus::Large);
+    store.search(DOC, corpus::NEEDLE).unwrap();
+    bencher.bench_local(|| store.search(DOC, corpus::NEEDLE).unwrap());
+}
+
+#[divan::bench(args = [Corpus::Large, Corpus::FontHeavy, Corpus::Tables])]
+fn extract_text_items(bencher: Bencher, corpus: Corpus) {
+    bencher
+        .with_inputs(|| opened(corpus))
+        .bench_local_refs(|store| store.extract_text_items(DOC, 0).unwrap());
+}
+
+#[divan::bench]
+fn detect_tables_on_page(bencher: Bencher) {
+    bencher
+        .with_inputs(|| opened(Corpus::Tables))
+        .bench_local_refs(|store| store.detect_tables_on_page(DOC, 0).unwrap());
+}
+
+/// A page reaching the screen in table mode: its render, then its text
+/// layer and tables, which the render's interpretation pass already found.
+#[divan::bench]
+fn render_with_overlays(bencher: Bencher) {
+    bencher
+        .with_inputs(|| opened(Corpus::Tables))
+        .bench_local_refs(|store| {
+            store
+                .render_page(DOC, 0, options(1.0, RenderQuality::Medium))
+                .unwrap();
+            store.page_overlays(DOC, vec![0], true, true)
+        });
+}
+
+#[divan::bench(sample_count = 10)]
+fn merge(bencher: Bencher) {
+    let inputs = vec![Corpus::Large.path_string(), Corpus::Tables.path_string()];
+    let output = std::env::temp_dir()
+        .join(format!("pdfbull_bench_merge_{}.pdf", std::process::id()))
+        .to_string_lossy()
+        .into_owned();
+    let store = store();
+    bencher.bench_local(|| {
+        store
+            .merge_documents(inputs.clone(), output.clone())
+            .unwrap()
+    });
+    let _ = std::fs::remove_file(&output);
+}
+
+#[divan::bench(sample_count = 10)]
+fn split(bencher: Bencher) {
+    let input = Corpus::Large.path_string();
+    let output = std::env::temp_dir().join(format!("pdfbull_bench_split_{}", std::process::id()));
+    std::fs::create_dir_all(&output).unwrap();
+    let output_dir = output.to_string_lossy().into_owned();
+    let store = store();
+    bencher.bench_local(|| {
+        store
+            .split_pdf(&input, vec![0, 99, 199, 399], output_dir.clone())
+            .unwrap()
+    });
+    let _ = std::fs::remove_dir_all(&output);
+}
@@ -1,4 +1,7 @@
-#![allow(unexpected_cfgs)]
+mod corpus;
+
+use corpus::Corpus;
+use divan::Bencher;
 use std::fs;
 #[cfg(feature = "gpu-render")]
 use zpdf::gpu::WgpuRenderer;
@@ -9,6 +12,63 @@ fn main() {
 }
 
 const PDF_PATH: &str = "tests/test_document.pdf";
+/// Map-like zoom, where vector pages are slowest on the CPU.
+const HIGH_ZOOM: f32 = 3.0;
+const BACKEND_CORPUS: [Corpus; 3] = [Corpus::VectorHeavy, Corpus::FontHeavy, Corpus::ImageHeavy];
+
+/// First page of a corpus document, interpreted once so the backends are
+/// compared on the same display list.
+struct PreparedPage {
+    list: zpdf::DisplayList,
+    fonts: zpdf::FontCache,
+    images: ImageCache,
+}
+
+fn prepare(corpus: Corpus) -> PreparedPage {
+    let data = fs::read(corpus.path()).expect("Failed to read corpus PDF");
+    let doc = PdfDocument::open(data).expect("Failed to open PDF");
+    let page = doc.page(0).expect("Failed to get page");
+    let mut fonts = doc.load_page_fonts(&page);
+    let mut images = ImageCache::new();
+    let content = doc
+        .page_content_bytes(&page)
+        .expect("Failed to get content");
+    let list = ContentInterpreter::new(page.effective_box())
+        .with_fonts(&mut fonts)
+        .with_document(doc.file(), &page.resources)
+        .with_images(&mut images)
+        .interpret(&content);
+    PreparedPage {
+        list,
+        fonts,
+        images,
+    }
+}
+
+#[divan::bench(args = BACKEND_CORPUS)]
+fn bench_rasterize_cpu(bencher: Bencher, corpus: Corpus) {
+    let page = prepare(corpus);
+    bencher.bench_local(|| {
+        CpuRenderer::new()
+            .with_fonts(&page.fonts)
+            .with_images(&page.images)
+            .render_display_list(&page.list, HIGH_ZOOM)
+            .expect("Failed to render")
+    });
+}
+
+#[cfg(feature = "gpu-render")]
+#[divan::bench(args = BACKEND_CORPUS)]
+fn bench_rasterize_gpu(bencher: Bencher, corpus: Corpus) {
+    let page = prepare(corpus);
+    bencher.bench_local(|| {
+        WgpuRenderer::new()
+            .with_fonts(&page.fonts)
+            .with_images(&page.images)
+            .render_display_list(&page.list, HIGH_ZOOM)
+            .expect("Failed to render")
+    });
+}
 
 #[divan::bench]
 fn bench_pdf_parse() {
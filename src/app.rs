@@ -40,6 +40,7 @@ pub mod icons {
 #[derive(Clone, Copy, Debug, PartialEq, Eq, Hash)]
 pub enum RenderTarget {
     Page(crate::models::DocumentId, usize),
+    Tiles(crate::models::DocumentId, usize),
     Thumbnail(crate::models::DocumentId, usize),
 }
 
@@ -55,9 +56,15 @@ pub struct PdfBullApp {
     pub is_fullscreen: bool,
     pub show_forms_sidebar: bool,
     pub show_metadata: bool,
+    pub show_metrics: bool,
+    pub metrics: Option<crate::metrics::MetricsSnapshot>,
     pub form_fields: Vec<crate::models::FormField>,
     pub search_query: String,
     pub search_pending: Option<String>,
+    pub search_generation: u64,
+    pub search_cancel: Option<std::sync::Arc<std::sync::atomic::AtomicBool>>,
+    /// Stops the running image export; a new export sets it for the previous one.
+    pub export_cancel: Option<std::sync::Arc<std::sync::atomic::AtomicBool>>,
     pub page_input: String,
     pub status_message: Option<String>,
     pub annotation_mode: Option<crate::models::PendingAnnotationKind>,
@@ -110,8 +117,13 @@ impl Default for PdfBullApp {
             is_fullscreen: false,
             show_forms_sidebar: false,
             show_metadata: false,
+            show_metrics: false,
+            metrics: None,
             form_fields: Vec::new(),
             search_query: String::new(),
+            search_generation: 0,
+            search_cancel: None,
+            export_cancel: None,
             search_pending: None,
             page_input: "1".to_string(),
             status_message: None,
@@ -180,16 +192,7 @@ impl PdfBullApp {
             open_tabs: self
                 .tabs
                 .iter()
-                .map(|t| {
-                    crate::models::SessionTabEntry::Detailed(crate::models::TabSession {
-                        path: t.path.to_string_lossy().to_string(),
-                        current_page: t.current_page,
-                        zoom: t.zoom,
-                        viewport_y: t.view_state.viewport_y,
-                        rotation: t.rotation,
-                        auto_crop: t.auto_crop,
-                    })
-                })
+                .map(|t| crate::models::SessionTabEntry::Detailed(t.session()))
                 .collect(),
             active_tab: self.active_tab,
         };
@@ -198,33 +201,163 @@ impl PdfBullApp {
         self.last_session_save = std::time::Instant::now();
     }
 
+    /// Recreates the saved tabs without opening their documents. Only the
+    /// active tab is opened now, painting from the disk cache while the
+    /// engine parses it; the others open when first focused.
+    pub fn restore_session(&mut self, session: crate::models::SessionData) -> Task<Message> {
+        for entry in session.open_tabs {
+            let (path, tab_session) = match entry {
+                crate::models::SessionTabEntry::Simple(path) => {
+                    (std::path::PathBuf::from(path), None)
+                }
+                crate::models::SessionTabEntry::Detailed(tab_session) => (
+                    std::path::PathBuf::from(&tab_session.path),
+                    Some(tab_session),
+                ),
+            };
+            if path.is_file() {
+                self.tabs.push(DocumentTab::restore(path, tab_session));
+            }
+        }
+        if self.tabs.is_empty() {
+            return Task::none();
+        }
+        self.active_tab = session.active_tab.min(self.tabs.len() - 1);
+        self.open_pending_tab()
+    }
+
+    /// Opens the active tab's document if it was restored without it.
+    pub fn open_pending_tab(&mut self) -> Task<Message> {
+        let Some(tab) = self.current_tab_mut() else {
+            return Task::none();
+        };
+        if !tab.restore_pending {
+            return Task::none();
+        }
+        tab.restore_pending = false;
+        tab.view_state.is_loading = true;
+        let (doc_id, path) = (tab.id, tab.path.clone());
+        let scroll = if tab.restored_layout {
+            crate::update::scroll_to_y(tab.view_state.viewport_y)
+        } else {
+            Task::none()
+        };
+        let previews = self.restored_previews();
+
+        let engine = self
+            .engine
+            .get_or_insert_with(|| crate::engine::spawn_engine_thread(&self.settings));
+        let open = crate::update::tabs::open_document(engine, &path, doc_id);
+        Task::batch([scroll, previews, open])
+    }
+
+    /// Visible pages of the active tab as saved in the disk cache by an
+    /// earlier run, shown as previews until the engine renders them.
+    fn restored_previews(&self) -> Task<Message> {
+        let Some(tab) = self.current_tab() else {
+            return Task::none();
+        };
+        if !tab.restored_layout || tab.auto_crop {
+            return Task::none();
+        }
+        let max_mb = self.settings.disk_cache_mb as u64;
+        let (doc_id, generation) = (tab.id, tab.generation);
+        let path = tab.path.to_string_lossy().to_string();
+        let options = crate::pdf_engine::RenderOptions {
+            scale: tab.zoom,
+            rotation: tab.rotation,
+            filter: tab.render_filter,
+            auto_crop: false,
+            quality: self.settings.render_quality,
+        };
+        Task::batch(tab.get_visible_pages().map(|page_idx| {
+            let (path, options) = (path.clone(), options.clone());
+            Task::perform(
+                async move {
+                    tokio::task::spawn_blocking(move || {
+                        crate::disk_cache::restored_render(max_mb, &path, page_idx, &options)
+                    })
+                    .await
+                    .ok()
+                    .flatten()
+                    // Nothing saved; the page waits for the engine's render.
+                    .ok_or(crate::models::PdfError::Cancelled)
+                },
+                move |result| Message::PagePreviewRendered(doc_id, generation, page_idx, result),
+            )
+        }))
+    }
+
     pub fn add_recent_file(&mut self, path: &std::path::Path) {
         crate::storage::add_recent_file(&mut self.recent_files, path);
     }
 
+    /// Holds resident memory to `settings.memory_budget_mb`, following
+    /// `memory::plan`: background tabs give up their bitmaps first, least
+    /// recently used first, then the engine cache shrinks, then the active
+    /// tab keeps only its viewport.
+    pub fn enforce_memory_budget(&mut self) {
+        let active_id = self.current_tab().map(|tab| tab.id);
+        if let Some(tab) = self.current_tab_mut() {
+            tab.view_state.last_active = Instant::now();
+        }
+        let usage = |tab: &DocumentTab| crate::memory::TabUsage {
+            id: tab.id,
+            view_bytes: tab.view_state.resident_bytes(),
+            document_bytes: tab.file_bytes,
+        };
+        let mut background: Vec<&DocumentTab> = self
+            .tabs
+            .iter()
+            .filter(|tab| Some(tab.id) != active_id)
+            .collect();
+        background.sort_by_key(|tab| tab.view_state.last_active);
+        let background: Vec<_> = background.into_iter().map(usage).collect();
+
+        let plan = crate::memory::plan(
+            self.settings.memory_budget_mb as u64 * 1024 * 1024,
+            crate::metrics::metrics().engine_bytes(),
+            self.current_tab().map(usage),
+            &background,
+            crate::memory::low_memory(),
+        );
+
+        for tab in &mut self.tabs {
+            if plan.release_tabs.contains(&tab.id) {
+                tab.view_state.release_resident();
+            }
+        }
+        if plan.trim_active
+            && let Some(tab) = self.current_tab_mut()
+        {
+            tab.trim_to_viewport();
+        }
+        if let (Some(target), Some(engine)) = (plan.engine_target, &self.engine) {
+            let cmd_tx = engine.cmd_tx.clone();
+            tokio::spawn(async move {
+                let _ = cmd_tx
+                    .send(crate::commands::PdfCommand::TrimMemory(active_id, target))
+                    .await;
+            });
+        }
+    }
+
     pub fn render_visible_pages(&mut self) -> Task<Message> {
-        let (
-            visible_pages,
-            visible_thumbnails,
-            doc_id,
-            zoom,
-            rotation,
-            filter,
-            auto_crop,
-            page_width,
-        ) = {
+        let (visible_pages, visible_thumbnails, doc_id, generation, page_width) = {
             let Some(tab) = self.current_tab_mut() else {
                 return Task::none();
             };
+            // A restored tab is drawn from its snapshot until the engine has
+            // the document.
+            if tab.restore_pending || tab.view_state.is_loading {
+                return Task::none();
+            }
             tab.update_visible_range();
             (
                 tab.get_visible_pages().into_iter().collect::<Vec<_>>(),
                 tab.get_visible_thumbnails(),
                 tab.id,
-                tab.zoom,
-                tab.rotation,
-                tab.render_filter,
-                tab.auto_crop,
+                tab.generation,
                 tab.page_width,
             )
         };
@@ -242,106 +375,93 @@ impl PdfBullApp {
         let quality = self.settings.render_quality;
 
         for page_idx in visible_pages {
-            let target = RenderTarget::Page(doc_id, page_idx);
-
-            let is_rendered = self
-                .current_tab()
-                .and_then(|tab| tab.view_state.rendered_pages.get(&page_idx))
-                .is_some_and(|&(s, _)| (s - zoom).abs() < 0.001);
-
-            if is_rendered || self.rendering_set.contains(&target) {
+            if let Some(task) = self.render_page_tiles(page_idx, quality, &cmd_tx) {
+                tasks.push(task);
                 continue;
             }
+            if let Some(task) = self.request_page_render(
+                page_idx,
+                crate::commands::JobPriority::Visible,
+                quality,
+                &cmd_tx,
+            ) {
+                tasks.push(task);
+            }
+        }
 
-            // Translate visual page index to actual source page via page_mapping.
-            let (actual_page, page_rotation) = if let Some(tab) = self.current_tab() {
-                let actual_page = tab.page_mapping.get(page_idx).copied().unwrap_or(page_idx);
-                let rot = tab
-                    .page_rotations
-                    .get(&actual_page)
-                    .copied()
-                    .unwrap_or(rotation);
-                (actual_page, rot)
-            } else {
-                (page_idx, rotation)
+        // Pages ahead in the scroll direction go to the back of the engine
+        // queue, so they only use workers the visible pages leave idle.
+        let budget = self.settings.prefetch_memory_mb * 1024 * 1024;
+        let prefetch = self
+            .current_tab()
+            .map(|tab| tab.prefetch_pages(budget))
+            .unwrap_or_default();
+        if let Some(tab) = self.current_tab_mut() {
+            tab.view_state.prefetch_range = match (prefetch.iter().min(), prefetch.iter().max()) {
+                (Some(&first), Some(&last)) => (first, last + 1),
+                _ => (0, 0),
             };
-
-            let options = crate::pdf_engine::RenderOptions {
-                scale: zoom,
-                rotation: page_rotation,
-                filter,
-                auto_crop,
+        }
+        for page_idx in prefetch {
+            if let Some(task) = self.request_page_render(
+                page_idx,
+                crate::commands::JobPriority::Prefetch,
                 quality,
-            };
-
-            self.rendering_set.insert(target);
-            let tx = cmd_tx.clone();
-            let doc_id_cloned = doc_id;
-            let current_scale = options.scale;
-            tasks.push(Task::perform(
-                async move {
-                    let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
-                    let _ = tx
-                        .send(crate::commands::PdfCommand::Render(
-                            doc_id_cloned,
-                            actual_page,
-                            options,
-                            resp_tx,
-                        ))
-                        .await;
-                    let res = resp_rx
-                        .await
-                        .unwrap_or_else(|_| Err(crate::models::PdfError::EngineDied));
-                    (page_idx, current_scale, res)
-                },
-                move |(page_idx, scale, res)| Message::PageRendered(doc_id, page_idx, scale, res),
-            ));
+                &cmd_tx,
+            ) {
+                tasks.push(task);
+            }
         }
 
         if self.show_sidebar {
-            for page_idx in visible_thumbnails {
-                let target = RenderTarget::Thumbnail(doc_id, page_idx);
-                let is_thumb_rendered = self
-                    .current_tab()
-                    .map(|tab| tab.view_state.thumbnails.contains_key(&page_idx))
-                    .unwrap_or(false);
-
-                if is_thumb_rendered || self.rendering_set.contains(&target) {
-                    continue;
-                }
-                let thumb_zoom = (120.0 / page_width.max(1.0)).min(5.0);
-
-                let (thumb_actual, thumb_rotation) = if let Some(tab) = self.current_tab() {
+            let thumb_zoom = (120.0 / page_width.max(1.0)).min(5.0);
+            let mut pending = Vec::new();
+            if let Some(tab) = self.current_tab() {
+                for page_idx in visible_thumbnails {
+                    let target = RenderTarget::Thumbnail(doc_id, page_idx);
+                    if tab.view_state.thumbnails.contains_key(&page_idx)
+                        || self.rendering_set.contains(&target)
+                    {
+                        continue;
+                    }
                     let actual_page = tab.page_mapping.get(page_idx).copied().unwrap_or(page_idx);
-                    let rot = tab.page_rotations.get(&actual_page).copied().unwrap_or(0);
-                    (actual_page, rot)
-                } else {
-                    (page_idx, 0)
-                };
+                    let rotation = tab.page_rotations.get(&actual_page).copied().unwrap_or(0);
+                    pending.push((page_idx, actual_page, rotation));
+                }
+            }
 
-                self.rendering_set.insert(target);
+            // Packed into a few low-priority jobs, so a sidebar full of
+            // thumbnails does not crowd out main-view renders.
+            for batch in pending.chunks(crate::commands::THUMBNAIL_BATCH) {
+                for &(page_idx, ..) in batch {
+                    self.rendering_set
+                        .insert(RenderTarget::Thumbnail(doc_id, page_idx));
+                }
+                let page_indices: Vec<usize> =
+                    batch.iter().map(|&(page_idx, ..)| page_idx).collect();
+                let pages = batch
+                    .iter()
+                    .map(|&(_, actual_page, rotation)| (actual_page, rotation))
+                    .collect();
                 let tx = cmd_tx.clone();
-                let doc_id_cloned = doc_id;
                 tasks.push(Task::perform(
                     async move {
                         let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
                         let _ = tx
-                            .send(crate::commands::PdfCommand::RenderThumbnail(
-                                doc_id_cloned,
-                                thumb_actual,
-                                thumb_zoom,
-                                thumb_rotation,
-                                resp_tx,
+                            .send(crate::commands::PdfCommand::RenderThumbnails(
+                                doc_id, pages, thumb_zoom, resp_tx,
                             ))
                             .await;
-                        let res = match resp_rx.await {
-                            Ok(result) => result,
-                            Err(_) => Err(crate::models::PdfError::EngineDied),
-                        };
-                        (page_idx, thumb_zoom, res)
+                        let results = resp_rx.await.unwrap_or_else(|_| {
+                            page_indices
+                                .iter()
+                                .map(|_| Err(crate::models::PdfError::EngineDied))
+                                .collect()
+                        });
+                        page_indices.into_iter().zip(results).collect::<Vec<_>>()
                     },
-                    move |(page_idx, scale, res)| {
-                        Message::ThumbnailRendered(doc_id, page_idx, scale, res)
+                    move |results| {
+                        Message::ThumbnailsRendered(doc_id, generation, thumb_zoom, results)
                     },
                 ));
             }
@@ -354,6 +474,158 @@ impl PdfBullApp {
         Task::batch(tasks)
     }
 
+    /// Requests a whole-page render of `page_idx` at the current zoom unless it
+    /// is already shown, in flight, or rendered as tiles.
+    fn request_page_render(
+        &mut self,
+        page_idx: usize,
+        priority: crate::commands::JobPriority,
+        quality: crate::pdf_engine::RenderQuality,
+        cmd_tx: &tokio::sync::mpsc::Sender<crate::commands::PdfCommand>,
+    ) -> Option<Task<Message>> {
+        let tab = self.current_tab()?;
+        let (doc_id, generation) = (tab.id, tab.generation);
+        let zoom = tab.zoom;
+        let target = RenderTarget::Page(doc_id, page_idx);
+
+        let is_rendered = tab
+            .view_state
+            .rendered_pages
+            .get(&page_idx)
+            .is_some_and(|&(s, _)| (s - zoom).abs() < 0.001);
+        if is_rendered || tab.uses_tiles(page_idx) || self.rendering_set.contains(&target) {
+            return None;
+        }
+
+        // Translate visual page index to actual source page via page_mapping.
+        let actual_page = tab.page_mapping.get(page_idx).copied().unwrap_or(page_idx);
+        let options = crate::pdf_engine::RenderOptions {
+            scale: zoom,
+            rotation: tab
+                .page_rotations
+                .get(&actual_page)
+                .copied()
+                .unwrap_or(tab.rotation),
+            filter: tab.render_filter,
+            auto_crop: tab.auto_crop,
+            quality,
+        };
+
+        // Only a page with nothing on screen yet benefits from a preview; a
+        // stale-zoom bitmap already stands in while re-rendering.
+        let wants_preview = self.settings.progressive_render
+            && priority == crate::commands::JobPriority::Visible
+            && !tab.view_state.rendered_pages.contains_key(&page_idx);
+        let (preview_tx, preview_rx) = if wants_preview {
+            let (tx, rx) = tokio::sync::oneshot::channel();
+            (Some(tx), Some(rx))
+        } else {
+            (None, None)
+        };
+
+        self.rendering_set.insert(target);
+        let tx = cmd_tx.clone();
+        let render = Task::perform(
+            async move {
+                let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
+                let _ = tx
+                    .send(crate::commands::PdfCommand::Render(
+                        doc_id,
+                        actual_page,
+                        options,
+                        priority,
+                        preview_tx,
+                        resp_tx,
+                    ))
+                    .await;
+                resp_rx
+                    .await
+                    .unwrap_or_else(|_| Err(crate::models::PdfError::EngineDied))
+            },
+            move |res| Message::PageRendered(doc_id, generation, page_idx, zoom, res),
+        );
+
+        Some(match preview_rx {
+            Some(rx) => Task::batch(vec![
+                Task::perform(
+                    async move { rx.await.unwrap_or(Err(crate::models::PdfError::Cancelled)) },
+                    move |res| Message::PagePreviewRendered(doc_id, generation, page_idx, res),
+                ),
+                render,
+            ]),
+            None => render,
+        })
+    }
+
+    /// Requests the on-screen tiles of a page that is too large to render
+    /// whole, skipping tiles already shown at the current zoom. Returns
+    /// `None` when the page is not tiled or nothing is missing.
+    fn render_page_tiles(
+        &mut self,
+        page_idx: usize,
+        quality: crate::pdf_engine::RenderQuality,
+        cmd_tx: &tokio::sync::mpsc::Sender<crate::commands::PdfCommand>,
+    ) -> Option<Task<Message>> {
+        let tab = self.current_tab()?;
+        if !tab.uses_tiles(page_idx) {
+            return None;
+        }
+        let (doc_id, generation) = (tab.id, tab.generation);
+        let target = RenderTarget::Tiles(doc_id, page_idx);
+        if self.rendering_set.contains(&target) {
+            return None;
+        }
+
+        let zoom = tab.zoom;
+        let missing: Vec<(u32, u32)> = tab
+            .visible_tiles(page_idx)
+            .into_iter()
+            .filter(|&(col, row)| {
+                tab.view_state
+                    .rendered_tiles
+                    .get(&(page_idx, col, row))
+                    .is_none_or(|&(s, _)| (s - zoom).abs() >= 0.001)
+            })
+            .collect();
+        if missing.is_empty() {
+            return None;
+        }
+
+        let actual_page = tab.page_mapping.get(page_idx).copied().unwrap_or(page_idx);
+        let options = crate::pdf_engine::RenderOptions {
+            scale: zoom,
+            rotation: tab
+                .page_rotations
+                .get(&actual_page)
+                .copied()
+                .unwrap_or(tab.rotation),
+            filter: tab.render_filter,
+            auto_crop: false,
+            quality,
+        };
+
+        self.rendering_set.insert(target);
+        let tx = cmd_tx.clone();
+        Some(Task::perform(
+            async move {
+                let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
+                let _ = tx
+                    .send(crate::commands::PdfCommand::RenderTiles(
+                        doc_id,
+                        actual_page,
+                        options,
+                        missing,
+                        resp_tx,
+                    ))
+                    .await;
+                resp_rx
+                    .await
+                    .unwrap_or_else(|_| Err(crate::models::PdfError::EngineDied))
+            },
+            move |res| Message::TilesRendered(doc_id, generation, page_idx, zoom, res),
+        ))
+    }
+
     pub fn update(&mut self, message: Message) -> Task<Message> {
         let old_status = self.status_message.clone();
         let task = handle_message(self, message);
@@ -460,9 +732,19 @@ impl PdfBullApp {
             )
         });
 
+        let memory_sub =
+            iced::time::every(crate::memory::CHECK_INTERVAL).map(|_| Message::CheckMemory);
+        let mut subscriptions = vec![events, ipc_sub, memory_sub];
+        if self.show_metrics {
+            subscriptions.push(
+                iced::time::every(std::time::Duration::from_secs(1))
+                    .map(|_| Message::RefreshMetrics),
+            );
+        }
+
         let paths: Vec<std::path::PathBuf> = self.tabs.iter().map(|t| t.path.clone()).collect();
         if paths.is_empty() {
-            return iced::Subscription::batch(vec![events, ipc_sub]);
+            return iced::Subscription::batch(subscriptions);
         }
 
         let watch_sub = iced::Subscription::run_with(("file-watch", paths), |(_id, paths)| {
@@ -509,6 +791,7 @@ impl PdfBullApp {
             )
         });
 
-        iced::Subscription::batch(vec![events, watch_sub, ipc_sub])
+        subscriptions.push(watch_sub);
+        iced::Subscription::batch(subscriptions)
     }
 }
@@ -1,10 +1,42 @@
 use crate::models::{
-    Annotation, DetectedTable, DocumentId, DocumentMeta, FormField, OpenResult, PdfResult,
-    RenderResult, SearchResultItem, TextItem,
+    Annotation, DocumentId, DocumentMeta, ExportProgress, FormField, OpenResult, PageOverlay,
+    PdfError, PdfResult, ReloadResult, RenderResult, RenderTile, SearchResultItem,
 };
 use crate::pdf_engine::RenderOptions;
+use std::sync::Arc;
+use std::sync::atomic::AtomicBool;
 use tokio::sync::oneshot;
 
+/// Receives search hits a batch at a time; the stream ends when the search finishes.
+pub type SearchBatchSender =
+    iced::futures::channel::mpsc::UnboundedSender<PdfResult<Vec<SearchResultItem>>>;
+
+/// Receives one update per exported page; the stream ends when the export finishes.
+pub type ExportProgressSender =
+    iced::futures::channel::mpsc::UnboundedSender<PdfResult<ExportProgress>>;
+
+/// Thumbnails packed into one `RenderThumbnails` request: enough that a
+/// sidebar full of them is a handful of queued jobs, few enough that the
+/// first ones are not held back long by the rest.
+pub const THUMBNAIL_BATCH: usize = 8;
+
+/// Scheduling class of an engine command; workers always take the most
+/// urgent queued class first.
+#[derive(Clone, Copy, Debug, PartialEq, Eq, PartialOrd, Ord, Hash)]
+pub enum JobPriority {
+    /// On-screen pages and anything else the user is waiting on.
+    Visible,
+    /// Pages just outside the viewport.
+    Prefetch,
+    Thumbnail,
+    /// Exports, document operations and background indexing.
+    Background,
+}
+
+impl JobPriority {
+    pub const COUNT: usize = 4;
+}
+
 #[derive(Debug)]
 pub enum PdfCommand {
     Open(
@@ -13,28 +45,52 @@ pub enum PdfCommand {
         DocumentId,
         oneshot::Sender<PdfResult<OpenResult>>,
     ),
+    /// The optional sender receives a quick low-resolution preview before
+    /// the full render, when the page is not already cached at full quality.
     Render(
         DocumentId,
         usize,
         RenderOptions,
+        JobPriority,
+        Option<oneshot::Sender<PdfResult<RenderResult>>>,
         oneshot::Sender<PdfResult<RenderResult>>,
     ),
-    RenderThumbnail(
+    RenderTiles(
         DocumentId,
         usize,
+        RenderOptions,
+        Vec<(u32, u32)>,
+        oneshot::Sender<PdfResult<Vec<RenderTile>>>,
+    ),
+    /// Sidebar thumbnails of several `(page, rotation)` pairs at one scale,
+    /// answered together in the same order.
+    RenderThumbnails(
+        DocumentId,
+        Vec<(usize, i32)>,
         f32,
-        i32,
-        oneshot::Sender<PdfResult<RenderResult>>,
+        oneshot::Sender<Vec<PdfResult<RenderResult>>>,
     ),
     Close(DocumentId),
+    /// Re-reads a document that changed on disk under the same id; queued
+    /// renders of it are cancelled, since their pages may be stale.
+    Reload(DocumentId, oneshot::Sender<PdfResult<ReloadResult>>),
+    /// Source pages still near the viewport; queued main-view renders of any
+    /// other page of the document are cancelled. Handled by the scheduler.
+    SetViewport(DocumentId, Vec<usize>),
     ExtractText(DocumentId, usize, oneshot::Sender<PdfResult<String>>),
-    GetTextItems(DocumentId, usize, oneshot::Sender<PdfResult<Vec<TextItem>>>),
-    LoadDocumentMeta(DocumentId, oneshot::Sender<PdfResult<DocumentMeta>>),
-    Search(
+    /// Text layers and/or table candidates of several pages, answered
+    /// together in the same order. Pages the render path already
+    /// interpreted are served without another pass over their content.
+    GetPageOverlays(
         DocumentId,
-        String,
-        oneshot::Sender<PdfResult<Vec<SearchResultItem>>>,
+        Vec<usize>,
+        bool,
+        bool,
+        oneshot::Sender<Vec<PageOverlay>>,
     ),
+    LoadDocumentMeta(DocumentId, oneshot::Sender<PdfResult<DocumentMeta>>),
+    BuildTextIndex(DocumentId, bool),
+    Search(DocumentId, String, Arc<AtomicBool>, SearchBatchSender),
     SaveAnnotations(
         DocumentId,
         Vec<Annotation>,
@@ -46,12 +102,16 @@ pub enum PdfCommand {
         oneshot::Sender<PdfResult<Vec<Annotation>>>,
     ),
     ExportImage(DocumentId, usize, f32, oneshot::Sender<PdfResult<Vec<u8>>>),
+    /// Pages, scale, output directory, oxipng preset (0 skips optimization)
+    /// and a flag that stops the export when set.
     ExportImages(
         DocumentId,
         Vec<usize>,
         f32,
         String,
-        oneshot::Sender<PdfResult<Vec<String>>>,
+        u8,
+        Arc<AtomicBool>,
+        ExportProgressSender,
     ),
     ExportPdf(
         DocumentId,
@@ -77,7 +137,12 @@ pub enum PdfCommand {
     PrintPdf(String, Option<String>, oneshot::Sender<PdfResult<()>>),
     ListPrinters(oneshot::Sender<PdfResult<Vec<String>>>),
     AddWatermark(String, String, String, oneshot::Sender<PdfResult<String>>),
-    Optimize(String, String, oneshot::Sender<PdfResult<String>>),
+    Optimize(
+        String,
+        String,
+        crate::optimize::OptimizeOptions,
+        oneshot::Sender<PdfResult<crate::optimize::OptimizeReport>>,
+    ),
     ReorderPages(
         String,
         Vec<usize>,
@@ -86,9 +151,116 @@ pub enum PdfCommand {
     ),
     ToggleLayer(DocumentId, (u32, u16), bool),
     GetAttachmentBytes(DocumentId, (u32, u16), oneshot::Sender<PdfResult<Vec<u8>>>),
-    DetectTables(
-        DocumentId,
-        usize,
-        oneshot::Sender<PdfResult<Vec<DetectedTable>>>,
-    ),
+    CollectMetrics(oneshot::Sender<crate::metrics::MetricsSnapshot>),
+    /// Shrinks the render cache toward a byte target, keeping the given
+    /// document's renders longest.
+    TrimMemory(Option<DocumentId>, u64),
+}
+
+impl PdfCommand {
+    /// Label under which the command's handling time is recorded.
+    pub const fn name(&self) -> &'static str {
+        match self {
+            Self::Open(..) => "open",
+            Self::Render(..) => "render",
+            Self::RenderTiles(..) => "render_tiles",
+            Self::RenderThumbnails(..) => "render_thumbnails",
+            Self::Close(..) => "close",
+            Self::Reload(..) => "reload",
+            Self::SetViewport(..) => "set_viewport",
+            Self::ExtractText(..) => "extract_text",
+            Self::GetPageOverlays(..) => "get_page_overlays",
+            Self::LoadDocumentMeta(..) => "load_document_meta",
+            Self::BuildTextIndex(..) => "build_text_index",
+            Self::Search(..) => "search",
+            Self::SaveAnnotations(..) => "save_annotations",
+            Self::LoadAnnotations(..) => "load_annotations",
+            Self::ExportImage(..) => "export_image",
+            Self::ExportImages(..) => "export_images",
+            Self::ExportPdf(..) => "export_pdf",
+            Self::Merge(..) => "merge",
+            Self::Split(..) => "split",
+            Self::GetFormFields(..) => "get_form_fields",
+            Self::FillForm(..) => "fill_form",
+            Self::PrintPdf(..) => "print_pdf",
+            Self::ListPrinters(..) => "list_printers",
+            Self::AddWatermark(..) => "add_watermark",
+            Self::Optimize(..) => "optimize",
+            Self::ReorderPages(..) => "reorder_pages",
+            Self::ToggleLayer(..) => "toggle_layer",
+            Self::GetAttachmentBytes(..) => "get_attachment_bytes",
+            Self::CollectMetrics(..) => "collect_metrics",
+            Self::TrimMemory(..) => "trim_memory",
+        }
+    }
+
+    pub fn priority(&self) -> JobPriority {
+        match self {
+            Self::Render(_, _, _, priority, ..) => *priority,
+            Self::RenderThumbnails(..) => JobPriority::Thumbnail,
+            Self::BuildTextIndex(..)
+            | Self::ExportImage(..)
+            | Self::ExportImages(..)
+            | Self::ExportPdf(..)
+            | Self::Merge(..)
+            | Self::Split(..)
+            | Self::FillForm(..)
+            | Self::PrintPdf(..)
+            | Self::AddWatermark(..)
+            | Self::Optimize(..)
+            | Self::ReorderPages(..) => JobPriority::Background,
+            _ => JobPriority::Visible,
+        }
+    }
+
+    /// Long-running document operations, run on the engine's heavy lane so
+    /// they can only ever wait on each other, not on or for renders.
+    pub fn is_heavy(&self) -> bool {
+        matches!(
+            self,
+            Self::BuildTextIndex(..)
+                | Self::ExportImage(..)
+                | Self::ExportImages(..)
+                | Self::ExportPdf(..)
+                | Self::Merge(..)
+                | Self::Split(..)
+                | Self::FillForm(..)
+                | Self::PrintPdf(..)
+                | Self::AddWatermark(..)
+                | Self::Optimize(..)
+                | Self::ReorderPages(..)
+        )
+    }
+
+    /// Document and source page of a queued page render, if this is one;
+    /// the first page for a thumbnail batch. `viewport_only` limits it to
+    /// main-view renders that scrolling can make stale.
+    pub fn render_target(&self, viewport_only: bool) -> Option<(DocumentId, usize)> {
+        match self {
+            Self::Render(doc_id, page, _, JobPriority::Visible | JobPriority::Prefetch, ..)
+            | Self::RenderTiles(doc_id, page, ..) => Some((*doc_id, *page)),
+            Self::Render(doc_id, page, ..) if !viewport_only => Some((*doc_id, *page)),
+            Self::RenderThumbnails(doc_id, pages, ..) if !viewport_only => {
+                pages.first().map(|&(page, _)| (*doc_id, page))
+            }
+            _ => None,
+        }
+    }
+
+    /// Drops a queued command, answering `Cancelled` so the caller can tell
+    /// it apart from a dead engine.
+    pub fn cancel(self) {
+        match self {
+            Self::Render(.., tx) => {
+                let _ = tx.send(Err(PdfError::Cancelled));
+            }
+            Self::RenderThumbnails(_, pages, _, tx) => {
+                let _ = tx.send(pages.iter().map(|_| Err(PdfError::Cancelled)).collect());
+            }
+            Self::RenderTiles(.., tx) => {
+                let _ = tx.send(Err(PdfError::Cancelled));
+            }
+            _ => {}
+        }
+    }
 }
@@ -0,0 +1,276 @@
+//! On-disk tier behind `RenderCache` for thumbnails and modest page renders,
+//! so a restored session paints from disk instead of re-rendering.
+
+use crate::models::{DocumentId, RenderResult};
+use crate::pdf_engine::{RenderFilter, RenderKey, RenderOptions};
+use image::ImageEncoder;
+use image::codecs::png::{CompressionType, FilterType, PngEncoder};
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::SystemTime;
+
+/// Fraction of the budget kept after a trim, so every write past the limit
+/// does not trigger another directory scan.
+const TRIM_TARGET_PERCENT: u64 = 90;
+const ENTRY_EXTENSION: &str = "png";
+
+/// PNG-compressed bitmaps keyed by file fingerprint and render parameters,
+/// evicted least recently used first once `max_bytes` is exceeded. Reads
+/// touch an entry's mtime, which is what the eviction order follows.
+pub struct DiskCache {
+    dir: PathBuf,
+    max_bytes: u64,
+    /// Bytes on disk; `None` until the first write scans the directory.
+    used: Mutex<Option<u64>>,
+}
+
+impl DiskCache {
+    pub fn new(dir: PathBuf, max_bytes: u64) -> Self {
+        Self {
+            dir,
+            max_bytes,
+            used: Mutex::new(None),
+        }
+    }
+
+    /// The cache under the config dir, or `None` when `max_mb` is 0.
+    pub fn in_config_dir(max_mb: u64) -> Option<Self> {
+        (max_mb > 0).then(|| {
+            Self::new(
+                crate::storage::get_config_dir().join("render_cache"),
+                max_mb * 1024 * 1024,
+            )
+        })
+    }
+
+    fn entry_path(&self, fingerprint: u64, key: &RenderKey) -> PathBuf {
+        self.dir.join(format!(
+            "{fingerprint:016x}-{}-{}-{}-{:?}-{}.{ENTRY_EXTENSION}",
+            key.page_num,
+            key.scale,
+            key.rotation.rem_euclid(360),
+            key.quality,
+            u8::from(key.auto_crop),
+        ))
+    }
+
+    pub fn get(&self, fingerprint: u64, key: &RenderKey) -> Option<RenderResult> {
+        let path = self.entry_path(fingerprint, key);
+        let data = std::fs::read(&path).ok()?;
+        let decoded = match image::load_from_memory_with_format(&data, image::ImageFormat::Png) {
+            Ok(img) => img.into_rgba8(),
+            Err(e) => {
+                tracing::warn!("Discarding unreadable cached render {:?}: {}", path, e);
+                let _ = std::fs::remove_file(&path);
+                return None;
+            }
+        };
+        if let Ok(file) = std::fs::File::options().write(true).open(&path) {
+            let _ = file.set_modified(SystemTime::now());
+        }
+        Some(RenderResult {
+            width: decoded.width(),
+            height: decoded.height(),
+            data: decoded.into_raw().into(),
+        })
+    }
+
+    pub fn put(&self, fingerprint: u64, key: &RenderKey, result: &RenderResult) {
+        let path = self.entry_path(fingerprint, key);
+        let mut encoded = Vec::new();
+        let encoder =
+            PngEncoder::new_with_quality(&mut encoded, CompressionType::Fast, FilterType::Adaptive);
+        if let Err(e) = encoder.write_image(
+            &result.data,
+            result.width,
+            result.height,
+            image::ExtendedColorType::Rgba8,
+        ) {
+            tracing::warn!("Failed to encode render for disk cache: {}", e);
+            return;
+        }
+        if let Err(e) = write_atomically(&path, &encoded) {
+            tracing::warn!("Failed to write disk cache entry {:?}: {}", path, e);
+            return;
+        }
+
+        let Ok(mut used) = self.used.lock() else {
+            return;
+        };
+        let total =
+            used.unwrap_or_else(|| self.scan().iter().map(|e| e.1).sum()) + encoded.len() as u64;
+        *used = Some(if total > self.max_bytes {
+            self.trim()
+        } else {
+            total
+        });
+    }
+
+    /// `(path, size, mtime)` of every entry.
+    fn scan(&self) -> Vec<(PathBuf, u64, SystemTime)> {
+        let Ok(dir) = std::fs::read_dir(&self.dir) else {
+            return Vec::new();
+        };
+        dir.filter_map(Result::ok)
+            .filter(|entry| {
+                entry
+                    .path()
+                    .extension()
+                    .is_some_and(|ext| ext == ENTRY_EXTENSION)
+            })
+            .filter_map(|entry| {
+                let meta = entry.metadata().ok()?;
+                Some((entry.path(), meta.len(), meta.modified().ok()?))
+            })
+            .collect()
+    }
+
+    /// Deletes least recently used entries down to the trim target and
+    /// returns the bytes left.
+    fn trim(&self) -> u64 {
+        let mut entries = self.scan();
+        entries.sort_by_key(|e| e.2);
+        let mut total: u64 = entries.iter().map(|e| e.1).sum();
+        let target = self.max_bytes / 100 * TRIM_TARGET_PERCENT;
+        for (path, size, _) in entries {
+            if total <= target {
+                break;
+            }
+            if std::fs::remove_file(&path).is_ok() {
+                total -= size;
+            }
+        }
+        total
+    }
+}
+
+/// A page render saved by an earlier run, found from the file's path alone,
+/// so a restored tab can paint before its document is parsed. Entries are
+/// saved unfiltered; `options.filter` is applied to the copy returned.
+pub fn restored_render(
+    max_mb: u64,
+    pdf_path: &str,
+    page_num: usize,
+    options: &RenderOptions,
+) -> Option<RenderResult> {
+    let cache = DiskCache::in_config_dir(max_mb)?;
+    let fingerprint = crate::text_index::file_fingerprint(pdf_path)?;
+    // Entries are named without the document id or layer state.
+    let key = RenderKey {
+        doc_id: DocumentId(0),
+        page_num,
+        rotation: options.rotation,
+        scale: (options.scale * 100.0).round() as u32,
+        auto_crop: options.auto_crop,
+        quality: options.quality,
+        tile: None,
+        filter: RenderFilter::None,
+        oc_state: 0,
+        generation: 0,
+    };
+    let mut result = cache.get(fingerprint, &key)?;
+    if options.filter != RenderFilter::None {
+        let mut data = result.data.to_vec();
+        crate::pdf_engine::DocumentStore::apply_filter(&mut data, options.filter);
+        result.data = data.into();
+    }
+    Some(result)
+}
+
+/// Writes through a temporary file so a reader never sees a partial entry.
+/// The temporary name is unique per process and write, so concurrent
+/// writers of the same key never share one.
+fn write_atomically(path: &Path, data: &[u8]) -> std::io::Result<()> {
+    static NEXT_TMP: AtomicU64 = AtomicU64::new(0);
+    if let Some(parent) = path.parent() {
+        std::fs::create_dir_all(parent)?;
+    }
+    let tmp = path.with_extension(format!(
+        "{}.{}.tmp",
+        std::process::id(),
+        NEXT_TMP.fetch_add(1, Ordering::Relaxed)
+    ));
+    let result = std::fs::write(&tmp, data).and_then(|()| std::fs::rename(&tmp, path));
+    if result.is_err() {
+        let _ = std::fs::remove_file(&tmp);
+    }
+    result
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::models::DocumentId;
+    use crate::pdf_engine::{RenderFilter, RenderQuality};
+
+    fn key(page_num: usize) -> RenderKey {
+        RenderKey {
+            doc_id: DocumentId(1),
+            page_num,
+            rotation: 0,
+            scale: 20,
+            auto_crop: false,
+            quality: RenderQuality::Low,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
+        }
+    }
+
+    fn bitmap(seed: u8) -> RenderResult {
+        let data: Vec<u8> = (0..64 * 64 * 4)
+            .map(|i| (i as u8).wrapping_mul(seed))
+            .collect();
+        RenderResult {
+            width: 64,
+            height: 64,
+            data: data.into(),
+        }
+    }
+
+    fn temp_dir(name: &str) -> PathBuf {
+        std::env::temp_dir().join(format!("pdfbull_{name}_{}", std::process::id()))
+    }
+
+    #[test]
+    fn test_disk_cache_roundtrip() {
+        let dir = temp_dir("disk_cache_roundtrip");
+        let cache = DiskCache::new(dir.clone(), 1024 * 1024);
+
+        assert!(cache.get(7, &key(0)).is_none());
+        cache.put(7, &key(0), &bitmap(3));
+        assert_eq!(cache.get(7, &key(0)), Some(bitmap(3)));
+        assert!(cache.get(8, &key(0)).is_none(), "other file fingerprint");
+        assert!(cache.get(7, &key(1)).is_none(), "other page");
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_disk_cache_evicts_least_recently_used() {
+        let dir = temp_dir("disk_cache_lru");
+        let probe = DiskCache::new(dir.clone(), u64::MAX);
+        probe.put(1, &key(0), &bitmap(3));
+        let entry_size = std::fs::metadata(probe.entry_path(1, &key(0)))
+            .unwrap()
+            .len();
+        let _ = std::fs::remove_dir_all(&dir);
+
+        let cache = DiskCache::new(dir.clone(), entry_size * 5 / 2);
+        cache.put(1, &key(0), &bitmap(3));
+        std::thread::sleep(std::time::Duration::from_millis(20));
+        cache.put(1, &key(1), &bitmap(3));
+        std::thread::sleep(std::time::Duration::from_millis(20));
+        assert!(cache.get(1, &key(0)).is_some());
+        std::thread::sleep(std::time::Duration::from_millis(20));
+        cache.put(1, &key(2), &bitmap(3));
+
+        assert!(cache.get(1, &key(0)).is_some(), "recently read entry kept");
+        assert!(cache.get(1, &key(1)).is_none(), "oldest entry evicted");
+        assert!(cache.get(1, &key(2)).is_some());
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -0,0 +1,514 @@
+//! Merge, split and reorder through a writer that serializes each object to
+//! the output file as it is copied, instead of assembling the result as one
+//! `lopdf::Document` and saving it at the end. Only objects reachable from
+//! the copied pages are written, and the page tree is rebuilt flat.
+//!
+//! lopdf has no lazy object reader, so every input is still parsed whole:
+//! merge holds one input at a time, and split shares a single parse across
+//! outputs written in parallel. `pdf_writer` builds its output in one
+//! buffer, hence the small serializer here.
+
+use crate::models::{PdfError, PdfResult};
+use lopdf::{Dictionary, Document, Object, ObjectId, StringFormat};
+use rayon::prelude::*;
+use std::collections::{BTreeMap, HashMap, HashSet};
+use std::fs::File;
+use std::io::{self, BufWriter, Write};
+
+type Objects = BTreeMap<ObjectId, Object>;
+
+/// Page attributes a page takes from its ancestors when it lacks them.
+const INHERITED_KEYS: [&[u8]; 4] = [b"Resources", b"MediaBox", b"CropBox", b"Rotate"];
+/// Bounds the walk up the page tree for inherited attributes.
+const MAX_TREE_DEPTH: usize = 64;
+/// Catalog entries rewritten for every output rather than copied.
+const REBUILT_CATALOG_KEYS: [&[u8]; 2] = [b"Type", b"Pages"];
+/// Catalog entries a split output drops as well: they describe the pages
+/// of the whole source, and forms and name trees would drag in the fields
+/// and destinations of every other page.
+const SPLIT_DROPPED_CATALOG_KEYS: [&[u8]; 6] = [
+    b"Type",
+    b"Pages",
+    b"Outlines",
+    b"PageLabels",
+    b"AcroForm",
+    b"Names",
+];
+
+/// Writes the pages of every input, in order, to `output_path`.
+pub fn merge(paths: &[String], output_path: &str) -> PdfResult<()> {
+    if paths.is_empty() {
+        return Err(PdfError::IoError("No documents to merge".into()));
+    }
+    let mut writer = PdfWriter::create(output_path)?;
+    let pages_id = writer.reserve();
+    let mut kids = Vec::new();
+    for path in paths {
+        let doc = load(path)?;
+        let pages: Vec<ObjectId> = doc.get_pages().into_values().collect();
+        kids.extend(copy_pages(&mut writer, &doc.objects, &pages, pages_id, None)?.pages);
+    }
+    finish(writer, pages_id, &kids, b"")?;
+    Ok(())
+}
+
+/// Writes each of `page_indices` of `path` to a one-page file in
+/// `output_dir`, all outputs in parallel. Fails before writing anything if
+/// an index is out of range.
+pub fn split(path: &str, page_indices: &[usize], output_dir: &str) -> PdfResult<Vec<String>> {
+    let doc = load(path)?;
+    let pages: Vec<ObjectId> = doc.get_pages().into_values().collect();
+    let selected: Vec<(usize, ObjectId)> = page_indices
+        .iter()
+        .map(|&page_idx| {
+            pages
+                .get(page_idx)
+                .map(|&page| (page_idx, page))
+                .ok_or(PdfError::PageNotFound(page_idx))
+        })
+        .collect::<PdfResult<_>>()?;
+    let catalog = doc.catalog().ok();
+    let stem = std::path::Path::new(path)
+        .file_stem()
+        .and_then(|s| s.to_str())
+        .unwrap_or("document");
+    let objects = &doc.objects;
+
+    selected
+        .par_iter()
+        .map(|&(page_idx, page)| {
+            let out_path = format!("{}/{}_page_{}.pdf", output_dir, stem, page_idx + 1);
+            let mut writer = PdfWriter::create(&out_path)?;
+            let pages_id = writer.reserve();
+            let catalog = catalog.map(|catalog| (catalog, &SPLIT_DROPPED_CATALOG_KEYS[..]));
+            let copied = copy_pages(&mut writer, objects, &[page], pages_id, catalog)?;
+            finish(writer, pages_id, &copied.pages, &copied.catalog)?;
+            Ok(out_path)
+        })
+        .collect()
+}
+
+/// Writes the pages of `input_path` in `page_order` to `output_path`,
+/// keeping the rest of the catalog (outline, forms, names). Out-of-range
+/// indices are skipped.
+pub fn reorder(input_path: &str, page_order: &[usize], output_path: &str) -> PdfResult<()> {
+    let doc = load(input_path)?;
+    let pages: Vec<ObjectId> = doc.get_pages().into_values().collect();
+    let reordered: Vec<ObjectId> = page_order
+        .iter()
+        .filter_map(|&i| pages.get(i).copied())
+        .collect();
+    if reordered.is_empty() {
+        return Err(PdfError::from("No valid pages in reorder mapping"));
+    }
+    let mut writer = PdfWriter::create(output_path)?;
+    let pages_id = writer.reserve();
+    let catalog = doc
+        .catalog()
+        .ok()
+        .map(|catalog| (catalog, &REBUILT_CATALOG_KEYS[..]));
+    let copied = copy_pages(&mut writer, &doc.objects, &reordered, pages_id, catalog)?;
+    finish(writer, pages_id, &copied.pages, &copied.catalog)?;
+    Ok(())
+}
+
+fn load(path: &str) -> PdfResult<Document> {
+    Document::load(path).map_err(|e| PdfError::OpenFailed(e.to_string()))
+}
+
+/// New object numbers of the copied pages, in order, plus the serialized
+/// entries of the source catalog that were carried over.
+struct CopiedPages {
+    pages: Vec<u32>,
+    catalog: Vec<u8>,
+}
+
+/// Copies `pages`, everything they reference and optionally the entries of
+/// `catalog` not listed with it, writing each object as soon as it is
+/// serialized. Copied pages get `parent` as their parent and their
+/// inherited attributes inline. References to page tree nodes and to pages
+/// not being copied become `null`.
+fn copy_pages<W: Write>(
+    writer: &mut PdfWriter<W>,
+    objects: &Objects,
+    pages: &[ObjectId],
+    parent: u32,
+    catalog: Option<(&Dictionary, &[&[u8]])>,
+) -> io::Result<CopiedPages> {
+    let page_dicts: Vec<Dictionary> = pages
+        .iter()
+        .map(|&id| materialized_page(objects, id))
+        .collect();
+    let catalog_values = catalog
+        .into_iter()
+        .flat_map(|(dict, dropped)| {
+            dict.iter()
+                .filter(move |(key, _)| !dropped.contains(&key.as_slice()))
+        })
+        .map(|(_, value)| value);
+    let roots = page_dicts
+        .iter()
+        .flat_map(|dict| dict.iter().map(|(_, value)| value))
+        .chain(catalog_values);
+
+    let kept: HashSet<ObjectId> = pages.iter().copied().collect();
+    let mut ids: HashMap<ObjectId, u32> = HashMap::new();
+    for &page in pages {
+        ids.entry(page).or_insert_with(|| writer.reserve());
+    }
+    let copied = reachable(objects, roots, &kept);
+    for &id in &copied {
+        ids.insert(id, writer.reserve());
+    }
+    let remap = |id: ObjectId| ids.get(&id).copied();
+
+    let mut body = Vec::new();
+    let mut written = HashSet::new();
+    for (&page, dict) in pages.iter().zip(&page_dicts) {
+        if !written.insert(page) {
+            continue;
+        }
+        body.clear();
+        body.extend_from_slice(format!("<</Parent {parent} 0 R").as_bytes());
+        serialize_entries(&mut body, dict, &[b"Parent"], &remap);
+        body.extend_from_slice(b">>");
+        writer.write_object(ids[&page], &body)?;
+    }
+    for id in copied {
+        body.clear();
+        serialize(&mut body, &objects[&id], &remap);
+        writer.write_object(ids[&id], &body)?;
+    }
+
+    let mut catalog_body = Vec::new();
+    if let Some((dict, dropped)) = catalog {
+        serialize_entries(&mut catalog_body, dict, dropped, &remap);
+    }
+    Ok(CopiedPages {
+        pages: pages.iter().map(|page| ids[page]).collect(),
+        catalog: catalog_body,
+    })
+}
+
+/// Writes the page tree node and the catalog, then the cross-reference
+/// table. `catalog` holds extra serialized catalog entries.
+fn finish<W: Write>(
+    mut writer: PdfWriter<W>,
+    pages_id: u32,
+    kids: &[u32],
+    catalog: &[u8],
+) -> io::Result<W> {
+    let kids: Vec<String> = kids.iter().map(|id| format!("{id} 0 R")).collect();
+    let tree = format!(
+        "<</Type/Pages/Count {}/Kids[{}]>>",
+        kids.len(),
+        kids.join(" ")
+    );
+    writer.write_object(pages_id, tree.as_bytes())?;
+
+    let root = writer.reserve();
+    let mut body = format!("<</Type/Catalog/Pages {pages_id} 0 R").into_bytes();
+    body.extend_from_slice(catalog);
+    body.extend_from_slice(b">>");
+    writer.write_object(root, &body)?;
+    writer.finish(root)
+}
+
+/// `page`'s dictionary with any inherited attributes it lacks filled in
+/// from its ancestors.
+pub(crate) fn materialized_page(objects: &Objects, page: ObjectId) -> Dictionary {
+    let Some(mut node) = dictionary(objects, page) else {
+        return Dictionary::new();
+    };
+    let mut dict = node.clone();
+    for _ in 0..MAX_TREE_DEPTH {
+        let Some(parent) = node
+            .get(b"Parent")
+            .ok()
+            .and_then(|parent| parent.as_reference().ok())
+            .and_then(|parent| dictionary(objects, parent))
+        else {
+            break;
+        };
+        for key in INHERITED_KEYS {
+            if !dict.has(key)
+                && let Ok(value) = parent.get(key)
+            {
+                dict.set(key, value.clone());
+            }
+        }
+        node = parent;
+    }
+    dict
+}
+
+fn dictionary(objects: &Objects, id: ObjectId) -> Option<&Dictionary> {
+    match objects.get(&id)? {
+        Object::Dictionary(dict) => Some(dict),
+        _ => None,
+    }
+}
+
+/// Indirect objects reachable from `roots`, in discovery order, excluding
+/// page tree nodes and pages; `kept` pages are written separately.
+fn reachable<'a>(
+    objects: &'a Objects,
+    roots: impl Iterator<Item = &'a Object>,
+    kept: &HashSet<ObjectId>,
+) -> Vec<ObjectId> {
+    let mut stack: Vec<&Object> = roots.collect();
+    let mut seen: HashSet<ObjectId> = kept.clone();
+    let mut found = Vec::new();
+    while let Some(object) = stack.pop() {
+        match object {
+            Object::Reference(id) => {
+                if !seen.insert(*id) {
+                    continue;
+                }
+                let Some(target) = objects.get(id) else {
+                    continue;
+                };
+                if is_page_tree_entry(target) {
+                    continue;
+                }
+                found.push(*id);
+                stack.push(target);
+            }
+            Object::Array(items) => stack.extend(items),
+            Object::Dictionary(dict) => stack.extend(dict.iter().map(|(_, value)| value)),
+            Object::Stream(stream) => stack.extend(stream.dict.iter().map(|(_, value)| value)),
+            _ => {}
+        }
+    }
+    found
+}
+
+fn is_page_tree_entry(object: &Object) -> bool {
+    matches!(object, Object::Dictionary(dict) if dict.type_is(b"Pages") || dict.type_is(b"Page"))
+}
+
+/// Appends `object` in PDF syntax. References go through `remap`; ones it
+/// does not know become `null`.
+fn serialize(out: &mut Vec<u8>, object: &Object, remap: &impl Fn(ObjectId) -> Option<u32>) {
+    match object {
+        Object::Null => out.extend_from_slice(b"null"),
+        Object::Boolean(value) => out.extend_from_slice(if *value { b"true" } else { b"false" }),
+        Object::Integer(value) => out.extend_from_slice(value.to_string().as_bytes()),
+        Object::Real(value) => out.extend_from_slice(value.to_string().as_bytes()),
+        Object::Name(name) => serialize_name(out, name),
+        Object::String(bytes, StringFormat::Literal) => {
+            out.push(b'(');
+            for &byte in bytes {
+                match byte {
+                    b'\\' | b'(' | b')' => out.extend_from_slice(&[b'\\', byte]),
+                    b'\r' => out.extend_from_slice(b"\\r"),
+                    _ => out.push(byte),
+                }
+            }
+            out.push(b')');
+        }
+        Object::String(bytes, StringFormat::Hexadecimal) => {
+            out.push(b'<');
+            for byte in bytes {
+                out.extend_from_slice(format!("{byte:02X}").as_bytes());
+            }
+            out.push(b'>');
+        }
+        Object::Array(items) => {
+            out.push(b'[');
+            for (i, item) in items.iter().enumerate() {
+                if i > 0 {
+                    out.push(b' ');
+                }
+                serialize(out, item, remap);
+            }
+            out.push(b']');
+        }
+        Object::Dictionary(dict) => {
+            out.extend_from_slice(b"<<");
+            serialize_entries(out, dict, &[], remap);
+            out.extend_from_slice(b">>");
+        }
+        Object::Stream(stream) => {
+            out.extend_from_slice(b"<<");
+            serialize_entries(out, &stream.dict, &[b"Length"], remap);
+            out.extend_from_slice(
+                format!("/Length {}>>\nstream\n", stream.content.len()).as_bytes(),
+            );
+            out.extend_from_slice(&stream.content);
+            out.extend_from_slice(b"\nendstream");
+        }
+        Object::Reference(id) => match remap(*id) {
+            Some(new_id) => out.extend_from_slice(format!("{new_id} 0 R").as_bytes()),
+            None => out.extend_from_slice(b"null"),
+        },
+    }
+}
+
+fn serialize_entries(
+    out: &mut Vec<u8>,
+    dict: &Dictionary,
+    skipped: &[&[u8]],
+    remap: &impl Fn(ObjectId) -> Option<u32>,
+) {
+    for (key, value) in dict.iter() {
+        if skipped.contains(&key.as_slice()) {
+            continue;
+        }
+        serialize_name(out, key);
+        out.push(b' ');
+        serialize(out, value, remap);
+    }
+}
+
+fn serialize_name(out: &mut Vec<u8>, name: &[u8]) {
+    out.push(b'/');
+    for &byte in name {
+        if (b'!'..=b'~').contains(&byte) && !b"#()<>[]{}/%".contains(&byte) {
+            out.push(byte);
+        } else {
+            out.extend_from_slice(format!("#{byte:02X}").as_bytes());
+        }
+    }
+}
+
+/// Sequential PDF writer: objects go to the output as they are written, and
+/// only their offsets are kept for the cross-reference table.
+struct PdfWriter<W: Write> {
+    out: W,
+    position: u64,
+    /// Byte offset of each object by number; 0 for object 0 and for numbers
+    /// reserved but not yet written.
+    offsets: Vec<u64>,
+}
+
+impl PdfWriter<BufWriter<File>> {
+    fn create(path: &str) -> io::Result<Self> {
+        Self::new(BufWriter::new(File::create(path)?))
+    }
+}
+
+impl<W: Write> PdfWriter<W> {
+    fn new(out: W) -> io::Result<Self> {
+        let mut writer = Self {
+            out,
+            position: 0,
+            offsets: vec![0],
+        };
+        writer.emit(b"%PDF-1.7\n%\xE2\xE3\xCF\xD3\n")?;
+        Ok(writer)
+    }
+
+    /// Allocates the next object number.
+    fn reserve(&mut self) -> u32 {
+        self.offsets.push(0);
+        (self.offsets.len() - 1) as u32
+    }
+
+    fn write_object(&mut self, id: u32, body: &[u8]) -> io::Result<()> {
+        self.offsets[id as usize] = self.position;
+        self.emit(format!("{id} 0 obj\n").as_bytes())?;
+        self.emit(body)?;
+        self.emit(b"\nendobj\n")
+    }
+
+    fn finish(mut self, root: u32) -> io::Result<W> {
+        let xref = self.position;
+        let mut table = format!("xref\n0 {}\n", self.offsets.len());
+        for &offset in &self.offsets {
+            if offset == 0 {
+                table.push_str("0000000000 65535 f \n");
+            } else {
+                table.push_str(&format!("{offset:010} 00000 n \n"));
+            }
+        }
+        table.push_str(&format!(
+            "trailer\n<</Size {}/Root {root} 0 R>>\nstartxref\n{xref}\n%%EOF\n",
+            self.offsets.len()
+        ));
+        self.emit(table.as_bytes())?;
+        self.out.flush()?;
+        Ok(self.out)
+    }
+
+    fn emit(&mut self, bytes: &[u8]) -> io::Result<()> {
+        self.out.write_all(bytes)?;
+        self.position += bytes.len() as u64;
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const SOURCE: &str = concat!(env!("CARGO_MANIFEST_DIR"), "/tests/test_document.pdf");
+
+    fn scratch(name: &str) -> std::path::PathBuf {
+        let dir =
+            std::env::temp_dir().join(format!("pdfbull_doc_ops_{name}_{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        dir
+    }
+
+    fn page_count(path: &str) -> usize {
+        Document::load(path).unwrap().get_pages().len()
+    }
+
+    #[test]
+    fn test_merge_appends_every_page() {
+        let dir = scratch("merge");
+        let output = dir.join("merged.pdf").to_string_lossy().into_owned();
+        merge(&[SOURCE.to_string(), SOURCE.to_string()], &output).unwrap();
+        assert_eq!(page_count(&output), 2 * page_count(SOURCE));
+        assert!(merge(&[], &output).is_err());
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_split_writes_one_page_per_output() {
+        let dir = scratch("split");
+        let output_dir = dir.to_string_lossy().into_owned();
+        let last = page_count(SOURCE) - 1;
+        let outputs = split(SOURCE, &[last, 0], &output_dir).unwrap();
+        assert_eq!(outputs.len(), 2);
+        assert!(outputs[0].ends_with(&format!("_page_{}.pdf", last + 1)));
+        for output in &outputs {
+            assert_eq!(page_count(output), 1);
+        }
+        let _ = std::fs::remove_dir_all(&dir);
+
+        std::fs::create_dir_all(&dir).unwrap();
+        assert!(split(SOURCE, &[0, last + 1], &output_dir).is_err());
+        assert_eq!(
+            std::fs::read_dir(&dir).unwrap().count(),
+            0,
+            "nothing written"
+        );
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_reorder_follows_page_order() {
+        let dir = scratch("reorder");
+        let output = dir.join("reordered.pdf").to_string_lossy().into_owned();
+        let count = page_count(SOURCE);
+        let order: Vec<usize> = (0..count).rev().chain([count + 5]).collect();
+        reorder(SOURCE, &order, &output).unwrap();
+
+        let source = Document::load(SOURCE).unwrap();
+        let reordered = Document::load(&output).unwrap();
+        let source_pages: Vec<_> = source.get_pages().into_values().collect();
+        let output_pages: Vec<_> = reordered.get_pages().into_values().collect();
+        assert_eq!(output_pages.len(), count);
+        let expected = materialized_page(&source.objects, source_pages[count - 1]);
+        let first = reordered.get_dictionary(output_pages[0]).unwrap();
+        assert_eq!(
+            first.has(b"MediaBox"),
+            expected.has(b"MediaBox"),
+            "inherited attributes are written inline"
+        );
+        assert!(reorder(SOURCE, &[count], &output).is_err());
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
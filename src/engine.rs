@@ -1,288 +1,525 @@
-use crate::commands::PdfCommand;
-use crate::pdf_engine::{DocumentStore, SharedRenderCache, create_render_cache};
-use std::collections::HashMap;
-use std::sync::{Arc, RwLock};
+use crate::commands::{JobPriority, PdfCommand};
+use crate::metrics::{Lane, metrics};
+use crate::models::AppSettings;
+use crate::pdf_engine::{
+    DocumentStore, SharedDocumentRegistry, SharedRenderCache, create_document_registry,
+    create_render_cache,
+};
+use std::collections::{HashSet, VecDeque};
+use std::sync::{Arc, Condvar, Mutex, PoisonError};
 use tokio::sync::mpsc;
 
+/// Upper bound for an auto-sized render pool; past it, more bitmaps in
+/// flight cost more memory than the extra parallelism saves.
+const MAX_AUTO_RENDER_WORKERS: usize = 16;
+const MIN_RENDER_WORKERS: usize = 2;
+
 #[derive(Debug, Clone)]
 pub struct EngineState {
     pub cmd_tx: mpsc::Sender<PdfCommand>,
 }
 
-/// Re-open a document from its remembered path if it isn't currently loaded.
-fn reload_if_needed(
-    store: &mut DocumentStore,
-    paths: &Arc<RwLock<HashMap<crate::models::DocumentId, String>>>,
-    doc_id: crate::models::DocumentId,
-) {
-    if !store.has_document(doc_id) {
-        if let Ok(guard) = paths.read() {
-            if let Some(path) = guard.get(&doc_id).cloned() {
-                if let Err(e) = store.open_document(&path, None, doc_id) {
-                    tracing::error!(
-                        "Failed to reload document {doc_id:?} from path '{path}': {e:?}"
-                    );
-                }
+/// Commands waiting for a worker, one FIFO per `JobPriority`.
+#[derive(Default)]
+struct JobQueue {
+    lane: Lane,
+    state: Mutex<QueueState>,
+    ready: Condvar,
+}
+
+#[derive(Default)]
+struct QueueState {
+    classes: [VecDeque<PdfCommand>; JobPriority::COUNT],
+    closed: bool,
+}
+
+impl QueueState {
+    fn len(&self) -> usize {
+        self.classes.iter().map(VecDeque::len).sum()
+    }
+}
+
+impl JobQueue {
+    fn new(lane: Lane) -> Self {
+        Self {
+            lane,
+            ..Self::default()
+        }
+    }
+
+    fn push(&self, cmd: PdfCommand) {
+        let mut state = self.state.lock().unwrap_or_else(PoisonError::into_inner);
+        state.classes[cmd.priority() as usize].push_back(cmd);
+        metrics().set_queue_depth(self.lane, state.len());
+        drop(state);
+        self.ready.notify_one();
+    }
+
+    /// Blocks until a command is queued; `None` once the queue is closed and drained.
+    fn pop(&self) -> Option<PdfCommand> {
+        let mut state = self.state.lock().unwrap_or_else(PoisonError::into_inner);
+        loop {
+            if let Some(cmd) = state.classes.iter_mut().find_map(VecDeque::pop_front) {
+                metrics().set_queue_depth(self.lane, state.len());
+                return Some(cmd);
+            }
+            if state.closed {
+                return None;
+            }
+            state = self
+                .ready
+                .wait(state)
+                .unwrap_or_else(PoisonError::into_inner);
+        }
+    }
+
+    /// Cancels queued page renders of `doc_id` that `keep` rejects.
+    fn cancel_renders(
+        &self,
+        doc_id: crate::models::DocumentId,
+        viewport_only: bool,
+        keep: impl Fn(usize) -> bool,
+    ) {
+        let mut cancelled = Vec::new();
+        {
+            let mut state = self.state.lock().unwrap_or_else(PoisonError::into_inner);
+            for class in &mut state.classes {
+                let (stale, live): (VecDeque<_>, VecDeque<_>) = class.drain(..).partition(|cmd| {
+                    cmd.render_target(viewport_only)
+                        .is_some_and(|(id, page)| id == doc_id && !keep(page))
+                });
+                *class = live;
+                cancelled.extend(stale);
             }
+            metrics().set_queue_depth(self.lane, state.len());
         }
+        if !cancelled.is_empty() {
+            tracing::debug!(
+                "Scheduler cancelled {} stale renders for {:?}",
+                cancelled.len(),
+                doc_id
+            );
+        }
+        for cmd in cancelled {
+            cmd.cancel();
+        }
+    }
+
+    fn close(&self) {
+        self.state
+            .lock()
+            .unwrap_or_else(PoisonError::into_inner)
+            .closed = true;
+        self.ready.notify_all();
     }
 }
 
 #[must_use]
-pub fn spawn_engine_thread(cache_size: u64, max_memory_mb: u64) -> EngineState {
+pub fn spawn_engine_thread(settings: &AppSettings) -> EngineState {
     let (cmd_tx, mut cmd_rx) = mpsc::channel::<PdfCommand>(128);
 
-    let render_cache: SharedRenderCache = create_render_cache(cache_size, max_memory_mb);
+    let render_cache: SharedRenderCache = create_render_cache(
+        settings.cache_size as u64,
+        settings.max_cache_memory as u64,
+        settings.disk_cache_mb as u64,
+    );
 
-    // Shared paths mapping between all concurrent threads
-    let shared_paths = Arc::new(RwLock::new(HashMap::new()));
+    // Documents are parsed once by whichever worker handles `Open`; every
+    // other worker renders from the same `Arc`-shared copy.
+    let registry: SharedDocumentRegistry = create_document_registry();
 
-    // MPMC channel for distributing tasks across the thread pool
-    let (worker_tx, worker_rx) = crossbeam_channel::bounded::<PdfCommand>(256);
+    // Priority queue shared by the worker pool. Visible pages jump ahead of
+    // prefetch, thumbnails and exports, and renders the viewport has left
+    // are cancelled before a worker picks them up.
+    let queue = Arc::new(JobQueue::new(Lane::Interactive));
+    // Document operations get their own lane and threads, so a merge or an
+    // optimize pass never occupies a worker that renders could use.
+    let heavy = Arc::new(JobQueue::new(Lane::Heavy));
+    let cores = std::thread::available_parallelism()
+        .map(std::num::NonZero::get)
+        .unwrap_or(4);
 
-    // Forward Tokio mpsc commands into the crossbeam MPMC channel.
+    // Forward Tokio mpsc commands into the scheduler.
     // iced uses the `tokio` feature so a full multi-thread runtime is always
     // available here; tokio::spawn is safe and keeps the forwarder alive for
     // the lifetime of the iced application.
+    let scheduler = queue.clone();
+    let heavy_lane = heavy.clone();
     tokio::spawn(async move {
         while let Some(cmd) = cmd_rx.recv().await {
-            let _ = worker_tx.send(cmd);
+            match cmd {
+                PdfCommand::SetViewport(doc_id, pages) => {
+                    let keep: HashSet<usize> = pages.into_iter().collect();
+                    scheduler.cancel_renders(doc_id, true, |page| keep.contains(&page));
+                }
+                PdfCommand::Close(doc_id) => {
+                    scheduler.cancel_renders(doc_id, false, |_| false);
+                    scheduler.push(PdfCommand::Close(doc_id));
+                }
+                PdfCommand::Reload(doc_id, tx) => {
+                    scheduler.cancel_renders(doc_id, false, |_| false);
+                    scheduler.push(PdfCommand::Reload(doc_id, tx));
+                }
+                cmd if cmd.is_heavy() => heavy_lane.push(cmd),
+                cmd => scheduler.push(cmd),
+            }
         }
+        scheduler.close();
+        heavy_lane.close();
         tracing::debug!("Engine forwarder task exited (cmd_tx dropped)");
     });
 
-    let num_workers = std::thread::available_parallelism()
-        .map(std::num::NonZero::get)
-        .unwrap_or(4)
-        .clamp(2, 4);
-
-    for _ in 0..num_workers {
-        let rx = worker_rx.clone();
-        let cache = render_cache.clone();
-        let paths = shared_paths.clone();
-
-        std::thread::spawn(move || {
-            let mut store = DocumentStore::new(cache);
-
-            while let Ok(cmd) = rx.recv() {
-                match cmd {
-                    PdfCommand::Open(path, password, doc_id, tx) => {
-                        tracing::info!("Engine worker: opening {:?}", path);
-                        let mut store_ref = std::panic::AssertUnwindSafe(&mut store);
-                        let path_clone = path.clone();
-                        let pass_clone = password.clone();
-                        let result = std::panic::catch_unwind(move || {
-                            store_ref.open_document(&path_clone, pass_clone.as_deref(), doc_id)
-                        });
-
-                        let res = match result {
-                            Ok(res) => res,
-                            Err(err) => {
-                                let panic_msg = if let Some(s) = err.downcast_ref::<&str>() {
-                                    *s
-                                } else if let Some(s) = err.downcast_ref::<String>() {
-                                    s.as_str()
-                                } else {
-                                    "unknown panic"
-                                };
-                                tracing::error!(
-                                    "Engine worker panicked during open: {}",
-                                    panic_msg
-                                );
-                                Err(crate::models::PdfError::EngineDied)
-                            }
-                        };
-
-                        if res.is_ok() {
-                            if let Ok(mut guard) = paths.write() {
-                                guard.insert(doc_id, path);
-                            }
-                        } else {
-                            tracing::error!("Engine worker: open failed: {:?}", res);
-                        }
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::Render(doc_id, page_num, options, tx) => {
-                        tracing::debug!("Engine worker: render page {} for {:?}", page_num, doc_id);
-                        reload_if_needed(&mut store, &paths, doc_id);
-
-                        let mut store_ref = std::panic::AssertUnwindSafe(&mut store);
-                        let result = std::panic::catch_unwind(move || {
-                            store_ref.render_page(doc_id, page_num, options)
-                        });
-
-                        let res = match result {
-                            Ok(res) => res,
-                            Err(err) => {
-                                let panic_msg = if let Some(s) = err.downcast_ref::<&str>() {
-                                    *s
-                                } else if let Some(s) = err.downcast_ref::<String>() {
-                                    s.as_str()
-                                } else {
-                                    "unknown panic"
-                                };
-                                tracing::error!(
-                                    "Engine worker panicked during render page {}: {}",
-                                    page_num,
-                                    panic_msg
-                                );
-                                Err(crate::models::PdfError::EngineDied)
-                            }
-                        };
-
-                        if res.is_err() {
-                            tracing::error!(
-                                "Engine worker: render page {} failed: {:?}",
-                                page_num,
-                                res
-                            );
-                        }
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::RenderThumbnail(doc_id, page_num, scale, rotation, tx) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        let options = crate::pdf_engine::RenderOptions {
-                            scale,
-                            rotation,
-                            filter: crate::pdf_engine::RenderFilter::None,
-                            auto_crop: false,
-                            quality: crate::pdf_engine::RenderQuality::Low,
-                        };
-                        let res = store.render_thumbnail(doc_id, page_num, options);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::Close(doc_id) => {
-                        store.close_document(doc_id);
-                        if let Ok(mut guard) = paths.write() {
-                            guard.remove(&doc_id);
-                        }
-                    }
-                    PdfCommand::ExtractText(doc_id, page_num, tx) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        let res = store.extract_text(doc_id, page_num);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::Search(doc_id, query, tx) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        let res = store.search(doc_id, &query);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::GetTextItems(doc_id, page_num, tx) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        let res = store.extract_text_items(doc_id, page_num);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::LoadDocumentMeta(doc_id, tx) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        let res = store.load_document_meta(doc_id);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::SaveAnnotations(doc_id, annotations, tx) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        let res = store.save_annotations(doc_id, &annotations, None);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::ExportImage(doc_id, page_num, scale, tx) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        let res = store.export_page_as_image(doc_id, page_num, scale);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::ExportImages(doc_id, pages, scale, out_dir, tx) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        let out_path = std::path::Path::new(&out_dir);
-                        if !out_path.is_dir() {
-                            let _ = tx.send(Err(crate::models::PdfError::IoError(
-                                "Output directory does not exist".into(),
-                            )));
-                            continue;
-                        }
-                        let mut output_paths = Vec::new();
-                        for page_num in pages {
-                            let safe_name = format!("page_{page_num}.png");
-                            let out_file = out_path.join(&safe_name);
-                            if let Ok(buf) = store.export_page_as_image(doc_id, page_num, scale) {
-                                let optimized =
-                                    oxipng::optimize_from_memory(&buf, &oxipng::Options::default())
-                                        .unwrap_or(buf);
-                                if std::fs::write(&out_file, optimized).is_ok()
-                                    && let Some(path_str) = out_file.to_str()
-                                {
-                                    output_paths.push(path_str.to_string());
-                                }
-                            }
-                        }
-                        let _ = tx.send(Ok(output_paths));
-                    }
-                    PdfCommand::ExportPdf(doc_id, path, annotations, tx) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        let res = store.save_annotations(doc_id, &annotations, Some(path));
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::Merge(paths_list, out, tx) => {
-                        let res = store.merge_documents(paths_list, out);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::Split(path, pages, out, tx) => {
-                        let res = store.split_pdf(&path, pages, out);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::GetFormFields(path, tx) => {
-                        let res = store.get_form_fields(&path);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::FillForm(path, fields, out, tx) => {
-                        let res = store.fill_form(&path, fields, out);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::PrintPdf(path, printer_name, tx) => {
-                        let res = crate::pdf_engine::DocumentStore::print_document(
-                            &path,
-                            printer_name.as_deref(),
-                        );
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::ListPrinters(tx) => {
-                        let _ = tx.send(crate::pdf_engine::DocumentStore::list_printers());
-                    }
-                    PdfCommand::AddWatermark(input, text, output, tx) => {
-                        let res =
-                            crate::pdf_engine::DocumentStore::add_watermark(&input, &text, &output);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::Optimize(input, output, tx) => {
-                        let res = store.optimize_pdf(&input, &output);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::ReorderPages(input, page_order, output, tx) => {
-                        let res = store.reorder_pages(&input, &page_order, &output);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::LoadAnnotations(doc_id, path, tx) => {
-                        // Load annotations stored in the PDF at `path`.
-                        // `doc_id` is unused here since we load directly from the path,
-                        // but kept for API symmetry and potential future caching.
-                        let _ = doc_id; // suppress unused warning
-                        let res = store.load_annotations(&path);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::ToggleLayer(doc_id, object_id, visible) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        store.toggle_layer(doc_id, object_id, visible);
-                    }
-                    PdfCommand::GetAttachmentBytes(doc_id, object_id, tx) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        let res = store.get_attachment_bytes(doc_id, object_id);
-                        let _ = tx.send(res);
-                    }
-                    PdfCommand::DetectTables(doc_id, page_num, tx) => {
-                        reload_if_needed(&mut store, &paths, doc_id);
-                        let res = store.detect_tables_on_page(doc_id, page_num);
-                        let _ = tx.send(res);
-                    }
+    let store = || {
+        DocumentStore::with_registry(render_cache.clone(), registry.clone())
+            .with_backend(settings.render_backend)
+    };
+    for i in 0..render_worker_count(settings.render_workers, cores) {
+        spawn_worker(format!("pdf-render-{i}"), &queue, store());
+    }
+    for i in 0..settings.heavy_jobs.max(1) {
+        spawn_worker(format!("pdf-heavy-{i}"), &heavy, store());
+    }
+
+    EngineState { cmd_tx }
+}
+
+/// Size of the interactive pool: `requested` if set, else one worker per
+/// core but one, which stays with the UI thread.
+fn render_worker_count(requested: usize, cores: usize) -> usize {
+    if requested > 0 {
+        return requested;
+    }
+    cores
+        .saturating_sub(1)
+        .clamp(MIN_RENDER_WORKERS, MAX_AUTO_RENDER_WORKERS)
+}
+
+fn spawn_worker(name: String, queue: &Arc<JobQueue>, mut store: DocumentStore) {
+    let queue = queue.clone();
+    let spawned = std::thread::Builder::new().name(name).spawn(move || {
+        while let Some(cmd) = queue.pop() {
+            handle_command(&mut store, cmd);
+        }
+    });
+    if let Err(e) = spawned {
+        tracing::error!("Failed to start engine worker: {e}");
+    }
+}
+
+fn handle_command(store: &mut DocumentStore, cmd: PdfCommand) {
+    let name = cmd.name();
+    let started = std::time::Instant::now();
+    dispatch(store, cmd);
+    metrics().record_command(name, started.elapsed());
+}
+
+fn dispatch(store: &mut DocumentStore, cmd: PdfCommand) {
+    match cmd {
+        PdfCommand::Open(path, password, doc_id, tx) => {
+            tracing::info!("Engine worker: opening {:?}", path);
+            let mut store_ref = std::panic::AssertUnwindSafe(&mut *store);
+            let result = std::panic::catch_unwind(move || {
+                store_ref.open_document(&path, password.as_deref(), doc_id)
+            });
+
+            let res = match result {
+                Ok(res) => res,
+                Err(err) => {
+                    let panic_msg = if let Some(s) = err.downcast_ref::<&str>() {
+                        *s
+                    } else if let Some(s) = err.downcast_ref::<String>() {
+                        s.as_str()
+                    } else {
+                        "unknown panic"
+                    };
+                    tracing::error!("Engine worker panicked during open: {}", panic_msg);
+                    Err(crate::models::PdfError::EngineDied)
+                }
+            };
+
+            if res.is_err() {
+                tracing::error!("Engine worker: open failed: {:?}", res);
+            }
+            let _ = tx.send(res);
+        }
+        PdfCommand::Render(doc_id, page_num, options, _, preview_tx, tx) => {
+            tracing::debug!("Engine worker: render page {} for {:?}", page_num, doc_id);
+
+            let mut store_ref = std::panic::AssertUnwindSafe(&mut *store);
+            let result = std::panic::catch_unwind(move || {
+                if let Some(preview_tx) = preview_tx
+                    && let Ok(Some(preview)) = store_ref.render_preview(doc_id, page_num, &options)
+                {
+                    let _ = preview_tx.send(Ok(preview));
+                }
+                store_ref.render_page(doc_id, page_num, options)
+            });
+
+            let res = match result {
+                Ok(res) => res,
+                Err(err) => {
+                    let panic_msg = if let Some(s) = err.downcast_ref::<&str>() {
+                        *s
+                    } else if let Some(s) = err.downcast_ref::<String>() {
+                        s.as_str()
+                    } else {
+                        "unknown panic"
+                    };
+                    tracing::error!(
+                        "Engine worker panicked during render page {}: {}",
+                        page_num,
+                        panic_msg
+                    );
+                    Err(crate::models::PdfError::EngineDied)
                 }
+            };
+
+            if res.is_err() {
+                tracing::error!("Engine worker: render page {} failed: {:?}", page_num, res);
+            }
+            let _ = tx.send(res);
+        }
+        PdfCommand::RenderTiles(doc_id, page_num, options, tiles, tx) => {
+            tracing::debug!(
+                "Engine worker: render {} tiles of page {} for {:?}",
+                tiles.len(),
+                page_num,
+                doc_id
+            );
+
+            let mut store_ref = std::panic::AssertUnwindSafe(&mut *store);
+            let result = std::panic::catch_unwind(move || {
+                store_ref.render_tiles(doc_id, page_num, options, &tiles)
+            });
+
+            let res = result.unwrap_or_else(|_| {
+                tracing::error!(
+                    "Engine worker panicked during tiled render of page {}",
+                    page_num
+                );
+                Err(crate::models::PdfError::EngineDied)
+            });
+            let _ = tx.send(res);
+        }
+        PdfCommand::RenderThumbnails(doc_id, pages, scale, tx) => {
+            let results = pages
+                .into_iter()
+                .map(|(page_num, rotation)| {
+                    let options = crate::pdf_engine::RenderOptions {
+                        scale,
+                        rotation,
+                        filter: crate::pdf_engine::RenderFilter::None,
+                        auto_crop: false,
+                        quality: crate::pdf_engine::RenderQuality::Low,
+                    };
+                    store.render_thumbnail(doc_id, page_num, options)
+                })
+                .collect();
+            let _ = tx.send(results);
+        }
+        PdfCommand::Close(doc_id) => {
+            store.close_document(doc_id);
+        }
+        PdfCommand::Reload(doc_id, tx) => {
+            let res = store.reload_document(doc_id);
+            if let Err(e) = &res {
+                tracing::warn!("Engine worker: reload of {:?} failed: {}", doc_id, e);
+            }
+            let _ = tx.send(res);
+        }
+        PdfCommand::SetViewport(..) => {
+            // Consumed by the scheduler before reaching a worker.
+        }
+        PdfCommand::ExtractText(doc_id, page_num, tx) => {
+            let res = store.extract_text(doc_id, page_num);
+            let _ = tx.send(res);
+        }
+        PdfCommand::Search(doc_id, query, cancel, tx) => {
+            let res = store.search_streaming(doc_id, &query, &cancel, |batch| {
+                let _ = tx.unbounded_send(Ok(batch));
+            });
+            if let Err(e) = res
+                && e != crate::models::PdfError::Cancelled
+            {
+                let _ = tx.unbounded_send(Err(e));
             }
-        });
+        }
+        PdfCommand::GetPageOverlays(doc_id, pages, text, tables, tx) => {
+            let _ = tx.send(store.page_overlays(doc_id, pages, text, tables));
+        }
+        PdfCommand::LoadDocumentMeta(doc_id, tx) => {
+            let res = store.load_document_meta(doc_id);
+            let _ = tx.send(res);
+        }
+        PdfCommand::BuildTextIndex(doc_id, persist) => {
+            if let Err(e) = store.build_text_index(doc_id, persist) {
+                tracing::debug!("Text index build for {:?} stopped: {}", doc_id, e);
+            }
+        }
+        PdfCommand::SaveAnnotations(doc_id, annotations, tx) => {
+            let res = store.save_annotations(doc_id, &annotations, None);
+            let _ = tx.send(res);
+        }
+        PdfCommand::ExportImage(doc_id, page_num, scale, tx) => {
+            let res = store.export_page_as_image(doc_id, page_num, scale);
+            let _ = tx.send(res);
+        }
+        PdfCommand::ExportImages(doc_id, pages, scale, out_dir, level, cancel, progress) => {
+            // Runs on a heavy worker, which waits while the shared export
+            // pool does the work; render workers are not involved.
+            store.export_images(doc_id, &pages, scale, &out_dir, level, &cancel, &progress);
+        }
+        PdfCommand::ExportPdf(doc_id, path, annotations, tx) => {
+            let res = store.save_annotations(doc_id, &annotations, Some(path));
+            let _ = tx.send(res);
+        }
+        PdfCommand::Merge(paths_list, out, tx) => {
+            let res = store.merge_documents(paths_list, out);
+            let _ = tx.send(res);
+        }
+        PdfCommand::Split(path, pages, out, tx) => {
+            let res = store.split_pdf(&path, pages, out);
+            let _ = tx.send(res);
+        }
+        PdfCommand::GetFormFields(path, tx) => {
+            let res = store.get_form_fields(&path);
+            let _ = tx.send(res);
+        }
+        PdfCommand::FillForm(path, fields, out, tx) => {
+            let res = store.fill_form(&path, fields, out);
+            let _ = tx.send(res);
+        }
+        PdfCommand::PrintPdf(path, printer_name, tx) => {
+            let res =
+                crate::pdf_engine::DocumentStore::print_document(&path, printer_name.as_deref());
+            let _ = tx.send(res);
+        }
+        PdfCommand::ListPrinters(tx) => {
+            let _ = tx.send(crate::pdf_engine::DocumentStore::list_printers());
+        }
+        PdfCommand::AddWatermark(input, text, output, tx) => {
+            let res = crate::pdf_engine::DocumentStore::add_watermark(&input, &text, &output);
+            let _ = tx.send(res);
+        }
+        PdfCommand::Optimize(input, output, options, tx) => {
+            let res = store.optimize_pdf(&input, &output, &options);
+            let _ = tx.send(res);
+        }
+        PdfCommand::ReorderPages(input, page_order, output, tx) => {
+            let res = store.reorder_pages(&input, &page_order, &output);
+            let _ = tx.send(res);
+        }
+        PdfCommand::LoadAnnotations(doc_id, path, tx) => {
+            // Load annotations stored in the PDF at `path`.
+            // `doc_id` is unused here since we load directly from the path,
+            // but kept for API symmetry and potential future caching.
+            let _ = doc_id; // suppress unused warning
+            let res = store.load_annotations(&path);
+            let _ = tx.send(res);
+        }
+        PdfCommand::ToggleLayer(doc_id, object_id, visible) => {
+            store.toggle_layer(doc_id, object_id, visible);
+        }
+        PdfCommand::GetAttachmentBytes(doc_id, object_id, tx) => {
+            let res = store.get_attachment_bytes(doc_id, object_id);
+            let _ = tx.send(res);
+        }
+        PdfCommand::CollectMetrics(tx) => {
+            let _ = tx.send(store.metrics_snapshot());
+        }
+        PdfCommand::TrimMemory(keep, target_bytes) => {
+            let freed = store.trim_memory(keep, target_bytes);
+            tracing::debug!("Engine worker: trimmed {freed} bytes of render cache");
+        }
     }
+}
 
-    EngineState { cmd_tx }
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::models::{DocumentId, PdfError};
+    use crate::pdf_engine::{RenderFilter, RenderOptions, RenderQuality};
+    use tokio::sync::oneshot;
+
+    fn render(
+        page: usize,
+        priority: JobPriority,
+    ) -> (
+        PdfCommand,
+        oneshot::Receiver<crate::models::PdfResult<crate::models::RenderResult>>,
+    ) {
+        let (tx, rx) = oneshot::channel();
+        let options = RenderOptions {
+            scale: 1.0,
+            rotation: 0,
+            filter: RenderFilter::None,
+            auto_crop: false,
+            quality: RenderQuality::Medium,
+        };
+        (
+            PdfCommand::Render(DocumentId(1), page, options, priority, None, tx),
+            rx,
+        )
+    }
+
+    fn popped_page(queue: &JobQueue) -> Option<usize> {
+        match queue.pop() {
+            Some(PdfCommand::Render(_, page, ..)) => Some(page),
+            _ => None,
+        }
+    }
+
+    #[test]
+    fn test_job_queue_runs_visible_before_background() {
+        let queue = JobQueue::default();
+        let (export, _export_rx) = render(9, JobPriority::Background);
+        let (prefetch, _prefetch_rx) = render(5, JobPriority::Prefetch);
+        let (visible, _visible_rx) = render(4, JobPriority::Visible);
+        queue.push(export);
+        queue.push(prefetch);
+        queue.push(visible);
+
+        assert_eq!(popped_page(&queue), Some(4));
+        assert_eq!(popped_page(&queue), Some(5));
+        assert_eq!(popped_page(&queue), Some(9));
+        queue.close();
+        assert!(queue.pop().is_none());
+    }
+
+    #[test]
+    fn test_render_worker_count_scales_with_cores() {
+        assert_eq!(render_worker_count(0, 1), MIN_RENDER_WORKERS);
+        assert_eq!(render_worker_count(0, 8), 7);
+        assert_eq!(render_worker_count(0, 64), MAX_AUTO_RENDER_WORKERS);
+        assert_eq!(render_worker_count(3, 64), 3);
+    }
+
+    #[test]
+    fn test_document_operations_use_heavy_lane() {
+        let (tx, _rx) = oneshot::channel();
+        assert!(PdfCommand::Merge(Vec::new(), String::new(), tx).is_heavy());
+        let (tx, _rx) = oneshot::channel();
+        let fill = PdfCommand::FillForm(String::new(), Vec::new(), String::new(), tx);
+        assert!(fill.is_heavy());
+        assert_eq!(fill.priority(), JobPriority::Background);
+        let (visible, _visible_rx) = render(0, JobPriority::Visible);
+        assert!(!visible.is_heavy());
+    }
+
+    #[test]
+    fn test_job_queue_cancels_pages_outside_viewport() {
+        let queue = JobQueue::default();
+        let (stale, mut stale_rx) = render(1, JobPriority::Visible);
+        let (landing, _landing_rx) = render(40, JobPriority::Visible);
+        let (export, _export_rx) = render(2, JobPriority::Background);
+        queue.push(stale);
+        queue.push(landing);
+        queue.push(export);
+
+        queue.cancel_renders(DocumentId(1), true, |page| page == 40);
+
+        assert_eq!(stale_rx.try_recv(), Ok(Err(PdfError::Cancelled)));
+        assert_eq!(popped_page(&queue), Some(40));
+        assert_eq!(popped_page(&queue), Some(2));
+    }
 }
@@ -0,0 +1,204 @@
+//! Appends an incremental-update section (ISO 32000-1 §7.5.6) to an existing
+//! PDF, so saving a few changed objects does not rewrite the whole file.
+
+use lopdf::{Dictionary, Document, Object, ObjectId};
+use std::io::Write;
+use std::path::Path;
+
+/// Trailer entries carried over from the previous revision.
+const CARRIED_TRAILER_KEYS: [&[u8]; 3] = [b"Root", b"Info", b"ID"];
+
+/// Loads the object structure of `path` without stream bodies other than
+/// object streams, which hold compressed dictionaries. Enough to locate and
+/// edit pages and annotations at a fraction of a full load's memory.
+///
+/// The object number space of the file is reserved in `max_id`, so objects
+/// added to the result never collide with streams that were skipped.
+pub fn load_structure(path: &str) -> lopdf::Result<Document> {
+    fn keep_structure(id: ObjectId, object: &mut Object) -> Option<(ObjectId, Object)> {
+        match object {
+            Object::Stream(stream) if !stream.dict.type_is(b"ObjStm") => None,
+            _ => Some((id, std::mem::replace(object, Object::Null))),
+        }
+    }
+    let mut doc = Document::load_filtered(path, keep_structure)?;
+    if let Ok(size) = doc.trailer.get(b"Size").and_then(Object::as_i64) {
+        doc.max_id = doc.max_id.max(size.saturating_sub(1) as u32);
+    }
+    Ok(doc)
+}
+
+/// Writes objects `ids` of `doc` after the previous revision at `path`,
+/// followed by their cross-reference section and a trailer chained to the
+/// previous one. `path` must hold the file `doc` was loaded from.
+pub fn append_update(path: &Path, doc: &Document, ids: &[ObjectId]) -> std::io::Result<()> {
+    let mut file = std::fs::OpenOptions::new().append(true).open(path)?;
+    let base = file.metadata()?.len();
+
+    let mut ids = ids.to_vec();
+    ids.sort_unstable();
+    ids.dedup();
+
+    let mut out = b"\n".to_vec();
+    let mut offsets = Vec::with_capacity(ids.len());
+    for &id in &ids {
+        let object = doc.objects.get(&id).ok_or_else(|| {
+            std::io::Error::new(
+                std::io::ErrorKind::NotFound,
+                format!("object {} {} not loaded", id.0, id.1),
+            )
+        })?;
+        offsets.push(base + out.len() as u64);
+        writeln!(out, "{} {} obj", id.0, id.1)?;
+        write_object(&mut out, object)?;
+        out.extend_from_slice(b"\nendobj\n");
+    }
+
+    let xref_offset = base + out.len() as u64;
+    out.extend_from_slice(b"xref\n");
+    let mut i = 0;
+    while i < ids.len() {
+        let mut end = i + 1;
+        while end < ids.len() && ids[end].0 == ids[end - 1].0 + 1 {
+            end += 1;
+        }
+        writeln!(out, "{} {}", ids[i].0, end - i)?;
+        for (id, offset) in ids[i..end].iter().zip(&offsets[i..end]) {
+            write!(out, "{offset:010} {:05} n\r\n", id.1)?;
+        }
+        i = end;
+    }
+
+    let mut trailer = Dictionary::new();
+    trailer.set("Size", Object::Integer(i64::from(doc.max_id) + 1));
+    for key in CARRIED_TRAILER_KEYS {
+        if let Ok(value) = doc.trailer.get(key) {
+            trailer.set(key, value.clone());
+        }
+    }
+    trailer.set("Prev", Object::Integer(doc.xref_start as i64));
+    out.extend_from_slice(b"trailer\n");
+    write_object(&mut out, &Object::Dictionary(trailer))?;
+    writeln!(out, "\nstartxref\n{xref_offset}\n%%EOF")?;
+
+    file.write_all(&out)?;
+    file.sync_data()
+}
+
+/// Serializes a direct object. Streams are not supported; every object an
+/// update writes here is a dictionary.
+fn write_object(out: &mut Vec<u8>, object: &Object) -> std::io::Result<()> {
+    match object {
+        Object::Null => out.extend_from_slice(b"null"),
+        Object::Boolean(b) => write!(out, "{b}")?,
+        Object::Integer(n) => write!(out, "{n}")?,
+        Object::Real(r) => write!(out, "{}", if r.is_finite() { *r } else { 0.0 })?,
+        Object::Name(name) => write_name(out, name),
+        Object::String(bytes, _) => {
+            out.push(b'<');
+            for byte in bytes {
+                write!(out, "{byte:02X}")?;
+            }
+            out.push(b'>');
+        }
+        Object::Array(items) => {
+            out.push(b'[');
+            for (i, item) in items.iter().enumerate() {
+                if i > 0 {
+                    out.push(b' ');
+                }
+                write_object(out, item)?;
+            }
+            out.push(b']');
+        }
+        Object::Dictionary(dict) => {
+            out.extend_from_slice(b"<<");
+            for (key, value) in dict.iter() {
+                write_name(out, key);
+                out.push(b' ');
+                write_object(out, value)?;
+            }
+            out.extend_from_slice(b">>");
+        }
+        Object::Reference((id, generation)) => write!(out, "{id} {generation} R")?,
+        Object::Stream(_) => {
+            return Err(std::io::Error::new(
+                std::io::ErrorKind::InvalidInput,
+                "streams cannot be written by an incremental update",
+            ));
+        }
+    }
+    Ok(())
+}
+
+fn write_name(out: &mut Vec<u8>, name: &[u8]) {
+    out.push(b'/');
+    for &byte in name {
+        if byte.is_ascii_graphic() && !b"()<>[]{}/%#".contains(&byte) {
+            out.push(byte);
+        } else {
+            out.extend_from_slice(format!("#{byte:02X}").as_bytes());
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn temp_pdf(name: &str) -> std::path::PathBuf {
+        std::env::temp_dir().join(format!("pdfbull_{name}_{}.pdf", std::process::id()))
+    }
+
+    #[test]
+    fn test_write_object_escapes() {
+        let mut out = Vec::new();
+        let mut dict = Dictionary::new();
+        dict.set("A B", Object::string_literal("(x)"));
+        dict.set("N", Object::Array(vec![Object::Real(1.5), Object::Null]));
+        write_object(&mut out, &Object::Dictionary(dict)).unwrap();
+        assert_eq!(out, b"<</A#20B <287829>/N [1.5 null]>>");
+    }
+
+    #[test]
+    fn test_append_update_adds_annotation() {
+        let path = temp_pdf("incremental_save");
+        std::fs::copy("tests/test_document.pdf", &path).unwrap();
+        let original_len = std::fs::metadata(&path).unwrap().len();
+
+        let mut doc = load_structure(path.to_str().unwrap()).unwrap();
+        let page_id = doc.get_pages()[&1];
+        let mut annot = Dictionary::new();
+        annot.set("Type", Object::Name(b"Annot".to_vec()));
+        annot.set("Subtype", Object::Name(b"Text".to_vec()));
+        annot.set("Contents", Object::string_literal("note"));
+        let annot_id = doc.add_object(Object::Dictionary(annot));
+        doc.get_object_mut(page_id)
+            .and_then(Object::as_dict_mut)
+            .unwrap()
+            .set("Annots", Object::Array(vec![Object::Reference(annot_id)]));
+        append_update(&path, &doc, &[page_id, annot_id]).unwrap();
+
+        let bytes = std::fs::read(&path).unwrap();
+        let before = std::fs::read("tests/test_document.pdf").unwrap();
+        assert_eq!(
+            &bytes[..original_len as usize],
+            &before[..],
+            "file only appended to"
+        );
+
+        let reloaded = Document::load(&path).unwrap();
+        let page = reloaded.get_dictionary(reloaded.get_pages()[&1]).unwrap();
+        let annots = page.get(b"Annots").and_then(Object::as_array).unwrap();
+        let annot = reloaded
+            .get_dictionary(annots[0].as_reference().unwrap())
+            .unwrap();
+        assert_eq!(
+            annot.get(b"Contents").and_then(Object::as_str).unwrap(),
+            b"note"
+        );
+        assert!(page.get(b"Contents").is_ok(), "page content still resolves");
+
+        let _ = std::fs::remove_file(&path);
+    }
+}
@@ -0,0 +1,222 @@
+//! Which optional content groups (layers) each page can draw, so a layer
+//! toggle only affects the renders of pages that reference the group.
+
+use lopdf::{Document, Object, ObjectId};
+use std::collections::{BTreeSet, HashSet};
+
+/// Bounds the walk up the page tree for inherited `/Resources`.
+const MAX_TREE_DEPTH: usize = 64;
+/// Keys leading back up the page tree rather than into what a page draws.
+const BACK_LINKS: [&[u8]; 2] = [b"Parent", b"P"];
+
+/// Groups referenced from each page's resources and annotations, directly,
+/// through an optional content membership dictionary or from nested form
+/// XObjects, indexed by page. `None` if the file cannot be read or lopdf
+/// finds other than `page_count` pages, in which case callers must assume
+/// every page uses every group.
+pub fn page_layers(path: &str, page_count: usize) -> Option<Vec<Vec<(u32, u16)>>> {
+    let doc = Document::load_filtered(path, strip_stream_content).ok()?;
+    let groups = optional_content_groups(&doc);
+    let pages = doc.get_pages();
+    if pages.len() != page_count {
+        tracing::debug!(
+            "Layer index of {path} skipped: {} pages, expected {page_count}",
+            pages.len()
+        );
+        return None;
+    }
+    if groups.is_empty() {
+        return Some(vec![Vec::new(); pages.len()]);
+    }
+    Some(
+        pages
+            .values()
+            .map(|&page_id| referenced_groups(&doc, page_id, &groups))
+            .collect(),
+    )
+}
+
+/// Stream data is never needed to find references; object streams are kept
+/// so the dictionaries packed inside them still load.
+fn strip_stream_content(id: ObjectId, object: &mut Object) -> Option<(ObjectId, Object)> {
+    if let Object::Stream(stream) = object
+        && !stream.dict.type_is(b"ObjStm")
+    {
+        stream.content.clear();
+    }
+    Some((id, std::mem::replace(object, Object::Null)))
+}
+
+/// `/OCProperties/OCGs` of the catalog.
+fn optional_content_groups(doc: &Document) -> HashSet<ObjectId> {
+    let resolve = |object: &Object| {
+        doc.dereference(object)
+            .map(|(_, resolved)| resolved.clone())
+            .ok()
+    };
+    doc.catalog()
+        .ok()
+        .and_then(|catalog| catalog.get(b"OCProperties").ok())
+        .and_then(resolve)
+        .and_then(|properties| properties.as_dict().ok()?.get(b"OCGs").ok().cloned())
+        .and_then(|ocgs| resolve(&ocgs))
+        .and_then(|ocgs| {
+            ocgs.as_array().ok().map(|items| {
+                items
+                    .iter()
+                    .filter_map(|item| item.as_reference().ok())
+                    .collect()
+            })
+        })
+        .unwrap_or_default()
+}
+
+fn referenced_groups(
+    doc: &Document,
+    page_id: ObjectId,
+    groups: &HashSet<ObjectId>,
+) -> Vec<(u32, u16)> {
+    let Ok(page) = doc.get_dictionary(page_id) else {
+        return Vec::new();
+    };
+    let mut stack: Vec<&Object> = page.get(b"Annots").ok().into_iter().collect();
+    stack.extend(inherited_resources(doc, page_id));
+
+    let mut found = BTreeSet::new();
+    let mut seen = HashSet::new();
+    while let Some(object) = stack.pop() {
+        match object {
+            Object::Reference(id) if groups.contains(id) => {
+                found.insert(*id);
+            }
+            Object::Reference(id) => {
+                if seen.insert(*id)
+                    && let Ok(target) = doc.get_object(*id)
+                {
+                    stack.push(target);
+                }
+            }
+            Object::Array(items) => stack.extend(items),
+            Object::Dictionary(dict) => stack.extend(
+                dict.iter()
+                    .filter(|(key, _)| !BACK_LINKS.contains(&key.as_slice()))
+                    .map(|(_, value)| value),
+            ),
+            Object::Stream(stream) => stack.extend(
+                stream
+                    .dict
+                    .iter()
+                    .filter(|(key, _)| !BACK_LINKS.contains(&key.as_slice()))
+                    .map(|(_, value)| value),
+            ),
+            _ => {}
+        }
+    }
+    found.into_iter().collect()
+}
+
+fn inherited_resources(doc: &Document, page_id: ObjectId) -> Option<&Object> {
+    let mut node = doc.get_dictionary(page_id).ok()?;
+    for _ in 0..MAX_TREE_DEPTH {
+        if let Ok(resources) = node.get(b"Resources") {
+            return Some(resources);
+        }
+        let parent = node.get(b"Parent").and_then(Object::as_reference).ok()?;
+        node = doc.get_dictionary(parent).ok()?;
+    }
+    None
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use lopdf::{Dictionary, Stream};
+
+    /// Three pages: one marking content with a group, one drawing a form
+    /// XObject whose membership dictionary names another, and a plain one.
+    fn layered_pdf() -> std::path::PathBuf {
+        let mut doc = Document::with_version("1.7");
+        let ocg = |doc: &mut Document, name: &str| {
+            let mut dict = Dictionary::new();
+            dict.set("Type", Object::Name(b"OCG".to_vec()));
+            dict.set("Name", Object::string_literal(name));
+            doc.add_object(dict)
+        };
+        let walls = ocg(&mut doc, "Walls");
+        let wiring = ocg(&mut doc, "Wiring");
+
+        let mut ocmd = Dictionary::new();
+        ocmd.set("Type", Object::Name(b"OCMD".to_vec()));
+        ocmd.set("OCGs", Object::Array(vec![Object::Reference(wiring)]));
+        let mut form = Dictionary::new();
+        form.set("Subtype", Object::Name(b"Form".to_vec()));
+        form.set("OC", Object::Dictionary(ocmd));
+        let form_id = doc.add_object(Stream::new(form, b"0 0 m 1 1 l S".to_vec()));
+
+        let pages_id = doc.new_object_id();
+        let page = |doc: &mut Document, resources: Dictionary| {
+            let mut dict = Dictionary::new();
+            dict.set("Type", Object::Name(b"Page".to_vec()));
+            dict.set("Parent", Object::Reference(pages_id));
+            dict.set("Resources", Object::Dictionary(resources));
+            Object::Reference(doc.add_object(dict))
+        };
+        let mut properties = Dictionary::new();
+        properties.set("MC0", Object::Reference(walls));
+        let mut with_properties = Dictionary::new();
+        with_properties.set("Properties", Object::Dictionary(properties));
+        let mut xobjects = Dictionary::new();
+        xobjects.set("Fm0", Object::Reference(form_id));
+        let mut with_form = Dictionary::new();
+        with_form.set("XObject", Object::Dictionary(xobjects));
+        let kids = vec![
+            page(&mut doc, with_properties),
+            page(&mut doc, with_form),
+            page(&mut doc, Dictionary::new()),
+        ];
+
+        let mut pages = Dictionary::new();
+        pages.set("Type", Object::Name(b"Pages".to_vec()));
+        pages.set("Count", Object::Integer(kids.len() as i64));
+        pages.set("Kids", Object::Array(kids));
+        doc.objects.insert(pages_id, Object::Dictionary(pages));
+
+        let mut oc_properties = Dictionary::new();
+        oc_properties.set(
+            "OCGs",
+            Object::Array(vec![Object::Reference(walls), Object::Reference(wiring)]),
+        );
+        let mut catalog = Dictionary::new();
+        catalog.set("Type", Object::Name(b"Catalog".to_vec()));
+        catalog.set("Pages", Object::Reference(pages_id));
+        catalog.set("OCProperties", Object::Dictionary(oc_properties));
+        let catalog_id = doc.add_object(catalog);
+        doc.trailer.set("Root", Object::Reference(catalog_id));
+
+        let path =
+            std::env::temp_dir().join(format!("pdfbull_layer_index_{}.pdf", std::process::id()));
+        doc.save(&path).unwrap();
+        path
+    }
+
+    #[test]
+    fn test_page_layers_follows_properties_and_forms() {
+        let path = layered_pdf();
+        let layers = page_layers(path.to_str().unwrap(), 3).unwrap();
+        assert!(page_layers(path.to_str().unwrap(), 4).is_none());
+        let _ = std::fs::remove_file(&path);
+
+        assert_eq!(layers.len(), 3);
+        assert_eq!(layers[0].len(), 1);
+        assert_eq!(layers[1].len(), 1);
+        assert_ne!(layers[0], layers[1], "each page names its own group");
+        assert!(layers[2].is_empty());
+    }
+
+    #[test]
+    fn test_page_layers_without_optional_content() {
+        let layers = page_layers("tests/test_document.pdf").unwrap();
+        assert!(layers.iter().all(Vec::is_empty));
+        assert!(page_layers("tests/missing.pdf").is_none());
+    }
+}
@@ -49,16 +49,27 @@ static GLOBAL: mimalloc::MiMalloc = mimalloc::MiMalloc;
 
 pub mod app;
 pub mod commands;
+pub mod disk_cache;
+pub mod doc_ops;
 pub mod engine;
+pub mod incremental_save;
+pub mod layer_index;
+pub mod memory;
 pub mod message;
+pub mod metrics;
 pub mod models;
+pub mod optimize;
+pub mod overlay_cache;
 pub mod pdf_engine;
 pub mod platform;
+pub mod rle;
 pub mod storage;
+pub mod text_index;
 pub mod ui;
 pub mod ui_document;
 pub mod ui_keyboard_help;
 pub mod ui_metadata;
+pub mod ui_metrics;
 pub mod ui_settings;
 pub mod ui_welcome;
 pub mod update;
@@ -0,0 +1,148 @@
+//! One budget for the memory the app keeps resident: the engine's render
+//! cache, the bitmaps and text layers each tab holds for iced, and the open
+//! documents themselves. `plan` decides what to give back when the total
+//! runs over, background tabs first; the app applies it every
+//! `CHECK_INTERVAL` and whenever the active tab changes.
+
+use crate::models::DocumentId;
+use iced::widget::image as iced_image;
+use std::time::Duration;
+
+pub const CHECK_INTERVAL: Duration = Duration::from_secs(5);
+/// Below this share of physical memory available, the system is treated as
+/// short on memory and the governor sheds down to a fraction of the budget.
+pub const LOW_MEMORY_PERCENT: u8 = 10;
+/// Under memory pressure the target is the budget divided by this.
+const PRESSURE_TARGET_DIVISOR: u64 = 2;
+
+/// What one tab keeps resident.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct TabUsage {
+    pub id: DocumentId,
+    /// Page bitmaps, tiles, thumbnails and text layers; all can be rebuilt.
+    pub view_bytes: u64,
+    /// The parsed document, approximated by its file size; held while the
+    /// tab is open.
+    pub document_bytes: u64,
+}
+
+#[derive(Debug, Default, PartialEq, Eq)]
+pub struct MemoryPlan {
+    /// Background tabs to drop everything rebuildable from, least recently
+    /// used first.
+    pub release_tabs: Vec<DocumentId>,
+    /// Bytes the engine's render cache should shrink to.
+    pub engine_target: Option<u64>,
+    /// Whether the active tab keeps only what is on screen.
+    pub trim_active: bool,
+}
+
+/// Fits `engine_bytes` plus every tab's usage into `budget_bytes`, or half
+/// of it when `low_memory`. `background` is ordered least recently used
+/// first. Background tabs go first, then the engine cache, and the active
+/// tab is trimmed to its viewport only when neither is enough.
+pub fn plan(
+    budget_bytes: u64,
+    engine_bytes: u64,
+    active: Option<TabUsage>,
+    background: &[TabUsage],
+    low_memory: bool,
+) -> MemoryPlan {
+    let target = if low_memory {
+        budget_bytes / PRESSURE_TARGET_DIVISOR
+    } else {
+        budget_bytes
+    };
+    let tabs = active.iter().chain(background);
+    let mut total = engine_bytes
+        + tabs
+            .map(|tab| tab.view_bytes + tab.document_bytes)
+            .sum::<u64>();
+
+    let mut plan = MemoryPlan::default();
+    for tab in background {
+        if total <= target {
+            return plan;
+        }
+        if tab.view_bytes > 0 {
+            total -= tab.view_bytes;
+            plan.release_tabs.push(tab.id);
+        }
+    }
+    if total > target {
+        let freed = (total - target).min(engine_bytes);
+        plan.engine_target = Some(engine_bytes - freed);
+        total -= freed;
+    }
+    plan.trim_active = total > target && active.is_some_and(|tab| tab.view_bytes > 0);
+    plan
+}
+
+/// Whether the OS reports memory running low.
+pub fn low_memory() -> bool {
+    crate::platform::available_memory_percent().is_some_and(|free| free < LOW_MEMORY_PERCENT)
+}
+
+/// Pixel bytes behind an iced image handle that only the UI holds. A
+/// buffer still shared with the engine's render cache is counted there, and
+/// dropping the handle would not free it. File-backed handles are decoded
+/// and held by the renderer, so they are not counted here.
+pub fn handle_bytes(handle: &iced_image::Handle) -> u64 {
+    match handle {
+        iced_image::Handle::Rgba { pixels, .. } | iced_image::Handle::Bytes(_, pixels) => {
+            if pixels.is_unique() {
+                pixels.len() as u64
+            } else {
+                0
+            }
+        }
+        iced_image::Handle::Path(..) => 0,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const MB: u64 = 1024 * 1024;
+
+    fn tab(id: u64, view_mb: u64) -> TabUsage {
+        TabUsage {
+            id: DocumentId(id),
+            view_bytes: view_mb * MB,
+            document_bytes: MB,
+        }
+    }
+
+    #[test]
+    fn test_plan_within_budget_frees_nothing() {
+        let plan = plan(100 * MB, 40 * MB, Some(tab(1, 20)), &[tab(2, 20)], false);
+        assert_eq!(plan, MemoryPlan::default());
+    }
+
+    #[test]
+    fn test_plan_releases_least_recent_background_tabs_first() {
+        let background = [tab(2, 30), tab(3, 30), tab(4, 30)];
+        let plan = plan(100 * MB, 20 * MB, Some(tab(1, 20)), &background, false);
+        assert_eq!(plan.release_tabs, vec![DocumentId(2), DocumentId(3)]);
+        assert_eq!(plan.engine_target, None);
+        assert!(!plan.trim_active);
+    }
+
+    #[test]
+    fn test_handle_bytes_skips_buffers_shared_with_the_cache() {
+        let cached = bytes::Bytes::from(vec![0u8; 16]);
+        let handle = iced_image::Handle::from_rgba(2, 2, cached.clone());
+        assert_eq!(handle_bytes(&handle), 0);
+        drop(cached);
+        assert_eq!(handle_bytes(&handle), 16);
+    }
+
+    #[test]
+    fn test_plan_under_pressure_trims_engine_then_active_tab() {
+        let plan = plan(40 * MB, 10 * MB, Some(tab(1, 30)), &[tab(2, 10)], true);
+        assert_eq!(plan.release_tabs, vec![DocumentId(2)]);
+        assert_eq!(plan.engine_target, Some(0));
+        assert!(plan.trim_active);
+    }
+}
@@ -1,7 +1,7 @@
 use crate::engine::EngineState;
 use crate::models::{
-    AppSettings, DocumentId, DocumentMeta, OpenResult, PdfResult, RecentFile, RenderResult,
-    SearchResultItem, TextItem,
+    AppSettings, DocumentId, DocumentMeta, ExportProgress, OpenResult, PageOverlay, PdfResult,
+    RecentFile, RenderResult, RenderTile, SearchResultItem,
 };
 use crate::pdf_engine::RenderFilter;
 use std::path::PathBuf;
@@ -55,17 +55,24 @@ pub enum Message {
     PageInputSubmitted,
     Search(String),
     PerformSearch(String),
-    SearchResult(DocumentId, PdfResult<Vec<SearchResultItem>>),
+    SearchResult(DocumentId, u64, PdfResult<Vec<SearchResultItem>>),
     NextSearchResult,
     PrevSearchResult,
     ClearSearch,
     DocumentOpened(DocumentId, PdfResult<OpenResult>),
-    PageRendered(DocumentId, usize, f32, PdfResult<RenderResult>),
-    ThumbnailRendered(DocumentId, usize, f32, PdfResult<RenderResult>),
-    TextItemsLoaded(DocumentId, usize, PdfResult<Vec<TextItem>>),
+    /// Render results carry the `DocumentTab::generation` they were requested
+    /// at; those from before a reload are dropped.
+    PageRendered(DocumentId, u64, usize, f32, PdfResult<RenderResult>),
+    /// Low-resolution stand-in shown until the matching `PageRendered` arrives.
+    PagePreviewRendered(DocumentId, u64, usize, PdfResult<RenderResult>),
+    TilesRendered(DocumentId, u64, usize, f32, PdfResult<Vec<RenderTile>>),
+    ThumbnailsRendered(DocumentId, u64, f32, Vec<(usize, PdfResult<RenderResult>)>),
+    /// Text layers and tables of pages that just got pixels.
+    PageOverlaysLoaded(DocumentId, Vec<PageOverlay>),
     DocumentMetaLoaded(DocumentId, PdfResult<DocumentMeta>),
     RequestRender(usize),
-    ViewportChanged(f32, f32),
+    /// Scroll offset and size of the document viewport: `(x, y, width, height)`.
+    ViewportChanged(f32, f32, f32, f32),
     SidebarViewportChanged(f32),
     ExtractText,
     ExtractTextToClipboard,
@@ -80,6 +87,12 @@ pub enum Message {
     SplitPDF(Vec<usize>),
     PDFSplit(PdfResult<Vec<String>>),
     ToggleMetadata,
+    ToggleMetricsOverlay,
+    RefreshMetrics,
+    MetricsCollected(Option<crate::metrics::MetricsSnapshot>),
+    DumpMetrics,
+    CheckMemory,
+    MetricsDumped(Result<PathBuf, String>),
     LoadFormFields,
     FormFieldsLoaded(PdfResult<Vec<crate::models::FormField>>),
     FormFieldChanged(String, crate::models::FormFieldVariant),
@@ -88,6 +101,7 @@ pub enum Message {
     ExportImage,
     ImageExported(PdfResult<String>),
     ExportImages,
+    ImagesExportProgress(ExportProgress),
     Print,
     ListPrinters,
     PrintersListed(PdfResult<Vec<String>>),
@@ -96,7 +110,7 @@ pub enum Message {
     AddWatermark(String),
     WatermarkDone(PdfResult<String>),
     OptimizePDF,
-    PDFOptimized(PdfResult<String>),
+    PDFOptimized(PdfResult<crate::optimize::OptimizeReport>),
     EngineInitialized(EngineState),
     Error(String),
     ClearStatus,
@@ -110,6 +124,7 @@ pub enum Message {
     SetAnnotationThickness(f32),
     SetAnnotationTextSize(f32),
     ReloadDocument(PathBuf),
+    DocumentReloaded(DocumentId, PdfResult<crate::models::ReloadResult>),
     ToggleWatermarkPrompt(bool),
     WatermarkInputChanged(String),
     SubmitWatermark,
@@ -143,10 +158,5 @@ pub enum Message {
     ToggleLayer(usize, bool),
     LayerToggled,
     ToggleTableMode,
-    TablesDetected(
-        crate::models::DocumentId,
-        usize,
-        crate::models::PdfResult<Vec<crate::models::DetectedTable>>,
-    ),
     SetRibbonTab(crate::models::RibbonTab),
 }
@@ -0,0 +1,301 @@
+//! Engine counters and latency histograms. Workers, the scheduler and the
+//! render cache record into one process-wide `Metrics` without locking on
+//! the render path; `PdfCommand::CollectMetrics` turns it into a
+//! `MetricsSnapshot` for the stats overlay and JSON dumps.
+
+use serde::Serialize;
+use std::collections::BTreeMap;
+use std::sync::Mutex;
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::time::Duration;
+
+/// Bucket `i` counts durations below `2^(i+1)` microseconds; the last one
+/// also takes everything longer (over an hour).
+const BUCKETS: usize = 32;
+
+static METRICS: Metrics = Metrics::new();
+
+pub fn metrics() -> &'static Metrics {
+    &METRICS
+}
+
+/// Engine queue a command waits in.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub enum Lane {
+    #[default]
+    Interactive,
+    Heavy,
+}
+
+pub struct Metrics {
+    queue_depth: [AtomicUsize; 2],
+    cache_hits: AtomicU64,
+    compressed_hits: AtomicU64,
+    cache_misses: AtomicU64,
+    cache_evictions: AtomicU64,
+    engine_bytes: AtomicU64,
+    render: Histogram,
+    interpret: Histogram,
+    rasterize: Histogram,
+    commands: Mutex<BTreeMap<&'static str, Histogram>>,
+}
+
+impl Metrics {
+    const fn new() -> Self {
+        Self {
+            queue_depth: [AtomicUsize::new(0), AtomicUsize::new(0)],
+            cache_hits: AtomicU64::new(0),
+            compressed_hits: AtomicU64::new(0),
+            cache_misses: AtomicU64::new(0),
+            cache_evictions: AtomicU64::new(0),
+            engine_bytes: AtomicU64::new(0),
+            render: Histogram::new(),
+            interpret: Histogram::new(),
+            rasterize: Histogram::new(),
+            commands: Mutex::new(BTreeMap::new()),
+        }
+    }
+
+    pub fn set_queue_depth(&self, lane: Lane, depth: usize) {
+        self.queue_depth[lane as usize].store(depth, Ordering::Relaxed);
+    }
+
+    pub fn cache_hit(&self) {
+        self.cache_hits.fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// A hit served by decompressing a bitmap from the compressed tier; also
+    /// counted by `cache_hit`.
+    pub fn compressed_hit(&self) {
+        self.compressed_hits.fetch_add(1, Ordering::Relaxed);
+    }
+
+    pub fn cache_miss(&self) {
+        self.cache_misses.fetch_add(1, Ordering::Relaxed);
+    }
+
+    pub fn cache_evictions(&self, count: usize) {
+        self.cache_evictions
+            .fetch_add(count as u64, Ordering::Relaxed);
+    }
+
+    /// Bytes the render cache holds across its tiers, published by the cache
+    /// as it changes so the UI's memory governor can read it without a
+    /// round trip to the engine.
+    pub fn set_engine_bytes(&self, bytes: u64) {
+        self.engine_bytes.store(bytes, Ordering::Relaxed);
+    }
+
+    pub fn engine_bytes(&self) -> u64 {
+        self.engine_bytes.load(Ordering::Relaxed)
+    }
+
+    /// Whole `render_page` call, cache lookups included.
+    pub fn record_render(&self, elapsed: Duration) {
+        self.render.record(elapsed);
+    }
+
+    /// Content stream interpretation into a display list.
+    pub fn record_interpret(&self, elapsed: Duration) {
+        self.interpret.record(elapsed);
+    }
+
+    /// Display list rasterization into a bitmap.
+    pub fn record_rasterize(&self, elapsed: Duration) {
+        self.rasterize.record(elapsed);
+    }
+
+    /// Time a worker spent handling one command of kind `name`.
+    pub fn record_command(&self, name: &'static str, elapsed: Duration) {
+        self.commands
+            .lock()
+            .unwrap_or_else(std::sync::PoisonError::into_inner)
+            .entry(name)
+            .or_insert_with(Histogram::new)
+            .record(elapsed);
+    }
+
+    /// Everything counted so far. Cache sizes are filled in by the caller,
+    /// which owns the cache and the documents.
+    pub fn snapshot(&self) -> MetricsSnapshot {
+        let load = |counter: &AtomicU64| counter.load(Ordering::Relaxed);
+        MetricsSnapshot {
+            interactive_queue: self.queue_depth[Lane::Interactive as usize].load(Ordering::Relaxed),
+            heavy_queue: self.queue_depth[Lane::Heavy as usize].load(Ordering::Relaxed),
+            cache_hits: load(&self.cache_hits),
+            compressed_hits: load(&self.compressed_hits),
+            cache_misses: load(&self.cache_misses),
+            cache_evictions: load(&self.cache_evictions),
+            render: self.render.summary(),
+            interpret: self.interpret.summary(),
+            rasterize: self.rasterize.summary(),
+            commands: self
+                .commands
+                .lock()
+                .unwrap_or_else(std::sync::PoisonError::into_inner)
+                .iter()
+                .map(|(name, histogram)| (*name, histogram.summary()))
+                .collect(),
+            ..MetricsSnapshot::default()
+        }
+    }
+}
+
+/// Log2-bucketed latency histogram; percentiles are bucket upper bounds.
+pub struct Histogram {
+    buckets: [AtomicU64; BUCKETS],
+    count: AtomicU64,
+    total_us: AtomicU64,
+    max_us: AtomicU64,
+}
+
+impl Histogram {
+    pub const fn new() -> Self {
+        Self {
+            buckets: [const { AtomicU64::new(0) }; BUCKETS],
+            count: AtomicU64::new(0),
+            total_us: AtomicU64::new(0),
+            max_us: AtomicU64::new(0),
+        }
+    }
+
+    pub fn record(&self, elapsed: Duration) {
+        let us = u64::try_from(elapsed.as_micros()).unwrap_or(u64::MAX);
+        let bucket = (u64::BITS - (us >> 1).leading_zeros()) as usize;
+        self.buckets[bucket.min(BUCKETS - 1)].fetch_add(1, Ordering::Relaxed);
+        self.count.fetch_add(1, Ordering::Relaxed);
+        self.total_us.fetch_add(us, Ordering::Relaxed);
+        self.max_us.fetch_max(us, Ordering::Relaxed);
+    }
+
+    pub fn summary(&self) -> LatencySummary {
+        let count = self.count.load(Ordering::Relaxed);
+        if count == 0 {
+            return LatencySummary::default();
+        }
+        let counts: Vec<u64> = self
+            .buckets
+            .iter()
+            .map(|bucket| bucket.load(Ordering::Relaxed))
+            .collect();
+        let max_ms = self.max_us.load(Ordering::Relaxed) as f64 / 1000.0;
+        let percentile = |fraction: f64| {
+            let rank = (count as f64 * fraction).ceil() as u64;
+            let mut seen = 0;
+            for (i, &n) in counts.iter().enumerate() {
+                seen += n;
+                if seen >= rank {
+                    return ((1u64 << (i + 1)) as f64 / 1000.0).min(max_ms);
+                }
+            }
+            max_ms
+        };
+        LatencySummary {
+            count,
+            mean_ms: self.total_us.load(Ordering::Relaxed) as f64 / count as f64 / 1000.0,
+            p50_ms: percentile(0.5),
+            p95_ms: percentile(0.95),
+            max_ms,
+        }
+    }
+}
+
+impl Default for Histogram {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+#[derive(Debug, Clone, Copy, Default, PartialEq, Serialize)]
+pub struct LatencySummary {
+    pub count: u64,
+    pub mean_ms: f64,
+    pub p50_ms: f64,
+    pub p95_ms: f64,
+    pub max_ms: f64,
+}
+
+#[derive(Debug, Clone, Default, Serialize)]
+pub struct MetricsSnapshot {
+    pub interactive_queue: usize,
+    pub heavy_queue: usize,
+    pub cache_hits: u64,
+    pub compressed_hits: u64,
+    pub cache_misses: u64,
+    pub cache_evictions: u64,
+    /// Bytes held by the raw and the compressed render-cache tiers.
+    pub cache_bytes: u64,
+    pub compressed_bytes: u64,
+    /// Render-cache bytes of each open document, by `DocumentId`.
+    pub document_bytes: BTreeMap<u64, u64>,
+    pub render: LatencySummary,
+    pub interpret: LatencySummary,
+    pub rasterize: LatencySummary,
+    pub commands: BTreeMap<&'static str, LatencySummary>,
+}
+
+impl MetricsSnapshot {
+    /// Share of renders served from a cache tier, in percent.
+    pub fn hit_rate(&self) -> f64 {
+        let lookups = self.cache_hits + self.cache_misses;
+        if lookups == 0 {
+            0.0
+        } else {
+            self.cache_hits as f64 * 100.0 / lookups as f64
+        }
+    }
+}
+
+/// Writes `snapshot` as pretty JSON to a timestamped file in the config
+/// directory, returning its path.
+pub fn dump(snapshot: &MetricsSnapshot) -> std::io::Result<std::path::PathBuf> {
+    let stamp = std::time::SystemTime::now()
+        .duration_since(std::time::UNIX_EPOCH)
+        .map(|elapsed| elapsed.as_secs())
+        .unwrap_or_default();
+    let path = crate::storage::get_config_dir().join(format!("metrics-{stamp}.json"));
+    let json = serde_json::to_vec_pretty(snapshot).map_err(std::io::Error::other)?;
+    std::fs::write(&path, json)?;
+    Ok(path)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_histogram_summary() {
+        let histogram = Histogram::new();
+        assert_eq!(histogram.summary(), LatencySummary::default());
+
+        for ms in [1, 1, 1, 1, 1, 1, 1, 1, 1, 40] {
+            histogram.record(Duration::from_millis(ms));
+        }
+        let summary = histogram.summary();
+        assert_eq!(summary.count, 10);
+        assert!((summary.mean_ms - 4.9).abs() < 1e-9);
+        assert!(summary.p50_ms >= 1.0 && summary.p50_ms < 2.1, "{summary:?}");
+        assert!((summary.p95_ms - 40.0).abs() < 1e-9, "capped at the max");
+        assert!((summary.max_ms - 40.0).abs() < 1e-9);
+    }
+
+    #[test]
+    fn test_histogram_extremes_land_in_range() {
+        let histogram = Histogram::new();
+        histogram.record(Duration::ZERO);
+        histogram.record(Duration::from_secs(100_000));
+        assert_eq!(histogram.summary().count, 2);
+    }
+
+    #[test]
+    fn test_hit_rate() {
+        let snapshot = MetricsSnapshot {
+            cache_hits: 8,
+            compressed_hits: 2,
+            cache_misses: 2,
+            ..MetricsSnapshot::default()
+        };
+        assert!((snapshot.hit_rate() - 80.0).abs() < 1e-9);
+        assert!(MetricsSnapshot::default().hit_rate().abs() < 1e-9);
+    }
+}
@@ -2,7 +2,6 @@ use crate::pdf_engine::RenderFilter;
 use iced::widget::image as iced_image;
 use serde::{Deserialize, Serialize};
 use std::path::PathBuf;
-use std::sync::Arc;
 use thiserror::Error;
 
 #[derive(Error, Debug, Clone, PartialEq, Eq)]
@@ -72,6 +71,12 @@ impl From<String> for PdfError {
     }
 }
 
+impl From<std::io::Error> for PdfError {
+    fn from(e: std::io::Error) -> Self {
+        Self::IoError(e.to_string())
+    }
+}
+
 impl PartialEq<&str> for PdfError {
     fn eq(&self, other: &&str) -> bool {
         match self {
@@ -138,25 +143,48 @@ pub struct DetectedTable {
     pub cells: Vec<Vec<String>>,
 }
 
+/// Text layer and table candidates of one page, fetched together once the
+/// page has pixels; a field is `None` when it was not asked for.
+#[derive(Debug, Clone)]
+pub struct PageOverlay {
+    pub page: usize,
+    pub text_items: Option<PdfResult<Vec<TextItem>>>,
+    pub tables: Option<PdfResult<Vec<DetectedTable>>>,
+}
+
 #[derive(Debug, Clone)]
+/// What `Open` returns before any per-page walk; `page_heights` past the
+/// first screen are estimates until `DocumentMeta` arrives.
 pub struct OpenResult {
     pub id: DocumentId,
     pub page_count: usize,
     pub page_heights: Vec<f32>,
     pub max_width: f32,
-    pub outline: Vec<crate::pdf_engine::Bookmark>,
-    pub links: Vec<Hyperlink>,
     pub metadata: DocumentMetadata,
-    pub page_labels: Vec<String>,
     pub is_encrypted: bool,
-    pub signatures: Vec<SignatureInfo>,
-    pub attachments: Vec<AttachmentInfo>,
-    pub layers: Vec<LayerInfo>,
-    pub oc_config: Option<zpdf::OcConfig>,
+    /// Stamped on render requests so results from before a reload are dropped.
+    pub generation: u64,
+    /// Size of the file on disk, standing in for the parsed document's
+    /// footprint in the memory budget.
+    pub file_bytes: u64,
+    /// `text_index::file_fingerprint` of the file as the engine read it;
+    /// `None` for encrypted documents, whose layout is never snapshotted.
+    pub fingerprint: Option<u64>,
+}
+
+/// What `Reload` returns after re-reading a file that changed on disk.
+#[derive(Debug, Clone)]
+pub struct ReloadResult {
+    pub open: OpenResult,
+    /// Pages whose content differs from the previous revision, plus any
+    /// pages it did not have. Every other page keeps its cached renders.
+    pub changed_pages: Vec<usize>,
 }
 
 #[derive(Debug, Clone)]
 pub struct DocumentMeta {
+    pub page_heights: Vec<f32>,
+    pub max_width: f32,
     pub outline: Vec<crate::pdf_engine::Bookmark>,
     pub links: Vec<Hyperlink>,
     pub metadata: DocumentMetadata,
@@ -181,7 +209,35 @@ pub struct TextItem {
 pub struct RenderResult {
     pub width: u32,
     pub height: u32,
-    pub data: Arc<[u8]>,
+    /// RGBA pixels. Reference-counted, so cache hits, clones and the iced
+    /// handle built by `to_handle` all share one allocation.
+    pub data: bytes::Bytes,
+}
+
+impl RenderResult {
+    /// An iced image handle backed by this result's buffer, without copying.
+    pub fn to_handle(&self) -> iced_image::Handle {
+        iced_image::Handle::from_rgba(self.width, self.height, self.data.clone())
+    }
+}
+
+/// One page finished by a batch image export; `written` is the file saved,
+/// or `None` if the page failed. `failed` counts failures so far.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct ExportProgress {
+    pub done: usize,
+    pub total: usize,
+    pub failed: usize,
+    pub written: Option<String>,
+}
+
+/// One tile of a page rendered in tiled mode; edge tiles may be smaller than
+/// `TILE_SIZE`.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct RenderTile {
+    pub col: u32,
+    pub row: u32,
+    pub result: RenderResult,
 }
 
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -256,6 +312,7 @@ pub enum ReadingMode {
 }
 
 #[derive(Debug, Clone, Serialize, Deserialize)]
+#[serde(default)]
 pub struct AppSettings {
     pub theme: AppTheme,
     pub cache_size: usize,
@@ -267,6 +324,30 @@ pub struct AppSettings {
     pub remember_last_file: bool,
     pub default_zoom: f32,
     pub auto_save: bool,
+    pub persist_text_index: bool,
+    /// Memory the prefetcher may spend on pages ahead of the viewport, in MB;
+    /// 0 disables prefetch.
+    pub prefetch_memory_mb: usize,
+    /// Show a quick low-resolution preview of a page while its full render runs.
+    pub progressive_render: bool,
+    /// Disk space for cached thumbnails and page renders, in MB; 0 disables it.
+    pub disk_cache_mb: usize,
+    /// oxipng preset for batch image export, 0-6; 0 skips optimization.
+    pub export_png_level: u8,
+    /// Resolution Optimize PDF downsamples images to; 0 keeps their pixels.
+    pub optimize_image_dpi: u32,
+    /// JPEG quality of images Optimize PDF re-encodes, 1-100.
+    pub optimize_jpeg_quality: u8,
+    /// Engine threads serving renders and other interactive requests; 0
+    /// sizes the pool from the CPU count.
+    pub render_workers: usize,
+    /// Document operations such as merge, optimize or export that may run
+    /// at once, each on a thread of its own.
+    pub heavy_jobs: usize,
+    pub render_backend: crate::pdf_engine::RasterBackend,
+    /// Memory the whole app aims to stay within, in MB: the render cache,
+    /// every tab's bitmaps and text layers, and open documents.
+    pub memory_budget_mb: usize,
 }
 
 impl Default for AppSettings {
@@ -282,6 +363,17 @@ impl Default for AppSettings {
             remember_last_file: true,
             default_zoom: 1.0,
             auto_save: true,
+            persist_text_index: true,
+            prefetch_memory_mb: 64,
+            progressive_render: true,
+            disk_cache_mb: 256,
+            export_png_level: 2,
+            optimize_image_dpi: 150,
+            optimize_jpeg_quality: 75,
+            render_workers: 0,
+            heavy_jobs: 1,
+            render_backend: crate::pdf_engine::RasterBackend::Cpu,
+            memory_budget_mb: 1024,
         }
     }
 }
@@ -301,6 +393,20 @@ pub struct TabSession {
     pub viewport_y: f32,
     pub rotation: i32,
     pub auto_crop: bool,
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub snapshot: Option<TabSnapshot>,
+}
+
+/// A document's layout as last shown, saved with the session so a restored
+/// tab can be laid out, scrolled and painted before its file is parsed.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct TabSnapshot {
+    /// `text_index::file_fingerprint` when saved; the snapshot is ignored
+    /// once the file changes.
+    pub fingerprint: u64,
+    pub page_heights: Vec<f32>,
+    pub page_width: f32,
+    pub outline: Vec<crate::pdf_engine::Bookmark>,
 }
 
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -442,15 +548,32 @@ pub struct AnnotationDrag {
 }
 
 pub struct TabViewState {
+    /// Page bitmaps with the zoom they were rendered at. Progressive previews
+    /// are stored at scale 0.0 so they never count as rendered.
     pub rendered_pages: std::collections::HashMap<usize, (f32, iced_image::Handle)>,
+    /// Tiles of pages too large to render whole, keyed by `(page, column, row)`.
+    pub rendered_tiles: std::collections::HashMap<(usize, u32, u32), (f32, iced_image::Handle)>,
     pub thumbnails: std::collections::HashMap<usize, iced_image::Handle>,
     pub text_layers: std::collections::HashMap<usize, Vec<TextItem>>,
     pub detected_tables: std::collections::HashMap<usize, Vec<DetectedTable>>,
+    /// Retained canvas geometry of the overlays of pages on screen.
+    pub overlays: crate::overlay_cache::OverlayCaches,
+    pub viewport_x: f32,
     pub viewport_y: f32,
+    pub viewport_width: f32,
     pub viewport_height: f32,
     pub sidebar_viewport_y: f32,
     pub last_cleanup_time: std::time::Instant,
+    /// When the tab was last seen active; orders background tabs for the
+    /// memory governor.
+    pub last_active: std::time::Instant,
     pub visible_range: (usize, usize),
+    /// Pages last requested ahead of the viewport; kept alongside the visible range.
+    pub prefetch_range: (usize, usize),
+    /// Smoothed scroll speed in layout pixels per second.
+    pub scroll_speed: f32,
+    pub scrolling_forward: bool,
+    pub last_scroll_time: std::time::Instant,
     pub is_loading: bool,
 }
 
@@ -458,23 +581,198 @@ impl Default for TabViewState {
     fn default() -> Self {
         Self {
             rendered_pages: std::collections::HashMap::new(),
+            rendered_tiles: std::collections::HashMap::new(),
             thumbnails: std::collections::HashMap::new(),
             text_layers: std::collections::HashMap::new(),
             detected_tables: std::collections::HashMap::new(),
+            overlays: crate::overlay_cache::OverlayCaches::default(),
+            viewport_x: 0.0,
             viewport_y: 0.0,
+            viewport_width: 0.0,
             viewport_height: 800.0,
             sidebar_viewport_y: 0.0,
             last_cleanup_time: std::time::Instant::now()
                 .checked_sub(std::time::Duration::from_secs(10))
                 .unwrap_or_else(std::time::Instant::now),
+            last_active: std::time::Instant::now(),
             visible_range: (0, 1),
+            prefetch_range: (0, 0),
+            scroll_speed: 0.0,
+            scrolling_forward: true,
+            last_scroll_time: std::time::Instant::now(),
             is_loading: false,
         }
     }
 }
 
+impl TabViewState {
+    /// Drops every page bitmap and tile, e.g. after a filter or rotation change.
+    pub fn clear_rendered(&mut self) {
+        self.rendered_pages.clear();
+        self.rendered_tiles.clear();
+    }
+
+    /// Bytes held for display: bitmaps, tiles, thumbnails, text layers and
+    /// detected tables.
+    pub fn resident_bytes(&self) -> u64 {
+        let handles = self
+            .rendered_pages
+            .values()
+            .chain(self.rendered_tiles.values())
+            .map(|(_, handle)| handle)
+            .chain(self.thumbnails.values())
+            .map(crate::memory::handle_bytes)
+            .sum::<u64>();
+        let text = self
+            .text_layers
+            .values()
+            .flatten()
+            .map(|item| std::mem::size_of::<TextItem>() + item.text.len())
+            .sum::<usize>();
+        let tables = self
+            .detected_tables
+            .values()
+            .flatten()
+            .map(|table| table.csv.len() + table.tsv.len())
+            .sum::<usize>();
+        handles + (text + tables) as u64
+    }
+
+    /// Drops everything `resident_bytes` counts; it is all re-requested when
+    /// the tab is shown again.
+    pub fn release_resident(&mut self) {
+        self.clear_rendered();
+        self.thumbnails.clear();
+        self.text_layers.clear();
+        self.detected_tables.clear();
+        self.overlays.clear();
+    }
+
+    /// Drops everything derived from `pages` and from pages at or past
+    /// `page_count`, after the document changed underneath them.
+    pub fn forget_pages(&mut self, pages: &std::collections::HashSet<usize>, page_count: usize) {
+        let stale = |page: usize| page >= page_count || pages.contains(&page);
+        self.rendered_pages.retain(|&page, _| !stale(page));
+        self.rendered_tiles.retain(|&(page, _, _), _| !stale(page));
+        self.thumbnails.retain(|&page, _| !stale(page));
+        self.text_layers.retain(|&page, _| !stale(page));
+        self.detected_tables.retain(|&page, _| !stale(page));
+        self.overlays.retain(|page| !stale(page));
+    }
+
+    /// Records a new vertical scroll offset and updates the scroll direction
+    /// and smoothed speed used to aim prefetch.
+    pub fn track_scroll(&mut self, y: f32) {
+        let now = std::time::Instant::now();
+        let elapsed = now.duration_since(self.last_scroll_time).as_secs_f32();
+        let delta = y - self.viewport_y;
+        if delta.abs() > f32::EPSILON {
+            self.scrolling_forward = delta > 0.0;
+        }
+        self.scroll_speed = if elapsed > 0.0 && elapsed < SCROLL_IDLE_SECS {
+            (self.scroll_speed + delta.abs() / elapsed) / 2.0
+        } else {
+            0.0
+        };
+        self.last_scroll_time = now;
+        self.viewport_y = y;
+    }
+}
+
+/// A pause in scrolling longer than this resets the measured speed.
+const SCROLL_IDLE_SECS: f32 = 0.5;
+/// Prefetch always covers at least this many pages in the scroll direction.
+const MIN_PREFETCH_PAGES: usize = 2;
+/// Upper bound on pages prefetched ahead, however fast the scroll.
+const MAX_PREFETCH_PAGES: usize = 12;
+/// How far ahead, in seconds of scrolling at the current speed, to prefetch.
+const PREFETCH_LOOKAHEAD_SECS: f32 = 1.0;
+
+/// Prefix sums over page layout heights, so mapping a scroll offset to pages
+/// is a binary search instead of a walk over every page.
+///
+/// Offsets are unscaled: page heights, spacing and padding all scale with
+/// zoom, so one index serves every zoom level.
+#[derive(Debug, Clone, PartialEq)]
+pub struct PageLayout {
+    /// Layout height of each page, rotation applied.
+    heights: Vec<f32>,
+    /// `tops[i]` is the distance from the first page's top to page `i`'s top,
+    /// spacing included; the extra last entry is the height of all pages.
+    tops: Vec<f32>,
+}
+
+impl Default for PageLayout {
+    fn default() -> Self {
+        Self::new(Vec::new())
+    }
+}
+
+impl PageLayout {
+    pub fn new(heights: Vec<f32>) -> Self {
+        let mut layout = Self {
+            heights,
+            tops: Vec::new(),
+        };
+        layout.rebuild_from(0);
+        layout
+    }
+
+    pub fn len(&self) -> usize {
+        self.heights.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.heights.is_empty()
+    }
+
+    /// Offset of page `idx`'s top, or of the end of the last page (trailing
+    /// spacing included) for `idx >= len()`.
+    pub fn top(&self, idx: usize) -> f32 {
+        self.tops[idx.min(self.heights.len())]
+    }
+
+    /// Changes one page's height, recomputing only the offsets after it.
+    pub fn set_height(&mut self, idx: usize, height: f32) {
+        if let Some(h) = self.heights.get_mut(idx) {
+            *h = height;
+            self.rebuild_from(idx);
+        }
+    }
+
+    /// Pages intersecting `[top, bottom]`, as a half-open `(start, end)`
+    /// range; `(0, 0)` when none do.
+    pub fn pages_between(&self, top: f32, bottom: f32) -> (usize, usize) {
+        let spacing = crate::ui::theme::PAGE_SPACING;
+        let n = self.heights.len();
+        let start = self.tops[1..].partition_point(|&next| next - spacing < top);
+        let end = self.tops[..n].partition_point(|&t| t <= bottom);
+        if start < end { (start, end) } else { (0, 0) }
+    }
+
+    fn rebuild_from(&mut self, idx: usize) {
+        let idx = idx
+            .min(self.tops.len().saturating_sub(1))
+            .min(self.heights.len());
+        self.tops.truncate(idx + 1);
+        if self.tops.is_empty() {
+            self.tops.push(0.0);
+        }
+        for i in idx..self.heights.len() {
+            let next = self.tops[i] + self.heights[i] + crate::ui::theme::PAGE_SPACING;
+            self.tops.push(next);
+        }
+    }
+}
+
 pub struct DocumentTab {
     pub id: DocumentId,
+    /// `OpenResult::generation` of the engine's copy of the document.
+    pub generation: u64,
+    /// `OpenResult::file_bytes`; 0 until the document is open.
+    pub file_bytes: u64,
+    /// `OpenResult::fingerprint`, so `session` never has to stat the file.
+    pub fingerprint: Option<u64>,
     pub path: PathBuf,
     pub name: String,
     pub total_pages: usize,
@@ -485,6 +783,9 @@ pub struct DocumentTab {
     pub auto_crop: bool,
     pub page_heights: Vec<f32>,
     pub page_width: f32,
+    /// Derived from `page_heights`, `page_width` and rotations; refresh with
+    /// `rebuild_layout` or `relayout_page` after changing any of them.
+    pub layout: PageLayout,
     pub search_results: Vec<SearchResult>,
     pub current_search_index: usize,
     pub undo_stack: Vec<UndoableAction>,
@@ -496,6 +797,12 @@ pub struct DocumentTab {
     pub metadata: DocumentMetadata,
     pub view_state: TabViewState,
     pub pending_session: Option<TabSession>,
+    /// Restored from the session but not yet opened in the engine; the
+    /// document is opened when the tab is first focused.
+    pub restore_pending: bool,
+    /// `page_heights` and `page_width` came from a session snapshot and
+    /// are already measured, so `Open`'s estimates do not replace them.
+    pub restored_layout: bool,
     pub page_mapping: Vec<usize>,
     pub page_rotations: std::collections::HashMap<usize, i32>,
     #[allow(clippy::type_complexity)]
@@ -528,6 +835,9 @@ impl DocumentTab {
     pub fn new(path: PathBuf) -> Self {
         Self {
             id: next_doc_id(),
+            generation: 0,
+            file_bytes: 0,
+            fingerprint: None,
             name: path
                 .file_name()
                 .map(|n| n.to_string_lossy().to_string())
@@ -541,6 +851,7 @@ impl DocumentTab {
             auto_crop: false,
             page_heights: Vec::new(),
             page_width: 0.0,
+            layout: PageLayout::default(),
             search_results: Vec::new(),
             current_search_index: 0,
             undo_stack: Vec::new(),
@@ -552,6 +863,8 @@ impl DocumentTab {
             metadata: DocumentMetadata::default(),
             view_state: TabViewState::default(),
             pending_session: None,
+            restore_pending: false,
+            restored_layout: false,
             page_mapping: Vec::new(),
             page_rotations: std::collections::HashMap::new(),
             selection_drag: None,
@@ -567,16 +880,102 @@ impl DocumentTab {
         }
     }
 
+    /// A tab for a saved session entry, left for the engine to open later.
+    /// With a snapshot of an unchanged file it is laid out and scrolled
+    /// right away; otherwise the session is applied once the file opens.
+    pub fn restore(path: PathBuf, session: Option<TabSession>) -> Self {
+        let mut tab = Self::new(path);
+        tab.restore_pending = true;
+        let Some(mut session) = session else {
+            return tab;
+        };
+        let snapshot = session.snapshot.take().filter(|snapshot| {
+            !snapshot.page_heights.is_empty()
+                && crate::text_index::file_fingerprint(&session.path) == Some(snapshot.fingerprint)
+        });
+        let Some(snapshot) = snapshot else {
+            tab.pending_session = Some(session);
+            return tab;
+        };
+
+        let count = snapshot.page_heights.len();
+        tab.fingerprint = Some(snapshot.fingerprint);
+        tab.total_pages = count;
+        tab.page_width = snapshot.page_width;
+        tab.outline = snapshot.outline;
+        tab.page_labels = (1..=count).map(|i| i.to_string()).collect();
+        tab.page_mapping = (0..count).collect();
+        tab.current_page = session.current_page.min(count - 1);
+        tab.zoom = session.zoom;
+        tab.rotation = session.rotation;
+        tab.auto_crop = session.auto_crop;
+        tab.view_state.viewport_y = session.viewport_y;
+        tab.restored_layout = true;
+        tab.set_page_heights(snapshot.page_heights);
+        tab.update_visible_range();
+        tab
+    }
+
+    /// What the session file keeps of this tab: its view position, and its
+    /// layout while the pages are in file order.
+    pub fn session(&self) -> TabSession {
+        if let Some(pending) = &self.pending_session {
+            return pending.clone();
+        }
+        let path = self.path.to_string_lossy().to_string();
+        let in_file_order = self.total_pages > 0
+            && self.page_heights.len() == self.total_pages
+            && self.page_mapping.iter().copied().eq(0..self.total_pages);
+        let snapshot = self
+            .fingerprint
+            .filter(|_| in_file_order)
+            .map(|fingerprint| TabSnapshot {
+                fingerprint,
+                page_heights: self.page_heights.clone(),
+                page_width: self.page_width,
+                outline: self.outline.clone(),
+            });
+        TabSession {
+            path,
+            current_page: self.current_page,
+            zoom: self.zoom,
+            viewport_y: self.view_state.viewport_y,
+            rotation: self.rotation,
+            auto_crop: self.auto_crop,
+            snapshot,
+        }
+    }
+
+    /// Replaces the measured page heights and rebuilds the layout index.
+    pub fn set_page_heights(&mut self, heights: Vec<f32>) {
+        self.page_heights = heights;
+        self.rebuild_layout();
+    }
+
+    pub fn rebuild_layout(&mut self) {
+        let heights = (0..self.page_heights.len())
+            .map(|idx| self.page_size(idx).1)
+            .collect();
+        self.layout = PageLayout::new(heights);
+    }
+
+    /// Refreshes one page's entry after its rotation or height changed.
+    pub fn relayout_page(&mut self, page_idx: usize) {
+        let height = self.page_size(page_idx).1;
+        self.layout.set_height(page_idx, height);
+    }
+
+    /// Scaled offset of a page's top from the top of the first page.
+    pub fn page_offset(&self, page_idx: usize) -> f32 {
+        self.layout.top(page_idx) * self.zoom
+    }
+
     pub fn update_visible_range(&mut self) {
-        if self.page_heights.is_empty() {
+        if self.layout.is_empty() {
             self.view_state.visible_range = (0, 0);
             return;
         }
 
-        let scaled_spacing = crate::ui::theme::PAGE_SPACING * self.zoom;
-        let scaled_padding = crate::ui::theme::PAGE_PADDING * self.zoom;
-        let mut y = scaled_padding;
-
         let v_height = if self.view_state.viewport_height > 0.0 {
             self.view_state.viewport_height
         } else {
@@ -587,33 +986,113 @@ impl DocumentTab {
         let viewport_top = (self.view_state.viewport_y - margin).max(0.0);
         let viewport_bottom = self.view_state.viewport_y + v_height + margin;
 
-        let mut start = 0;
-        let mut end = 0;
-        let mut found_start = false;
+        let zoom = self.zoom.max(f32::EPSILON);
+        let padding = crate::ui::theme::PAGE_PADDING;
+        self.view_state.visible_range = self.layout.pages_between(
+            viewport_top / zoom - padding,
+            viewport_bottom / zoom - padding,
+        );
+    }
 
-        for (idx, height) in self.page_heights.iter().enumerate() {
-            let scaled_height = height * self.zoom;
-            let page_bottom = y + scaled_height;
+    /// Unscaled layout size of a page, with its rotation applied.
+    pub fn page_size(&self, page_idx: usize) -> (f32, f32) {
+        let actual_page = self.page_mapping.get(page_idx).copied().unwrap_or(page_idx);
+        let page_rotation = self
+            .page_rotations
+            .get(&actual_page)
+            .copied()
+            .unwrap_or(self.rotation);
+        let original_height = self.page_heights.get(page_idx).copied().unwrap_or(800.0);
+        if page_rotation % 180 == 0 {
+            (self.page_width, original_height)
+        } else {
+            (original_height, self.page_width)
+        }
+    }
 
-            if !found_start && page_bottom >= viewport_top {
-                start = idx;
-                found_start = true;
-            }
+    /// Whether a page is too large at the current zoom to render as one bitmap.
+    pub fn uses_tiles(&self, page_idx: usize) -> bool {
+        let (width, height) = self.page_size(page_idx);
+        !self.auto_crop
+            && width * height * self.zoom * self.zoom > crate::pdf_engine::TILED_RENDER_MIN_PIXELS
+    }
 
-            if page_bottom >= viewport_top && y <= viewport_bottom {
-                end = idx;
-            } else if found_start && y > viewport_bottom {
-                break;
-            }
+    /// Tiles of a page that intersect the viewport, plus a one-tile margin.
+    pub fn visible_tiles(&self, page_idx: usize) -> Vec<(u32, u32)> {
+        let tile = crate::pdf_engine::TILE_SIZE as f32;
+        let (width, height) = self.page_size(page_idx);
+        let page_w = width * self.zoom;
+        let page_h = height * self.zoom;
+        let padding = crate::ui::theme::PAGE_PADDING * self.zoom;
+
+        let page_top = padding + self.page_offset(page_idx);
+        // Pages are centred in a column as wide as the widest page.
+        let column_w = self.page_width.max(width) * self.zoom + 2.0 * padding;
+        let page_left = (self.view_state.viewport_width - column_w).max(0.0) / 2.0
+            + padding
+            + (column_w - 2.0 * padding - page_w) / 2.0;
+
+        let v_width = if self.view_state.viewport_width > 0.0 {
+            self.view_state.viewport_width
+        } else {
+            2000.0
+        };
+        let v_height = if self.view_state.viewport_height > 0.0 {
+            self.view_state.viewport_height
+        } else {
+            2000.0
+        };
+
+        let left = (self.view_state.viewport_x - page_left - tile).max(0.0);
+        let right = (self.view_state.viewport_x + v_width - page_left + tile).min(page_w);
+        let top = (self.view_state.viewport_y - page_top - tile).max(0.0);
+        let bottom = (self.view_state.viewport_y + v_height - page_top + tile).min(page_h);
+        if right <= left || bottom <= top {
+            return Vec::new();
+        }
+
+        let (col_start, col_end) = ((left / tile) as u32, (right / tile).ceil() as u32);
+        let (row_start, row_end) = ((top / tile) as u32, (bottom / tile).ceil() as u32);
+        (row_start..row_end)
+            .flat_map(|row| (col_start..col_end).map(move |col| (col, row)))
+            .collect()
+    }
 
-            y = page_bottom + scaled_spacing;
+    /// Pages to render ahead of the viewport in the scroll direction, nearest
+    /// first. Faster scrolling looks further ahead, and the list stops once
+    /// the estimated bitmaps would exceed `budget_bytes`.
+    pub fn prefetch_pages(&self, budget_bytes: usize) -> Vec<usize> {
+        let (start, end) = self.view_state.visible_range;
+        if budget_bytes == 0 || start >= end {
+            return Vec::new();
         }
 
-        if found_start {
-            self.view_state.visible_range = (start, end + 1);
+        let pages = self.layout.len().max(1);
+        let page_px = self.page_offset(pages) / pages as f32;
+        let lookahead = (self.view_state.scroll_speed * PREFETCH_LOOKAHEAD_SECS / page_px.max(1.0))
+            .ceil() as usize;
+        let count = lookahead.clamp(MIN_PREFETCH_PAGES, MAX_PREFETCH_PAGES);
+
+        let candidates: Box<dyn Iterator<Item = usize>> = if self.view_state.scrolling_forward {
+            Box::new(end..self.total_pages.min(self.page_heights.len()))
         } else {
-            self.view_state.visible_range = (0, 0);
+            Box::new((0..start).rev())
+        };
+
+        let mut spent = 0;
+        let mut pages = Vec::with_capacity(count);
+        for page_idx in candidates.take(count) {
+            if self.uses_tiles(page_idx) {
+                break;
+            }
+            let (width, height) = self.page_size(page_idx);
+            spent += (width * height * self.zoom * self.zoom * 4.0) as usize;
+            if spent > budget_bytes {
+                break;
+            }
+            pages.push(page_idx);
         }
+        pages
     }
 
     pub fn get_visible_pages(&self) -> std::ops::Range<usize> {
@@ -641,9 +1120,30 @@ impl DocumentTab {
         let keep_start = start.saturating_sub(buffer);
         let keep_end = (end + buffer).min(self.total_pages);
 
+        let (prefetch_start, prefetch_end) = self.view_state.prefetch_range;
+
+        let keep = |p: usize| {
+            (p >= keep_start && p < keep_end) || (p >= prefetch_start && p < prefetch_end)
+        };
+        self.view_state.rendered_pages.retain(|&p, _| keep(p));
+        self.view_state.overlays.retain(keep);
+
+        // Tiles exist to keep deep zoom bounded by the viewport, so only the
+        // ones still on screen at the current zoom survive.
+        let zoom = self.zoom;
+        let mut visible_tiles = std::collections::HashSet::new();
+        for page_idx in self.get_visible_pages() {
+            if self.uses_tiles(page_idx) {
+                visible_tiles.extend(
+                    self.visible_tiles(page_idx)
+                        .into_iter()
+                        .map(|(col, row)| (page_idx, col, row)),
+                );
+            }
+        }
         self.view_state
-            .rendered_pages
-            .retain(|&p, _| p >= keep_start && p < keep_end);
+            .rendered_tiles
+            .retain(|key, (scale, _)| (*scale - zoom).abs() < 0.001 && visible_tiles.contains(key));
 
         let thumb_start_idx = (self.view_state.sidebar_viewport_y
             / crate::ui::theme::THUMBNAIL_HEIGHT)
@@ -658,6 +1158,28 @@ impl DocumentTab {
         self.view_state.last_cleanup_time = std::time::Instant::now();
     }
 
+    /// Keeps only what is on screen, for when the memory budget is short
+    /// even after background tabs and the engine cache gave theirs up.
+    pub fn trim_to_viewport(&mut self) {
+        self.cleanup_distant_pages();
+        let visible = self.get_visible_pages();
+        let thumbnails = self.get_visible_thumbnails();
+        let view_state = &mut self.view_state;
+        view_state
+            .rendered_pages
+            .retain(|page, _| visible.contains(page));
+        view_state
+            .thumbnails
+            .retain(|page, _| thumbnails.contains(page));
+        view_state
+            .text_layers
+            .retain(|page, _| visible.contains(page));
+        view_state
+            .detected_tables
+            .retain(|page, _| visible.contains(page));
+        view_state.overlays.retain(|page| visible.contains(&page));
+    }
+
     pub fn needs_periodic_cleanup(&self) -> bool {
         self.view_state.last_cleanup_time.elapsed().as_secs() >= 5
     }
@@ -769,6 +1291,7 @@ mod tests {
         assert_eq!(settings.theme, AppTheme::System);
         assert_eq!(settings.cache_size, 100);
         assert_eq!(settings.max_cache_memory, 512);
+        assert_eq!(settings.memory_budget_mb, 1024);
         assert_eq!(
             settings.render_quality,
             crate::pdf_engine::RenderQuality::Medium
@@ -779,6 +1302,7 @@ mod tests {
         assert!(settings.remember_last_file);
         assert_eq!(settings.default_zoom, 1.0);
         assert!(settings.auto_save);
+        assert_eq!(settings.prefetch_memory_mb, 64);
     }
 
     #[test]
@@ -801,6 +1325,44 @@ mod tests {
         assert_eq!(session.active_tab, 0);
     }
 
+    #[test]
+    fn test_restore_lays_out_from_snapshot_of_unchanged_file() {
+        let path = PathBuf::from(concat!(
+            env!("CARGO_MANIFEST_DIR"),
+            "/tests/test_document.pdf"
+        ));
+        let mut tab = DocumentTab::new(path.clone());
+        tab.total_pages = 3;
+        tab.page_mapping = (0..3).collect();
+        tab.page_width = 612.0;
+        tab.set_page_heights(vec![792.0, 792.0, 400.0]);
+        tab.current_page = 2;
+        tab.zoom = 1.5;
+        assert!(
+            tab.session().snapshot.is_none(),
+            "not snapshotted before open"
+        );
+        tab.fingerprint = crate::text_index::file_fingerprint(&path.to_string_lossy());
+
+        let saved = tab.session();
+        assert!(saved.snapshot.is_some());
+        let restored = DocumentTab::restore(path.clone(), Some(saved.clone()));
+        assert!(restored.restore_pending && restored.restored_layout);
+        assert_eq!(restored.total_pages, 3);
+        assert_eq!(restored.page_heights, vec![792.0, 792.0, 400.0]);
+        assert_eq!(restored.current_page, 2);
+        assert!(restored.pending_session.is_none());
+
+        let mut stale = saved;
+        if let Some(snapshot) = &mut stale.snapshot {
+            snapshot.fingerprint ^= 1;
+        }
+        let restored = DocumentTab::restore(path, Some(stale));
+        assert!(!restored.restored_layout);
+        assert_eq!(restored.total_pages, 0);
+        assert!(restored.pending_session.is_some(), "applied once opened");
+    }
+
     #[test]
     fn test_document_tab_new() {
         let path = PathBuf::from("/test/document.pdf");
@@ -838,10 +1400,49 @@ mod tests {
         assert!(!state.is_loading);
     }
 
+    #[test]
+    fn test_page_layout_finds_pages_by_offset() {
+        let layout = PageLayout::new(vec![100.0, 200.0, 100.0]);
+        // Tops at 0, 120 and 340 with 20 of spacing after each page.
+        assert_eq!(layout.top(1), 120.0);
+        assert_eq!(layout.top(3), 460.0);
+        assert_eq!(layout.pages_between(0.0, 50.0), (0, 1));
+        assert_eq!(layout.pages_between(105.0, 115.0), (0, 0));
+        assert_eq!(layout.pages_between(150.0, 350.0), (1, 3));
+        assert_eq!(layout.pages_between(1000.0, 2000.0), (0, 0));
+        assert_eq!(PageLayout::default().pages_between(0.0, 100.0), (0, 0));
+    }
+
+    #[test]
+    fn test_page_layout_set_height_matches_rebuild() {
+        let mut layout = PageLayout::new(vec![100.0; 5]);
+        layout.set_height(2, 300.0);
+        assert_eq!(
+            layout,
+            PageLayout::new(vec![100.0, 100.0, 300.0, 100.0, 100.0])
+        );
+    }
+
+    #[test]
+    fn test_relayout_page_uses_rotated_height() {
+        let mut tab = DocumentTab::new(PathBuf::from("/test/doc.pdf"));
+        tab.page_width = 600.0;
+        tab.page_mapping = (0..3).collect();
+        tab.set_page_heights(vec![800.0; 3]);
+        assert_eq!(tab.page_offset(2), 1640.0);
+
+        tab.page_rotations.insert(0, 90);
+        tab.relayout_page(0);
+        assert_eq!(tab.page_offset(2), 1440.0);
+
+        tab.zoom = 2.0;
+        assert_eq!(tab.page_offset(2), 2880.0);
+    }
+
     #[test]
     fn test_update_visible_range_empty_pages() {
         let mut tab = DocumentTab::new(PathBuf::from("/test/doc.pdf"));
-        tab.page_heights = vec![];
+        tab.set_page_heights(vec![]);
         tab.update_visible_range();
         assert_eq!(tab.view_state.visible_range, (0, 0));
     }
@@ -849,7 +1450,7 @@ mod tests {
     #[test]
     fn test_update_visible_range_single_page() {
         let mut tab = DocumentTab::new(PathBuf::from("/test/doc.pdf"));
-        tab.page_heights = vec![1000.0];
+        tab.set_page_heights(vec![1000.0]);
         tab.view_state.viewport_height = 800.0;
         tab.view_state.viewport_y = 0.0;
         tab.zoom = 1.0;
@@ -860,7 +1461,7 @@ mod tests {
     #[test]
     fn test_update_visible_range_with_zoom() {
         let mut tab = DocumentTab::new(PathBuf::from("/test/doc.pdf"));
-        tab.page_heights = vec![1000.0, 1000.0, 1000.0];
+        tab.set_page_heights(vec![1000.0, 1000.0, 1000.0]);
         tab.view_state.viewport_height = 800.0;
         tab.view_state.viewport_y = 0.0;
         tab.zoom = 2.0;
@@ -871,7 +1472,7 @@ mod tests {
     #[test]
     fn test_get_visible_pages() {
         let mut tab = DocumentTab::new(PathBuf::from("/test/doc.pdf"));
-        tab.page_heights = vec![100.0; 10];
+        tab.set_page_heights(vec![100.0; 10]);
         tab.view_state.visible_range = (2, 5);
         let visible = tab.get_visible_pages();
         assert!(visible.contains(&2));
@@ -884,7 +1485,7 @@ mod tests {
     #[test]
     fn test_get_visible_pages_empty_range() {
         let mut tab = DocumentTab::new(PathBuf::from("/test/doc.pdf"));
-        tab.page_heights = vec![100.0; 10];
+        tab.set_page_heights(vec![100.0; 10]);
         tab.view_state.visible_range = (5, 5);
         let visible = tab.get_visible_pages();
         assert!(visible.is_empty());
@@ -894,7 +1495,7 @@ mod tests {
     fn test_cleanup_distant_pages_removes_distant() {
         let mut tab = DocumentTab::new(PathBuf::from("/test/doc.pdf"));
         tab.total_pages = 20;
-        tab.page_heights = vec![100.0; 20];
+        tab.set_page_heights(vec![100.0; 20]);
         tab.view_state.visible_range = (5, 8);
         tab.view_state.rendered_pages = std::collections::HashMap::new();
         tab.view_state.thumbnails = std::collections::HashMap::new();
@@ -923,7 +1524,7 @@ mod tests {
     fn test_cleanup_distant_pages_removes_zoom_mismatch() {
         let mut tab = DocumentTab::new(PathBuf::from("/test/doc.pdf"));
         tab.total_pages = 10;
-        tab.page_heights = vec![100.0; 10];
+        tab.set_page_heights(vec![100.0; 10]);
         tab.view_state.visible_range = (5, 7);
         tab.view_state.rendered_pages = std::collections::HashMap::new();
         tab.view_state.thumbnails = std::collections::HashMap::new();
@@ -949,12 +1550,90 @@ mod tests {
         assert!(!tab.view_state.rendered_pages.contains_key(&1));
     }
 
+    #[test]
+    fn test_forget_pages_drops_changed_and_removed_pages() {
+        let mut view = TabViewState::default();
+        for i in 0..6 {
+            view.rendered_pages
+                .insert(i, (1.0, iced::widget::image::Handle::from_bytes(vec![])));
+            view.thumbnails
+                .insert(i, iced::widget::image::Handle::from_bytes(vec![]));
+        }
+        view.forget_pages(&[1, 3].into_iter().collect(), 5);
+
+        let mut kept: Vec<usize> = view.rendered_pages.keys().copied().collect();
+        kept.sort_unstable();
+        assert_eq!(kept, vec![0, 2, 4]);
+        assert_eq!(view.thumbnails.len(), 3);
+    }
+
     #[test]
     fn test_needs_periodic_cleanup_immediate() {
         let tab = DocumentTab::new(PathBuf::from("/test/doc.pdf"));
         assert!(tab.needs_periodic_cleanup());
     }
 
+    #[test]
+    fn test_prefetch_pages_follow_scroll_direction() {
+        let mut tab = DocumentTab::new(PathBuf::from("/test/doc.pdf"));
+        tab.total_pages = 20;
+        tab.page_width = 600.0;
+        tab.set_page_heights(vec![800.0; 20]);
+        tab.view_state.visible_range = (2, 4);
+
+        assert_eq!(tab.prefetch_pages(64 * 1024 * 1024), vec![4, 5]);
+
+        tab.view_state.scrolling_forward = false;
+        tab.view_state.scroll_speed = 10_000.0;
+        assert_eq!(tab.prefetch_pages(64 * 1024 * 1024), vec![1, 0]);
+    }
+
+    #[test]
+    fn test_prefetch_pages_respect_budget() {
+        let mut tab = DocumentTab::new(PathBuf::from("/test/doc.pdf"));
+        tab.total_pages = 20;
+        tab.page_width = 600.0;
+        tab.set_page_heights(vec![800.0; 20]);
+        tab.view_state.visible_range = (0, 2);
+        tab.view_state.scroll_speed = 100_000.0;
+
+        let one_page = 600 * 800 * 4;
+        assert_eq!(tab.prefetch_pages(one_page + one_page / 2), vec![2]);
+        assert!(tab.prefetch_pages(0).is_empty());
+        assert_eq!(tab.prefetch_pages(usize::MAX).len(), 12);
+    }
+
+    #[test]
+    fn test_uses_tiles_only_at_deep_zoom() {
+        let mut tab = DocumentTab::new(PathBuf::from("/test/a0.pdf"));
+        tab.page_width = 2384.0;
+        tab.set_page_heights(vec![3370.0]);
+        tab.zoom = 1.0;
+        assert!(!tab.uses_tiles(0));
+        tab.zoom = 4.0;
+        assert!(tab.uses_tiles(0));
+        tab.auto_crop = true;
+        assert!(!tab.uses_tiles(0));
+    }
+
+    #[test]
+    fn test_visible_tiles_cover_viewport_only() {
+        let mut tab = DocumentTab::new(PathBuf::from("/test/a0.pdf"));
+        tab.page_width = 2384.0;
+        tab.set_page_heights(vec![3370.0]);
+        tab.zoom = 4.0;
+        tab.view_state.viewport_width = 1000.0;
+        tab.view_state.viewport_height = 800.0;
+
+        let tiles = tab.visible_tiles(0);
+        assert_eq!(tiles.len(), 9);
+        assert!(tiles.iter().all(|&(col, row)| col < 3 && row < 3));
+
+        tab.view_state.viewport_y = 6000.0;
+        let tiles = tab.visible_tiles(0);
+        assert!(tiles.iter().all(|&(_, row)| row >= 9));
+    }
+
     #[test]
     fn test_annotation_serialization() {
         let ann = Annotation {
@@ -1197,6 +1876,7 @@ mod tests {
         assert_eq!(cloned.width, 100);
         assert_eq!(cloned.height, 200);
         assert_eq!(cloned.data.len(), 4);
+        assert_eq!(cloned.data.as_ptr(), result.data.as_ptr());
     }
 
     #[test]
@@ -1206,15 +1886,11 @@ mod tests {
             page_count: 10,
             page_heights: vec![100.0; 10],
             max_width: 800.0,
-            outline: vec![],
-            links: vec![],
             metadata: DocumentMetadata::default(),
-            page_labels: vec![],
             is_encrypted: false,
-            signatures: vec![],
-            attachments: vec![],
-            layers: vec![],
-            oc_config: None,
+            generation: 0,
+            file_bytes: 0,
+            fingerprint: None,
         };
         let cloned = result.clone();
         assert_eq!(cloned.page_count, 10);
@@ -0,0 +1,628 @@
+//! Optimize PDF: besides compressing streams and dropping unused objects,
+//! downsamples images drawn above a target resolution and re-encodes them
+//! as JPEG, then stores byte-identical streams once. Scans are almost all
+//! image bytes, so that is where the savings are; images are decoded and
+//! encoded in parallel, and so is stream compression.
+//!
+//! An image's resolution comes from the transformation matrix in effect
+//! where a content stream draws it with `Do`, followed through `q`, `Q`,
+//! `cm` and nested forms. Images are scaled against the largest size they
+//! are drawn at, which keeps them at or above the target everywhere. Images
+//! no page content draws, e.g. ones only annotations use, have no known
+//! size and are left as they are.
+//!
+//! Only 8-bit gray and RGB images stored as JPEG, Flate or raw samples are
+//! re-encoded. Bilevel, CMYK, indexed and color-keyed images are left as
+//! they are: there is no JBIG2 or CCITT encoder among our dependencies, and
+//! stream compression already Flate-encodes any stored uncompressed.
+
+use crate::models::{PdfError, PdfResult};
+use image::codecs::jpeg::JpegEncoder;
+use image::imageops::FilterType;
+use image::{DynamicImage, GrayImage, ImageEncoder, RgbImage};
+use lopdf::{Dictionary, Document, Object, ObjectId, Stream};
+use rayon::prelude::*;
+use std::collections::HashMap;
+use std::hash::{DefaultHasher, Hash, Hasher};
+
+/// Nested form XObjects deeper than this are not searched for images.
+const MAX_FORM_DEPTH: usize = 16;
+/// PDF user space units per inch.
+const POINTS_PER_INCH: f32 = 72.0;
+/// Images are downsampled only when this far above the target, in percent,
+/// so near misses are not resampled for a few pixels.
+const DOWNSAMPLE_MARGIN_PERCENT: f32 = 10.0;
+/// A re-encoded image replaces the original only when it is at least this
+/// much smaller, in percent.
+const MIN_SAVING_PERCENT: usize = 10;
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct OptimizeOptions {
+    /// Resolution images are downsampled to; 0 keeps every image's pixels.
+    pub target_dpi: u32,
+    /// JPEG quality of re-encoded images, 1-100.
+    pub jpeg_quality: u8,
+}
+
+impl Default for OptimizeOptions {
+    fn default() -> Self {
+        Self {
+            target_dpi: 150,
+            jpeg_quality: 75,
+        }
+    }
+}
+
+/// Bytes saved, by where they came from.
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct OptimizeReport {
+    pub output_path: String,
+    pub input_bytes: u64,
+    pub output_bytes: u64,
+    pub images_reencoded: usize,
+    pub image_bytes_saved: u64,
+    pub duplicates_removed: usize,
+    pub duplicate_bytes_saved: u64,
+    /// Stream compression, dropped metadata, unused objects and the
+    /// rewritten file structure.
+    pub other_bytes_saved: u64,
+}
+
+impl OptimizeReport {
+    pub fn bytes_saved(&self) -> u64 {
+        self.input_bytes.saturating_sub(self.output_bytes)
+    }
+
+    /// One line for the status bar.
+    pub fn summary(&self) -> String {
+        format!(
+            "{} smaller, {} → {} (images {}, duplicates {}, other {})",
+            megabytes(self.bytes_saved()),
+            megabytes(self.input_bytes),
+            megabytes(self.output_bytes),
+            megabytes(self.image_bytes_saved),
+            megabytes(self.duplicate_bytes_saved),
+            megabytes(self.other_bytes_saved)
+        )
+    }
+}
+
+fn megabytes(bytes: u64) -> String {
+    format!("{:.1} MB", bytes as f64 / (1024.0 * 1024.0))
+}
+
+pub fn optimize(
+    input_path: &str,
+    output_path: &str,
+    options: &OptimizeOptions,
+) -> PdfResult<OptimizeReport> {
+    let input_bytes = std::fs::metadata(input_path)
+        .map_err(|e| PdfError::OpenFailed(e.to_string()))?
+        .len();
+    let mut doc = Document::load(input_path).map_err(|e| PdfError::OpenFailed(e.to_string()))?;
+    let mut report = OptimizeReport {
+        output_path: output_path.to_string(),
+        input_bytes,
+        ..OptimizeReport::default()
+    };
+
+    let resolutions = image_resolutions(&doc);
+    let reencoded: Vec<(ObjectId, Stream, usize)> = resolutions
+        .par_iter()
+        .filter_map(|(&id, &dpi)| {
+            let stream = doc.objects.get(&id)?.as_stream().ok()?;
+            let (stream, stored_len) = reencode(&doc, stream, dpi, options)?;
+            Some((id, stream, stored_len))
+        })
+        .collect();
+    for (id, stream, stored_len) in reencoded {
+        let new_len = stream.content.len();
+        if doc.objects.insert(id, Object::Stream(stream)).is_some() {
+            report.images_reencoded += 1;
+            report.image_bytes_saved += stored_len.saturating_sub(new_len) as u64;
+        }
+    }
+
+    doc.objects.par_iter_mut().for_each(|(_, object)| {
+        if let Object::Stream(stream) = object
+            && stream.allows_compression
+        {
+            let _ = stream.compress();
+        }
+    });
+    (report.duplicates_removed, report.duplicate_bytes_saved) = dedup_streams(&mut doc);
+
+    let _ = doc.trailer.remove(b"Info");
+    doc.prune_objects();
+    doc.save(output_path)
+        .map_err(|e| PdfError::IoError(e.to_string()))?;
+
+    report.output_bytes = std::fs::metadata(output_path)
+        .map_err(|e| PdfError::IoError(e.to_string()))?
+        .len();
+    report.other_bytes_saved = report
+        .bytes_saved()
+        .saturating_sub(report.image_bytes_saved + report.duplicate_bytes_saved);
+    Ok(report)
+}
+
+/// Lowest resolution, in pixels per inch, each image XObject is drawn at
+/// by any page's content, directly or through forms.
+fn image_resolutions(doc: &Document) -> HashMap<ObjectId, f32> {
+    let mut resolutions = HashMap::new();
+    for page in doc.get_pages().into_values() {
+        let dict = crate::doc_ops::materialized_page(&doc.objects, page);
+        let Some(resources) = dict
+            .get(b"Resources")
+            .ok()
+            .and_then(|r| resolve_dict(doc, r))
+        else {
+            continue;
+        };
+        let Ok(content) = doc.get_page_content(page) else {
+            continue;
+        };
+        collect_images(doc, &content, resources, IDENTITY, 0, &mut resolutions);
+    }
+    resolutions
+}
+
+/// Walks one content stream, following the CTM through `q`, `Q` and `cm`,
+/// and records the resolution of every image `Do` draws. Forms are walked
+/// with their `/Matrix` applied, and with `resources` when they have none
+/// of their own.
+fn collect_images(
+    doc: &Document,
+    content: &[u8],
+    resources: &Dictionary,
+    mut ctm: Matrix,
+    depth: usize,
+    resolutions: &mut HashMap<ObjectId, f32>,
+) {
+    let Ok(content) = lopdf::content::Content::decode(content) else {
+        return;
+    };
+    let xobjects = resources
+        .get(b"XObject")
+        .ok()
+        .and_then(|x| resolve_dict(doc, x));
+    let mut saved = Vec::new();
+    for op in &content.operations {
+        match op.operator.as_str() {
+            "q" => saved.push(ctm),
+            "Q" => ctm = saved.pop().unwrap_or(ctm),
+            "cm" => {
+                if let Some(m) = matrix(&op.operands) {
+                    ctm = concat(&m, &ctm);
+                }
+            }
+            "Do" => {
+                let Some(id) = xobjects
+                    .zip(op.operands.first())
+                    .and_then(|(xobjects, name)| xobjects.get(name.as_name().ok()?).ok())
+                    .and_then(|value| value.as_reference().ok())
+                else {
+                    continue;
+                };
+                let Some(stream) = doc.objects.get(&id).and_then(|o| o.as_stream().ok()) else {
+                    continue;
+                };
+                match stream.dict.get(b"Subtype").and_then(Object::as_name) {
+                    Ok(b"Image") => {
+                        if let Some(dpi) = drawn_resolution(&stream.dict, &ctm) {
+                            resolutions
+                                .entry(id)
+                                .and_modify(|lowest: &mut f32| *lowest = lowest.min(dpi))
+                                .or_insert(dpi);
+                        }
+                    }
+                    Ok(b"Form") if depth < MAX_FORM_DEPTH => {
+                        let Some(inner) = stream_bytes(stream) else {
+                            continue;
+                        };
+                        let form_matrix = stream
+                            .dict
+                            .get(b"Matrix")
+                            .ok()
+                            .and_then(|m| resolve(doc, m))
+                            .and_then(|m| m.as_array().ok())
+                            .and_then(|m| matrix(m))
+                            .unwrap_or(IDENTITY);
+                        let form_resources = stream
+                            .dict
+                            .get(b"Resources")
+                            .ok()
+                            .and_then(|r| resolve_dict(doc, r))
+                            .unwrap_or(resources);
+                        collect_images(
+                            doc,
+                            &inner,
+                            form_resources,
+                            concat(&form_matrix, &ctm),
+                            depth + 1,
+                            resolutions,
+                        );
+                    }
+                    _ => {}
+                }
+            }
+            _ => {}
+        }
+    }
+}
+
+/// Pixels per inch of an image drawn under `ctm`. An image fills the unit
+/// square, so the lengths of the matrix's first two rows are its drawn
+/// width and height in points. `None` for a degenerate matrix.
+fn drawn_resolution(image: &Dictionary, ctm: &Matrix) -> Option<f32> {
+    let width = dimension(image, b"Width")?;
+    let height = dimension(image, b"Height")?;
+    let drawn_width = ctm[0].hypot(ctm[1]);
+    let drawn_height = ctm[2].hypot(ctm[3]);
+    if !(drawn_width > 0.0 && drawn_height > 0.0) {
+        return None;
+    }
+    let dpi = (width as f32 * POINTS_PER_INCH / drawn_width)
+        .min(height as f32 * POINTS_PER_INCH / drawn_height);
+    dpi.is_finite().then_some(dpi)
+}
+
+/// `[a b c d e f]` of a PDF transformation matrix.
+type Matrix = [f32; 6];
+
+const IDENTITY: Matrix = [1.0, 0.0, 0.0, 1.0, 0.0, 0.0];
+
+/// `m` followed by `n`, which is how `cm` applies `m` to the CTM `n`.
+fn concat(m: &Matrix, n: &Matrix) -> Matrix {
+    [
+        m[0] * n[0] + m[1] * n[2],
+        m[0] * n[1] + m[1] * n[3],
+        m[2] * n[0] + m[3] * n[2],
+        m[2] * n[1] + m[3] * n[3],
+        m[4] * n[0] + m[5] * n[2] + n[4],
+        m[4] * n[1] + m[5] * n[3] + n[5],
+    ]
+}
+
+fn matrix(operands: &[Object]) -> Option<Matrix> {
+    let values: Vec<f32> = operands.iter().map(number).collect::<Option<_>>()?;
+    values.try_into().ok()
+}
+
+/// `stream` decoded, downsampled toward `options.target_dpi` from `dpi`
+/// and written as JPEG, with the size the original would be stored at.
+/// `None` when it cannot be re-encoded or would not get meaningfully
+/// smaller than that.
+fn reencode(
+    doc: &Document,
+    stream: &Stream,
+    dpi: f32,
+    options: &OptimizeOptions,
+) -> Option<(Stream, usize)> {
+    let dict = &stream.dict;
+    let is_mask = dict
+        .get(b"ImageMask")
+        .and_then(Object::as_bool)
+        .unwrap_or(false);
+    let color_keyed = matches!(dict.get(b"Mask"), Ok(Object::Array(_)));
+    let bits = dict.get(b"BitsPerComponent").and_then(Object::as_i64);
+    if is_mask || color_keyed || bits.ok() != Some(8) {
+        return None;
+    }
+    let channels = color_channels(doc, dict.get(b"ColorSpace").ok()?)?;
+    let width = dimension(dict, b"Width")?;
+    let height = dimension(dict, b"Height")?;
+
+    let filter = match dict.get(b"Filter") {
+        Err(_) => None,
+        Ok(Object::Name(name)) => Some(name.as_slice()),
+        Ok(Object::Array(filters)) if filters.len() == 1 => Some(filters[0].as_name().ok()?),
+        Ok(_) => return None,
+    };
+    let image = match filter {
+        Some(b"DCTDecode") if !dict.has(b"DecodeParms") => {
+            image::load_from_memory_with_format(&stream.content, image::ImageFormat::Jpeg).ok()?
+        }
+        Some(b"FlateDecode") | None => {
+            let mut samples = stream_bytes(stream)?;
+            samples.truncate(width as usize * height as usize * channels as usize);
+            match channels {
+                1 => DynamicImage::ImageLuma8(GrayImage::from_raw(width, height, samples)?),
+                _ => DynamicImage::ImageRgb8(RgbImage::from_raw(width, height, samples)?),
+            }
+        }
+        _ => return None,
+    };
+    if image.color().channel_count() != channels || image.width() != width {
+        return None;
+    }
+
+    let target = options.target_dpi as f32;
+    let image = if target > 0.0 && dpi > target * (1.0 + DOWNSAMPLE_MARGIN_PERCENT / 100.0) {
+        let scale = target / dpi;
+        image.resize_exact(
+            ((width as f32 * scale).round() as u32).max(1),
+            ((height as f32 * scale).round() as u32).max(1),
+            FilterType::Triangle,
+        )
+    } else {
+        image
+    };
+
+    let mut encoded = Vec::new();
+    JpegEncoder::new_with_quality(&mut encoded, options.jpeg_quality.clamp(1, 100))
+        .write_image(
+            image.as_bytes(),
+            image.width(),
+            image.height(),
+            image.color().into(),
+        )
+        .ok()?;
+    let stored_len = stored_len(stream);
+    if encoded.len() * 100 > stored_len * (100 - MIN_SAVING_PERCENT) {
+        return None;
+    }
+
+    let mut dict = dict.clone();
+    dict.set("Filter", Object::Name(b"DCTDecode".to_vec()));
+    dict.remove(b"DecodeParms");
+    dict.set("Width", Object::Integer(image.width() as i64));
+    dict.set("Height", Object::Integer(image.height() as i64));
+    Some((
+        Stream::new(dict, encoded).with_compression(false),
+        stored_len,
+    ))
+}
+
+/// Bytes `stream` takes in the output if left alone: its content as is
+/// when already filtered, or after the stream compression every
+/// unfiltered stream gets.
+fn stored_len(stream: &Stream) -> usize {
+    if stream.dict.has(b"Filter") || !stream.allows_compression {
+        return stream.content.len();
+    }
+    let mut compressed = stream.clone();
+    let _ = compressed.compress();
+    compressed.content.len().min(stream.content.len())
+}
+
+/// Decoded content of a stream, unfiltered ones as stored.
+fn stream_bytes(stream: &Stream) -> Option<Vec<u8>> {
+    if stream.dict.has(b"Filter") {
+        stream.decompressed_content().ok()
+    } else {
+        Some(stream.content.clone())
+    }
+}
+
+/// Points every reference to a stream at the first byte-identical copy and
+/// drops the rest, returning how many were dropped and their bytes.
+fn dedup_streams(doc: &mut Document) -> (usize, u64) {
+    let hashed: Vec<(u64, ObjectId)> = doc
+        .objects
+        .par_iter()
+        .filter_map(|(&id, object)| {
+            let stream = object.as_stream().ok()?;
+            let mut hasher = DefaultHasher::new();
+            stream.content.hash(&mut hasher);
+            Some((hasher.finish(), id))
+        })
+        .collect();
+
+    let mut firsts: HashMap<u64, Vec<ObjectId>> = HashMap::new();
+    let mut replacements = HashMap::new();
+    for (hash, id) in hashed {
+        let stream = doc.objects[&id].as_stream().ok();
+        let same = |other: &ObjectId| {
+            let other = doc.objects[other].as_stream().ok();
+            matches!((stream, other), (Some(a), Some(b)) if a.dict == b.dict && a.content == b.content)
+        };
+        let candidates = firsts.entry(hash).or_default();
+        match candidates.iter().find(|other| same(other)) {
+            Some(&keep) => {
+                replacements.insert(id, keep);
+            }
+            None => candidates.push(id),
+        }
+    }
+    if replacements.is_empty() {
+        return (0, 0);
+    }
+
+    let mut bytes = 0;
+    for id in replacements.keys() {
+        if let Some(Object::Stream(stream)) = doc.objects.remove(id) {
+            bytes += stream.content.len() as u64;
+        }
+    }
+    doc.objects
+        .par_iter_mut()
+        .for_each(|(_, object)| redirect(object, &replacements));
+    for (_, value) in doc.trailer.iter_mut() {
+        redirect(value, &replacements);
+    }
+    (replacements.len(), bytes)
+}
+
+fn redirect(object: &mut Object, replacements: &HashMap<ObjectId, ObjectId>) {
+    match object {
+        Object::Reference(id) => {
+            if let Some(&keep) = replacements.get(id) {
+                *id = keep;
+            }
+        }
+        Object::Array(items) => {
+            for item in items {
+                redirect(item, replacements);
+            }
+        }
+        Object::Dictionary(dict) => {
+            for (_, value) in dict.iter_mut() {
+                redirect(value, replacements);
+            }
+        }
+        Object::Stream(stream) => {
+            for (_, value) in stream.dict.iter_mut() {
+                redirect(value, replacements);
+            }
+        }
+        _ => {}
+    }
+}
+
+/// Color components of a gray or RGB color space; `None` for any other.
+fn color_channels(doc: &Document, space: &Object) -> Option<u8> {
+    match resolve(doc, space)? {
+        Object::Name(name) => match name.as_slice() {
+            b"DeviceGray" => Some(1),
+            b"DeviceRGB" => Some(3),
+            _ => None,
+        },
+        Object::Array(items) if items.first()?.as_name().ok()? == b"ICCBased" => {
+            let profile = resolve(doc, items.get(1)?)?.as_stream().ok()?;
+            match profile.dict.get(b"N").and_then(Object::as_i64).ok()? {
+                1 => Some(1),
+                3 => Some(3),
+                _ => None,
+            }
+        }
+        _ => None,
+    }
+}
+
+fn number(object: &Object) -> Option<f32> {
+    match object {
+        Object::Real(v) => Some(*v as f32),
+        Object::Integer(v) => Some(*v as f32),
+        _ => None,
+    }
+}
+
+fn dimension(dict: &Dictionary, key: &[u8]) -> Option<u32> {
+    let value = dict.get(key).and_then(Object::as_i64).ok()?;
+    u32::try_from(value).ok().filter(|&v| v > 0)
+}
+
+fn resolve<'a>(doc: &'a Document, object: &'a Object) -> Option<&'a Object> {
+    match object {
+        Object::Reference(id) => doc.objects.get(id),
+        other => Some(other),
+    }
+}
+
+fn resolve_dict<'a>(doc: &'a Document, object: &'a Object) -> Option<&'a Dictionary> {
+    resolve(doc, object)?.as_dict().ok()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// A one-inch page running `content`, with two separate, identical
+    /// 600×600 gray images stored uncompressed as `Im0` and `Im1`.
+    fn image_doc(content: &[u8]) -> Document {
+        let mut doc = Document::with_version("1.7");
+        let image = |doc: &mut Document| {
+            let mut dict = Dictionary::new();
+            dict.set("Type", Object::Name(b"XObject".to_vec()));
+            dict.set("Subtype", Object::Name(b"Image".to_vec()));
+            dict.set("Width", Object::Integer(600));
+            dict.set("Height", Object::Integer(600));
+            dict.set("ColorSpace", Object::Name(b"DeviceGray".to_vec()));
+            dict.set("BitsPerComponent", Object::Integer(8));
+            let samples = (0..600 * 600).map(|i| ((i % 600 + i / 600) / 5) as u8);
+            doc.add_object(Stream::new(dict, samples.collect()))
+        };
+        let first = image(&mut doc);
+        let second = image(&mut doc);
+
+        let mut xobjects = Dictionary::new();
+        xobjects.set("Im0", Object::Reference(first));
+        xobjects.set("Im1", Object::Reference(second));
+        let mut resources = Dictionary::new();
+        resources.set("XObject", Object::Dictionary(xobjects));
+        let content = doc.add_object(Stream::new(Dictionary::new(), content.to_vec()));
+
+        let pages_id = doc.new_object_id();
+        let mut page = Dictionary::new();
+        page.set("Type", Object::Name(b"Page".to_vec()));
+        page.set("Parent", Object::Reference(pages_id));
+        page.set("Resources", Object::Dictionary(resources));
+        page.set("Contents", Object::Reference(content));
+        let page_id = doc.add_object(page);
+
+        let mut pages = Dictionary::new();
+        pages.set("Type", Object::Name(b"Pages".to_vec()));
+        pages.set("Count", Object::Integer(1));
+        pages.set("Kids", Object::Array(vec![Object::Reference(page_id)]));
+        pages.set(
+            "MediaBox",
+            Object::Array([0, 0, 72, 72].map(Object::Integer).to_vec()),
+        );
+        doc.objects.insert(pages_id, Object::Dictionary(pages));
+        let mut catalog = Dictionary::new();
+        catalog.set("Type", Object::Name(b"Catalog".to_vec()));
+        catalog.set("Pages", Object::Reference(pages_id));
+        let catalog_id = doc.add_object(catalog);
+        doc.trailer.set("Root", Object::Reference(catalog_id));
+        doc
+    }
+
+    /// A scanned page: both images drawn to fill the page.
+    fn scanned_pdf(path: &std::path::Path) {
+        image_doc(b"q 72 0 0 72 0 0 cm /Im0 Do /Im1 Do Q")
+            .save(path)
+            .unwrap();
+    }
+
+    #[test]
+    fn test_resolution_follows_the_ctm_at_each_draw() {
+        // Two inches wide inside a scaled `q`, then four inches; Im1 is
+        // never drawn.
+        let doc = image_doc(
+            b"q 2 0 0 2 0 0 cm q 72 0 0 72 0 0 cm /Im0 Do Q Q 288 0 0 288 0 0 cm /Im0 Do",
+        );
+        let resolutions = image_resolutions(&doc);
+        assert_eq!(resolutions.len(), 1, "an undrawn image has no known size");
+        let dpi = resolutions.values().next().copied().unwrap();
+        assert!((dpi - 150.0).abs() < 0.01, "{dpi}");
+    }
+
+    #[test]
+    fn test_optimize_downsamples_and_dedups_images() {
+        let dir = std::env::temp_dir();
+        let input = dir.join(format!("pdfbull_optimize_in_{}.pdf", std::process::id()));
+        let output = dir.join(format!("pdfbull_optimize_out_{}.pdf", std::process::id()));
+        scanned_pdf(&input);
+
+        let report = optimize(
+            input.to_str().unwrap(),
+            output.to_str().unwrap(),
+            &OptimizeOptions::default(),
+        )
+        .unwrap();
+        let optimized = Document::load(&output).unwrap();
+        let _ = std::fs::remove_file(&input);
+        let _ = std::fs::remove_file(&output);
+
+        assert_eq!(report.images_reencoded, 2);
+        assert_eq!(report.duplicates_removed, 1);
+        assert!(report.image_bytes_saved > 0);
+        assert!(report.output_bytes < report.input_bytes / 10, "{report:?}");
+
+        let images: Vec<&Stream> = optimized
+            .objects
+            .values()
+            .filter_map(|o| o.as_stream().ok())
+            .filter(|s| {
+                s.dict.get(b"Subtype").and_then(Object::as_name).ok() == Some(&b"Image"[..])
+            })
+            .collect();
+        assert_eq!(images.len(), 1, "both names point at one copy");
+        assert_eq!(dimension(&images[0].dict, b"Width"), Some(150));
+        assert_eq!(
+            images[0].dict.get(b"Filter").and_then(Object::as_name).ok(),
+            Some(&b"DCTDecode"[..])
+        );
+    }
+}
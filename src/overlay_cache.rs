@@ -0,0 +1,110 @@
+//! Retained overlay geometry for the document view. Each page on screen
+//! keeps canvas caches for its text layer, highlights and annotation shapes;
+//! a layer is tessellated again only when the stamp of what it draws
+//! changes, so cursor moves and drags over dense pages reuse cached
+//! geometry instead of rebuilding every rectangle and glyph run.
+
+use iced::widget::canvas;
+use iced::{Renderer, Size};
+use std::cell::{Cell, RefCell};
+use std::collections::HashMap;
+use std::hash::{DefaultHasher, Hasher};
+use std::rc::Rc;
+
+/// Overlay layers of one tab's pages, created the first time a page is drawn.
+#[derive(Default)]
+pub struct OverlayCaches {
+    pages: RefCell<HashMap<usize, Rc<PageLayers>>>,
+}
+
+impl OverlayCaches {
+    pub fn page(&self, page_idx: usize) -> Rc<PageLayers> {
+        Rc::clone(self.pages.borrow_mut().entry(page_idx).or_default())
+    }
+
+    pub fn retain(&mut self, mut keep: impl FnMut(usize) -> bool) {
+        self.pages.get_mut().retain(|&page, _| keep(page));
+    }
+
+    pub fn clear(&mut self) {
+        self.pages.get_mut().clear();
+    }
+
+    pub fn len(&self) -> usize {
+        self.pages.borrow().len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+}
+
+#[derive(Default)]
+pub struct PageLayers {
+    /// Invisible text runs over the page's glyphs.
+    pub text: Layer,
+    /// Selected words and search hits.
+    pub highlights: Layer,
+    /// Line and arrow annotations.
+    pub shapes: Layer,
+}
+
+/// One cached canvas layer and the stamp of the inputs it was drawn from.
+pub struct Layer {
+    cache: canvas::Cache,
+    stamp: Cell<Option<u64>>,
+}
+
+impl Default for Layer {
+    fn default() -> Self {
+        Self {
+            cache: canvas::Cache::new(),
+            stamp: Cell::new(None),
+        }
+    }
+}
+
+impl Layer {
+    /// The layer's geometry, redrawn with `draw` only when `stamp` differs
+    /// from the one it was last drawn for or the canvas changed size.
+    pub fn draw(
+        &self,
+        renderer: &Renderer,
+        size: Size,
+        stamp: u64,
+        draw: impl FnOnce(&mut canvas::Frame),
+    ) -> canvas::Geometry {
+        if self.stamp.replace(Some(stamp)) != Some(stamp) {
+            self.cache.clear();
+        }
+        self.cache.draw(renderer, size, draw)
+    }
+}
+
+/// Hash of everything a layer is drawn from.
+pub fn stamp(parts: impl FnOnce(&mut DefaultHasher)) -> u64 {
+    let mut hasher = DefaultHasher::new();
+    parts(&mut hasher);
+    hasher.finish()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::hash::Hash;
+
+    #[test]
+    fn test_pages_keep_their_layers_until_dropped() {
+        let mut caches = OverlayCaches::default();
+        assert!(Rc::ptr_eq(&caches.page(3), &caches.page(3)));
+        caches.page(4);
+        caches.retain(|page| page == 4);
+        assert_eq!(caches.len(), 1);
+        caches.clear();
+        assert!(caches.is_empty());
+
+        let drawn = |zoom: f32| stamp(|h| zoom.to_bits().hash(h));
+        assert_eq!(drawn(1.0), drawn(1.0));
+        assert_ne!(drawn(1.0), drawn(1.25));
+    }
+}
@@ -1,12 +1,13 @@
 use crate::models::{
-    Annotation, AnnotationStyle, DocumentId, EngineErrorKind, FormField, FormFieldVariant,
-    Hyperlink, PdfError, PdfResult, SearchResultItem,
+    Annotation, AnnotationStyle, DocumentId, EngineErrorKind, ExportProgress, FormField,
+    FormFieldVariant, Hyperlink, PdfError, PdfResult, SearchResultItem,
 };
 use lopdf::{Document, Object, ObjectId};
-use quick_cache::{Weighter, sync::Cache};
+use quick_cache::{DefaultHashBuilder, Lifecycle, Weighter, sync::Cache};
 use rayon::prelude::*;
-use std::collections::HashMap;
-use std::sync::Arc;
+use std::collections::{BTreeSet, HashMap, HashSet};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Mutex, OnceLock, PoisonError, RwLock};
 use zpdf::{
     ContentInterpreter, FieldKind, FieldValue, FormFiller, ImageCache, IncrementalWriter,
     PdfDocument, RenderBackend, cpu::CpuRenderer, detect_tables, spans_to_text,
@@ -15,21 +16,36 @@ use zpdf::{
 use zune_image::codecs::ImageFormat;
 use zune_image::image::Image;
 
+use crate::commands::ExportProgressSender;
+use crate::disk_cache::DiskCache;
+use crate::text_index::{IndexedSpan, PageText, TextIndex};
 use crate::ui::theme::hex_to_rgb;
 
 // PDF field-flags bit for "radio button" (ISO 32000-1 Table 221).
 const FF_RADIO: i64 = 1 << 15;
 const WHITE_THRESHOLD: u8 = 245;
 const BBOX_MARGIN: u32 = 10;
+/// Bytes handed to each rayon task by `apply_filter`. Large enough that the
+/// per-pixel loop inside is tight and auto-vectorizes.
+const FILTER_CHUNK_BYTES: usize = 64 * 1024;
 const NO_SHADOW_THRESHOLD: u8 = 230;
 
 #[derive(Hash, Eq, PartialEq, Clone, Debug)]
 pub struct RenderKey {
     pub doc_id: DocumentId,
     pub page_num: usize,
+    pub rotation: i32,
     pub scale: u32,
     pub auto_crop: bool,
     pub quality: RenderQuality,
+    /// `(column, row)` of a `TILE_SIZE` tile, or `None` for the whole page.
+    pub tile: Option<(u32, u32)>,
+    /// Colour filter baked into the bitmap; `None` for the unfiltered base.
+    pub filter: RenderFilter,
+    /// `SharedDocument::oc_state` of the page when it was drawn.
+    pub oc_state: u64,
+    /// `SharedDocument::generation` of the document it was drawn from.
+    pub generation: u64,
 }
 
 #[derive(Clone)]
@@ -37,42 +53,296 @@ struct RenderWeighter;
 
 impl Weighter<RenderKey, crate::models::RenderResult> for RenderWeighter {
     fn weight(&self, _key: &RenderKey, val: &crate::models::RenderResult) -> u64 {
-        val.data.len() as u64
+        (val.data.len() as u64).max(1)
+    }
+}
+
+/// Hands bitmaps evicted from the raw tier back to `RenderCache::put`, which
+/// demotes them to the compressed tier once the shard lock is released.
+#[derive(Clone)]
+struct CollectEvicted;
+
+impl Lifecycle<RenderKey, crate::models::RenderResult> for CollectEvicted {
+    type RequestState = Vec<(RenderKey, crate::models::RenderResult)>;
+
+    fn begin_request(&self) -> Self::RequestState {
+        Vec::new()
+    }
+
+    fn on_evict(
+        &self,
+        state: &mut Self::RequestState,
+        key: RenderKey,
+        val: crate::models::RenderResult,
+    ) {
+        state.push((key, val));
+    }
+}
+
+/// A bitmap held run-length encoded by `crate::rle`.
+#[derive(Clone)]
+struct CompressedBitmap {
+    width: u32,
+    height: u32,
+    encoded: Arc<[u8]>,
+}
+
+#[derive(Clone)]
+struct CompressedWeighter;
+
+impl Weighter<RenderKey, CompressedBitmap> for CompressedWeighter {
+    fn weight(&self, _key: &RenderKey, val: &CompressedBitmap) -> u64 {
+        (val.encoded.len() as u64).max(1)
+    }
+}
+
+/// Identifies an interpreted page; everything that changes the display list but not the scale.
+#[derive(Hash, Eq, PartialEq, Clone, Debug)]
+pub struct DisplayListKey {
+    pub doc_id: DocumentId,
+    pub page_num: usize,
+    pub rotation: i32,
+    pub oc_state: u64,
+    pub generation: u64,
+}
+
+/// Display list produced by `ContentInterpreter::interpret`.
+type PageDisplayList = zpdf::DisplayList;
+
+/// An interpreted page, kept with the resources the rasterizer needs to draw it.
+#[derive(Clone)]
+pub struct DisplayListEntry {
+    list: Arc<PageDisplayList>,
+    resources: SharedPageResources,
+    /// Size of the content stream it was built from; a proxy for the list's footprint.
+    weight: u64,
+    /// `SharedDocument::oc_state` the page was interpreted under, read with
+    /// the layers locked for the whole pass. Renders of the list are cached
+    /// under it, not under a state read before the list was fetched.
+    oc_state: u64,
+}
+
+#[derive(Clone)]
+struct DisplayListWeighter;
+
+impl Weighter<DisplayListKey, DisplayListEntry> for DisplayListWeighter {
+    fn weight(&self, _key: &DisplayListKey, val: &DisplayListEntry) -> u64 {
+        val.weight.max(1)
     }
 }
 
 pub struct RenderCache {
-    cache: Cache<RenderKey, crate::models::RenderResult, RenderWeighter>,
+    cache: Cache<
+        RenderKey,
+        crate::models::RenderResult,
+        RenderWeighter,
+        DefaultHashBuilder,
+        CollectEvicted,
+    >,
+    /// Bitmaps evicted from `cache`, kept compressed until they are needed
+    /// again or age out in turn.
+    compressed: Cache<RenderKey, CompressedBitmap, CompressedWeighter>,
+    display_lists: Cache<DisplayListKey, DisplayListEntry, DisplayListWeighter>,
+    disk: Option<Arc<DiskCache>>,
 }
 
 impl RenderCache {
     pub fn new(capacity: usize, max_bytes: usize) -> Self {
+        let max_bytes = if max_bytes == 0 {
+            512 * 1024 * 1024
+        } else {
+            max_bytes as u64
+        };
+        let compressed_bytes = (max_bytes / COMPRESSED_BUDGET_DIVISOR).max(1);
         Self {
-            cache: Cache::with_weighter(
+            cache: Cache::with(
                 capacity.max(1),
-                if max_bytes == 0 {
-                    512 * 1024 * 1024
-                } else {
-                    max_bytes as u64
-                },
+                (max_bytes - compressed_bytes).max(1),
                 RenderWeighter,
+                DefaultHashBuilder::default(),
+                CollectEvicted,
             ),
+            compressed: Cache::with_weighter(
+                capacity.max(1) * COMPRESSED_CAPACITY_FACTOR,
+                compressed_bytes,
+                CompressedWeighter,
+            ),
+            display_lists: Cache::with_weighter(
+                capacity.max(1),
+                (max_bytes / DISPLAY_LIST_BUDGET_DIVISOR).max(1),
+                DisplayListWeighter,
+            ),
+            disk: None,
         }
     }
 
+    /// Adds a persistent tier consulted after memory misses.
+    #[must_use]
+    pub fn with_disk(mut self, disk: Option<DiskCache>) -> Self {
+        self.disk = disk.map(Arc::new);
+        self
+    }
+
+    /// Looks in the raw tier, then promotes a hit from the compressed tier.
     pub fn get(&self, key: &RenderKey) -> Option<crate::models::RenderResult> {
-        self.cache.get(key)
+        if let Some(result) = self.cache.get(key) {
+            return Some(result);
+        }
+        let (_, bitmap) = self.compressed.remove(key)?;
+        let len = bitmap.width as usize * bitmap.height as usize * 4;
+        let result = crate::models::RenderResult {
+            width: bitmap.width,
+            height: bitmap.height,
+            data: crate::rle::decode(&bitmap.encoded, len)?.into(),
+        };
+        crate::metrics::metrics().compressed_hit();
+        self.put(key.clone(), result.clone());
+        Some(result)
     }
 
     pub fn put(&self, key: RenderKey, result: crate::models::RenderResult) {
-        self.cache.insert(key, result);
+        self.compressed.remove(&key);
+        let evicted = self.cache.insert_with_lifecycle(key, result);
+        crate::metrics::metrics().cache_evictions(evicted.len());
+        for (key, evicted) in evicted {
+            self.demote(key, &evicted);
+        }
+        self.publish_resident_bytes();
+    }
+
+    /// Bytes held in memory by every tier: raw and compressed bitmaps and
+    /// display lists.
+    pub fn resident_bytes(&self) -> u64 {
+        self.cache.weight() + self.compressed.weight() + self.display_lists.weight()
+    }
+
+    fn publish_resident_bytes(&self) {
+        crate::metrics::metrics().set_engine_bytes(self.resident_bytes());
+    }
+
+    /// Empties the compressed tier; its bitmaps are the cheapest to lose,
+    /// since the disk tier or a re-render can replace them.
+    pub fn clear_compressed(&self) {
+        self.compressed.clear();
+        self.publish_resident_bytes();
+    }
+
+    /// Bytes held by the raw and the compressed tier.
+    pub fn weights(&self) -> (u64, u64) {
+        (self.cache.weight(), self.compressed.weight())
+    }
+
+    /// Bytes `key` holds in either tier, without touching its recency.
+    fn held_bytes(&self, key: &RenderKey) -> u64 {
+        let raw = self.cache.peek(key).map_or(0, |result| result.data.len());
+        let compressed = self
+            .compressed
+            .peek(key)
+            .map_or(0, |bitmap| bitmap.encoded.len());
+        (raw + compressed) as u64
+    }
+
+    /// Filtered bitmaps are not kept: re-deriving them from a cached base is
+    /// about as cheap as decoding, and they would crowd out the bases.
+    fn demote(&self, key: RenderKey, result: &crate::models::RenderResult) {
+        if key.filter != RenderFilter::None {
+            return;
+        }
+        let encoded = crate::rle::encode(&result.data);
+        if encoded.len() * MIN_COMPRESSION_RATIO <= result.data.len() {
+            self.compressed.insert(
+                key,
+                CompressedBitmap {
+                    width: result.width,
+                    height: result.height,
+                    encoded: encoded.into(),
+                },
+            );
+        }
+    }
+
+    /// Whether either tier holds `key`, without touching its recency.
+    pub fn contains(&self, key: &RenderKey) -> bool {
+        self.cache.peek(key).is_some() || self.compressed.peek(key).is_some()
     }
 
     pub fn remove(&self, key: &RenderKey) {
         self.cache.remove(key);
+        self.compressed.remove(key);
+    }
+
+    /// Moves the bitmap held under `from`, in whichever tier, to `to`.
+    pub fn rekey(&self, from: &RenderKey, to: RenderKey) {
+        if let Some((_, result)) = self.cache.remove(from) {
+            self.put(to, result);
+        } else if let Some((_, bitmap)) = self.compressed.remove(from) {
+            self.compressed.insert(to, bitmap);
+        }
+    }
+
+    pub fn get_display_list(&self, key: &DisplayListKey) -> Option<DisplayListEntry> {
+        self.display_lists.get(key)
+    }
+
+    pub fn put_display_list(&self, key: DisplayListKey, entry: DisplayListEntry) {
+        self.display_lists.insert(key, entry);
+        self.publish_resident_bytes();
+    }
+
+    pub fn remove_display_list(&self, key: &DisplayListKey) {
+        self.display_lists.remove(key);
+    }
+
+    pub fn get_persisted(
+        &self,
+        fingerprint: u64,
+        key: &RenderKey,
+    ) -> Option<crate::models::RenderResult> {
+        self.disk.as_ref()?.get(fingerprint, key)
+    }
+
+    /// Compresses and writes `result` to the disk tier on the rayon pool, so
+    /// the render worker is not held up by PNG encoding.
+    pub fn persist(&self, fingerprint: u64, key: RenderKey, result: crate::models::RenderResult) {
+        if let Some(disk) = &self.disk {
+            let disk = disk.clone();
+            rayon::spawn(move || disk.put(fingerprint, &key, &result));
+        }
     }
 }
 
+/// Pages measured synchronously on open; enough to fill the first screen.
+const INITIAL_LAYOUT_PAGES: usize = 16;
+/// Pages per document whose decoded fonts and images stay resident.
+const RESOURCE_CACHE_PAGES: usize = 48;
+/// Pages per document whose table candidates stay resident.
+const TABLE_CACHE_PAGES: usize = 48;
+/// Pages per document whose render-captured text spans wait for their text
+/// layer or tables to be requested.
+const CAPTURED_SPAN_PAGES: usize = 16;
+/// Share of the render cache budget given to interpreted display lists.
+const DISPLAY_LIST_BUDGET_DIVISOR: u64 = 4;
+/// Share of the render cache budget given to the compressed bitmap tier.
+const COMPRESSED_BUDGET_DIVISOR: u64 = 4;
+/// Compressed bitmaps are a fraction of their raw size, so the tier holds
+/// several times as many entries.
+const COMPRESSED_CAPACITY_FACTOR: usize = 4;
+/// Bitmaps that do not shrink at least this much are dropped on eviction
+/// rather than demoted; busy scans re-render about as fast as they decode.
+const MIN_COMPRESSION_RATIO: usize = 3;
+/// Pages searched in parallel before a batch of hits is handed back.
+const SEARCH_BATCH_PAGES: usize = 16;
+/// Largest page render written to the disk cache; deeper zoom levels are
+/// cheap to re-render relative to compressing them.
+const DISK_CACHE_MAX_PIXELS: u64 = 4 * 1024 * 1024;
+/// Progressive previews are rendered at this fraction of the requested scale.
+const PREVIEW_SCALE_DIVISOR: f32 = 4.0;
+/// Edge length in pixels of one tile in tiled render mode.
+pub const TILE_SIZE: u32 = 512;
+/// Pages whose bitmap at the current zoom would exceed this many pixels
+/// (64 MB of RGBA) are rendered as tiles covering the viewport only.
+pub const TILED_RENDER_MIN_PIXELS: f32 = 16.0 * 1024.0 * 1024.0;
+
 pub type SharedRenderCache = Arc<RenderCache>;
 
 #[derive(Clone, Copy, Debug, PartialEq, serde::Serialize, serde::Deserialize, Hash, Eq)]
@@ -82,6 +352,18 @@ pub enum RenderQuality {
     High,
 }
 
+/// Rasterizer display lists are drawn with. `Gpu` takes effect only in
+/// builds with the `gpu-render` feature; pages it fails on fall back to the
+/// CPU.
+#[derive(
+    Clone, Copy, Debug, Default, PartialEq, serde::Serialize, serde::Deserialize, Hash, Eq,
+)]
+pub enum RasterBackend {
+    #[default]
+    Cpu,
+    Gpu,
+}
+
 #[derive(Clone, Copy, Debug, PartialEq, serde::Serialize, serde::Deserialize, Hash, Eq)]
 pub enum RenderFilter {
     None,
@@ -103,53 +385,758 @@ pub struct RenderOptions {
     pub quality: RenderQuality,
 }
 
+/// Font set produced by `PdfDocument::load_page_fonts`.
+type PageFonts = zpdf::FontCache;
+
+/// Decoded fonts and images for one page, reused by render, text and export.
+struct PageResources {
+    fonts: PageFonts,
+    images: ImageCache,
+}
+
+/// Interpretation decodes into the resources and takes the write lock;
+/// rasterizers only read them, so renders of one page at several scales
+/// draw concurrently.
+type SharedPageResources = Arc<RwLock<PageResources>>;
+
+/// Text spans of a page as an interpretation pass saw them, with the page's
+/// height for converting them to layout space.
+#[derive(Clone)]
+struct CapturedSpans {
+    spans: Vec<zpdf::TextSpan>,
+    page_height: f32,
+}
+
+/// A parsed document plus the per-document state every worker must agree on.
+pub struct SharedDocument {
+    pub doc: PdfDocument,
+    pub path: String,
+    layers: RwLock<LayerState>,
+    /// `layer_index::page_layers` of the file, built in the background
+    /// when a document with optional content is opened. Until it is set,
+    /// every group counts for every page.
+    page_layers: OnceLock<Option<Vec<Vec<(u32, u16)>>>>,
+    /// Render keys stored for this document, by page. Keys whose bitmaps the
+    /// cache has since dropped are pruned whenever their page is stored again.
+    cache_keys: Mutex<HashMap<usize, HashSet<RenderKey>>>,
+    display_list_keys: Mutex<HashSet<DisplayListKey>>,
+    resources: Cache<usize, SharedPageResources>,
+    text_index: TextIndex,
+    /// Table candidates of recently viewed pages, found from the same spans
+    /// that fill `text_index`.
+    tables: Cache<usize, Arc<Vec<crate::models::DetectedTable>>>,
+    /// Spans renders captured for pages whose text layer or tables have not
+    /// been built yet; both are built from them on request.
+    captured_spans: Cache<usize, Arc<CapturedSpans>>,
+    /// Identifies the file's contents on disk; `None` keeps the document out
+    /// of the disk cache, which is always the case for encrypted files.
+    fingerprint: Option<u64>,
+    /// `page_content_hash` of every page, computed on the first reload.
+    page_hashes: OnceLock<Vec<Option<u64>>>,
+    /// Counts opens and reloads under the same id, so renders started before
+    /// a reload can be told apart from those after it.
+    pub generation: u64,
+    /// Pages the GPU backend failed to draw; they go straight to the CPU.
+    #[cfg_attr(not(feature = "gpu-render"), allow(dead_code))]
+    gpu_failed_pages: Mutex<HashSet<usize>>,
+}
+
+impl SharedDocument {
+    fn new(
+        doc: PdfDocument,
+        path: &str,
+        oc_config: Option<zpdf::OcConfig>,
+        generation: u64,
+    ) -> Self {
+        let page_count = doc.page_count();
+        Self {
+            path: path.to_string(),
+            layers: RwLock::new(LayerState {
+                config: oc_config,
+                defaults: HashMap::new(),
+                changed: BTreeSet::new(),
+            }),
+            page_layers: OnceLock::new(),
+            cache_keys: Mutex::new(HashMap::new()),
+            display_list_keys: Mutex::new(HashSet::new()),
+            resources: Cache::new(RESOURCE_CACHE_PAGES),
+            text_index: TextIndex::with_pages(page_count),
+            tables: Cache::new(TABLE_CACHE_PAGES),
+            captured_spans: Cache::new(CAPTURED_SPAN_PAGES),
+            fingerprint: if doc.is_encrypted() {
+                None
+            } else {
+                crate::text_index::file_fingerprint(path)
+            },
+            page_hashes: OnceLock::new(),
+            generation,
+            gpu_failed_pages: Mutex::new(HashSet::new()),
+            doc,
+        }
+    }
+
+    /// Identifies the visibility of the layers `page_num` draws: 0 while all
+    /// of them are at the document's default, and the same value whenever the
+    /// same set is toggled, so renders are shared across toggles of layers the
+    /// page does not use and found again when a layer is flipped back.
+    fn oc_state(&self, page_num: usize) -> u64 {
+        let layers = self.layers.read().unwrap_or_else(PoisonError::into_inner);
+        self.oc_state_locked(&layers, page_num)
+    }
+
+    fn oc_state_locked(&self, layers: &LayerState, page_num: usize) -> u64 {
+        if layers.changed.is_empty() {
+            return 0;
+        }
+        let referenced = self
+            .page_layers
+            .get()
+            .and_then(Option::as_ref)
+            .and_then(|pages| pages.get(page_num));
+        oc_state_hash(&layers.changed, referenced.map(Vec::as_slice))
+    }
+
+    /// Starts building `page_layers` on the rayon pool if the document has
+    /// optional content, so no render worker ever parses the file for it.
+    /// Runs right after the file is read, so the index describes the same
+    /// bytes the document was parsed from.
+    fn index_layers_in_background(self: &Arc<Self>) {
+        let has_layers = self
+            .layers
+            .read()
+            .unwrap_or_else(PoisonError::into_inner)
+            .config
+            .is_some();
+        if !has_layers {
+            return;
+        }
+        let shared = Arc::clone(self);
+        rayon::spawn(move || {
+            shared.page_layers.get_or_init(|| {
+                crate::layer_index::page_layers(&shared.path, shared.doc.page_count())
+            });
+        });
+    }
+
+    fn page_hashes(&self) -> &[Option<u64>] {
+        self.page_hashes.get_or_init(|| {
+            let streams = StreamHashes::default();
+            (0..self.doc.page_count())
+                .into_par_iter()
+                .map(|page_num| page_content_hash(&self.doc, page_num, &streams))
+                .collect()
+        })
+    }
+
+    /// Decoded resources for `page_num`, loading the page's fonts on a miss.
+    fn page_resources(
+        &self,
+        page_num: usize,
+        load_fonts: impl FnOnce() -> PageFonts,
+    ) -> SharedPageResources {
+        let Ok(resources) = self.resources.get_or_insert_with(&page_num, || {
+            Ok::<_, std::convert::Infallible>(Arc::new(RwLock::new(PageResources {
+                fonts: load_fonts(),
+                images: ImageCache::new(),
+            })))
+        });
+        resources
+    }
+
+    /// Cached resources for `page_num` without inserting; used by whole-document passes.
+    fn cached_page_resources(&self, page_num: usize) -> Option<SharedPageResources> {
+        self.resources.get(&page_num)
+    }
+
+    /// Fingerprint under which `key` may use the disk cache: whole, unfiltered
+    /// renders of unencrypted files at their default layer state.
+    fn disk_fingerprint(&self, key: &RenderKey) -> Option<u64> {
+        let eligible = key.tile.is_none() && key.filter == RenderFilter::None && key.oc_state == 0;
+        self.fingerprint.filter(|_| eligible)
+    }
+
+    /// Records `key` once it is in `cache`, dropping the keys of the same
+    /// page that `cache` has evicted since. Call after the put, so a key
+    /// another worker is about to store is never pruned.
+    fn track_cache_key(&self, cache: &RenderCache, key: RenderKey) {
+        if let Ok(mut keys) = self.cache_keys.lock() {
+            let page = keys.entry(key.page_num).or_default();
+            page.retain(|tracked| cache.contains(tracked));
+            page.insert(key);
+        }
+    }
+
+    /// Cached whole-page renders of `page_num`, at any scale or quality.
+    fn page_cache_keys(&self, page_num: usize) -> Vec<RenderKey> {
+        self.cache_keys
+            .lock()
+            .map(|keys| {
+                keys.get(&page_num)
+                    .into_iter()
+                    .flatten()
+                    .filter(|key| key.tile.is_none())
+                    .cloned()
+                    .collect()
+            })
+            .unwrap_or_default()
+    }
+
+    fn take_cache_keys(&self) -> Vec<RenderKey> {
+        self.cache_keys
+            .lock()
+            .map(|mut keys| keys.drain().flat_map(|(_, page)| page).collect())
+            .unwrap_or_default()
+    }
+
+    fn track_display_list_key(&self, key: DisplayListKey) {
+        if let Ok(mut keys) = self.display_list_keys.lock() {
+            keys.insert(key);
+        }
+    }
+
+    fn take_display_list_keys(&self) -> Vec<DisplayListKey> {
+        self.display_list_keys
+            .lock()
+            .map(|mut keys| keys.drain().collect())
+            .unwrap_or_default()
+    }
+}
+
+/// Optional content visibility of a document, shared by every worker.
+struct LayerState {
+    config: Option<zpdf::OcConfig>,
+    /// Visibility each toggled group had when the document was opened.
+    defaults: HashMap<(u32, u16), bool>,
+    /// Groups currently toggled away from `defaults`.
+    changed: BTreeSet<(u32, u16)>,
+}
+
+/// Hashes the groups of `changed` that a page references; 0 when there are
+/// none. `referenced` is `None` when the page's groups are unknown, in which
+/// case every change counts.
+fn oc_state_hash(changed: &BTreeSet<(u32, u16)>, referenced: Option<&[(u32, u16)]>) -> u64 {
+    use std::hash::{Hash, Hasher};
+
+    let mut hasher = std::hash::DefaultHasher::new();
+    let mut any = false;
+    for id in changed
+        .iter()
+        .filter(|id| referenced.is_none_or(|groups| groups.contains(id)))
+    {
+        id.hash(&mut hasher);
+        any = true;
+    }
+    if any { hasher.finish().max(1) } else { 0 }
+}
+
+/// Hashes of stream bodies by object, shared by the pages hashed in one
+/// pass so a font or image used on every page is read once.
+type StreamHashes = Mutex<HashMap<zpdf::ObjectId, u64>>;
+
+/// Hash of everything that decides how a page draws: its content stream,
+/// page box, rotation and resources. Resources are followed through every
+/// reference, so an image, font or form XObject that changed is noticed
+/// even when the content stream naming it did not. `None` if the page
+/// cannot be read, which never compares equal.
+fn page_content_hash(doc: &PdfDocument, page_num: usize, streams: &StreamHashes) -> Option<u64> {
+    use std::hash::{Hash, Hasher};
+
+    let page = doc.page(page_num).ok()?;
+    let content = doc.page_content_bytes(&page).ok()?;
+    let rect = page.effective_box();
+    let mut hasher = std::hash::DefaultHasher::new();
+    content.hash(&mut hasher);
+    rect.x0.to_bits().hash(&mut hasher);
+    rect.y0.to_bits().hash(&mut hasher);
+    rect.width().to_bits().hash(&mut hasher);
+    rect.height().to_bits().hash(&mut hasher);
+    page.rotate.hash(&mut hasher);
+    let mut resources = ResourceHasher {
+        doc,
+        streams,
+        hasher: &mut hasher,
+        visited: HashSet::new(),
+    };
+    resources.dict(&page.resources, 0);
+    Some(hasher.finish())
+}
+
+/// References followed at most this deep when hashing a page's resources.
+const MAX_RESOURCE_DEPTH: usize = 32;
+
+/// Feeds a page's resource tree into a hasher, resolving references and
+/// visiting each object once.
+struct ResourceHasher<'a> {
+    doc: &'a PdfDocument,
+    streams: &'a StreamHashes,
+    hasher: &'a mut std::hash::DefaultHasher,
+    visited: HashSet<zpdf::ObjectId>,
+}
+
+impl ResourceHasher<'_> {
+    fn object(&mut self, object: &zpdf::PdfObject, depth: usize) {
+        use std::hash::Hash;
+
+        match object {
+            zpdf::PdfObject::Ref(id) => {
+                (id.0, id.1).hash(self.hasher);
+                if depth >= MAX_RESOURCE_DEPTH || !self.visited.insert(*id) {
+                    return;
+                }
+                match self.doc.file().resolve(*id) {
+                    Ok(zpdf::PdfObject::Stream(stream)) => {
+                        self.dict(&stream.dict, depth + 1);
+                        self.stream_data(*id, &stream.data).hash(self.hasher);
+                    }
+                    Ok(target) => self.object(&target, depth + 1),
+                    Err(_) => {}
+                }
+            }
+            zpdf::PdfObject::Dict(dict) => self.dict(dict, depth),
+            zpdf::PdfObject::Array(items) => {
+                items.len().hash(self.hasher);
+                for item in items {
+                    self.object(item, depth);
+                }
+            }
+            zpdf::PdfObject::Stream(stream) => {
+                self.dict(&stream.dict, depth);
+                stream.data.hash(self.hasher);
+            }
+            other => format!("{other:?}").hash(self.hasher),
+        }
+    }
+
+    /// Entries in key order, so equal dictionaries hash equally whatever
+    /// order they were parsed in.
+    fn dict(&mut self, dict: &zpdf::PdfDict, depth: usize) {
+        use std::hash::Hash;
+
+        let mut entries: Vec<_> = dict.iter().collect();
+        entries.sort_by(|a, b| a.0.cmp(b.0));
+        for (key, value) in entries {
+            key.hash(self.hasher);
+            self.object(value, depth);
+        }
+    }
+
+    fn stream_data(&self, id: zpdf::ObjectId, data: &[u8]) -> u64 {
+        use std::hash::{Hash, Hasher};
+
+        if let Some(&hash) = self
+            .streams
+            .lock()
+            .unwrap_or_else(PoisonError::into_inner)
+            .get(&id)
+        {
+            return hash;
+        }
+        let mut hasher = std::hash::DefaultHasher::new();
+        data.hash(&mut hasher);
+        let hash = hasher.finish();
+        self.streams
+            .lock()
+            .unwrap_or_else(PoisonError::into_inner)
+            .insert(id, hash);
+        hash
+    }
+}
+
+/// Pixel size of `page`'s whole bitmap at `scale`, with `rotation` applied
+/// on top of the page's own.
+fn page_pixel_size(page: &zpdf::Page, rotation: i32, scale: f32) -> (u32, u32) {
+    let rect = page.effective_box();
+    let (width, height) = (rect.width() as f32 * scale, rect.height() as f32 * scale);
+    let (width, height) = if (page.rotate + rotation).rem_euclid(180) == 90 {
+        (height, width)
+    } else {
+        (width, height)
+    };
+    (width.ceil().max(1.0) as u32, height.ceil().max(1.0) as u32)
+}
+
+/// Threads every image export renders and encodes on. One pool for all of
+/// them, sized to half the cores so the render workers keep the rest;
+/// concurrent exports share it instead of each starting their own.
+fn export_pool() -> PdfResult<&'static rayon::ThreadPool> {
+    static POOL: OnceLock<Result<rayon::ThreadPool, String>> = OnceLock::new();
+    POOL.get_or_init(|| {
+        let threads = std::thread::available_parallelism()
+            .map(|n| (n.get() / 2).max(1))
+            .unwrap_or(2);
+        rayon::ThreadPoolBuilder::new()
+            .num_threads(threads)
+            .thread_name(|i| format!("pdf-export-{i}"))
+            .build()
+            .map_err(|e| e.to_string())
+    })
+    .as_ref()
+    .map_err(|e| PdfError::IoError(e.clone()))
+}
+
+/// Copies the `TILE_SIZE` tile at `(x0, y0)` out of a `w` x `h` RGBA bitmap,
+/// clipped to the bitmap. Empty when the origin lies outside it.
+fn slice_tile(page_data: &[u8], (w, h): (u32, u32), (x0, y0): (u32, u32)) -> (u32, u32, Vec<u8>) {
+    if x0 >= w || y0 >= h {
+        return (0, 0, Vec::new());
+    }
+    let tile_w = TILE_SIZE.min(w - x0);
+    let tile_h = TILE_SIZE.min(h - y0);
+    let mut data = Vec::with_capacity((tile_w * tile_h * 4) as usize);
+    for y in y0..y0 + tile_h {
+        let start = ((y * w + x0) * 4) as usize;
+        let end = start + (tile_w * 4) as usize;
+        data.extend_from_slice(&page_data[start..end]);
+    }
+    (tile_w, tile_h, data)
+}
+
+/// Documents parsed once and handed out to every engine worker as cheap `Arc` handles.
+#[derive(Default)]
+pub struct DocumentRegistry {
+    documents: RwLock<HashMap<DocumentId, Arc<SharedDocument>>>,
+    /// Held for every GPU render by any worker on the registry. A zpdf
+    /// `WgpuRenderer` borrows one page's fonts and images and brings up its
+    /// own device, so it cannot be kept across pages; this keeps workers
+    /// from standing up several devices at once instead.
+    #[cfg(feature = "gpu-render")]
+    gpu_lane: Mutex<()>,
+}
+
+impl DocumentRegistry {
+    pub fn get(&self, doc_id: DocumentId) -> Option<Arc<SharedDocument>> {
+        self.documents
+            .read()
+            .ok()
+            .and_then(|guard| guard.get(&doc_id).cloned())
+    }
+
+    pub fn contains(&self, doc_id: DocumentId) -> bool {
+        self.documents
+            .read()
+            .is_ok_and(|guard| guard.contains_key(&doc_id))
+    }
+
+    pub fn find_by_path(&self, path: &str) -> Option<Arc<SharedDocument>> {
+        self.documents
+            .read()
+            .ok()
+            .and_then(|guard| guard.values().find(|d| d.path == path).cloned())
+    }
+
+    fn all(&self) -> Vec<(DocumentId, Arc<SharedDocument>)> {
+        self.documents
+            .read()
+            .map(|guard| guard.iter().map(|(id, doc)| (*id, doc.clone())).collect())
+            .unwrap_or_default()
+    }
+
+    fn insert(&self, doc_id: DocumentId, doc: SharedDocument) -> Option<Arc<SharedDocument>> {
+        self.documents
+            .write()
+            .ok()
+            .and_then(|mut guard| guard.insert(doc_id, Arc::new(doc)))
+    }
+
+    fn remove(&self, doc_id: DocumentId) -> Option<Arc<SharedDocument>> {
+        self.documents
+            .write()
+            .ok()
+            .and_then(|mut guard| guard.remove(&doc_id))
+    }
+}
+
+pub type SharedDocumentRegistry = Arc<DocumentRegistry>;
+
 pub struct DocumentStore {
-    documents: HashMap<DocumentId, PdfDocument>,
-    paths: HashMap<DocumentId, String>,
+    registry: SharedDocumentRegistry,
     render_cache: SharedRenderCache,
-    cache_keys: HashMap<DocumentId, Vec<RenderKey>>,
-    oc_configs: HashMap<DocumentId, zpdf::OcConfig>,
+    /// Whether display lists go to the GPU backend first.
+    #[cfg(feature = "gpu-render")]
+    gpu: bool,
 }
 
 // DocumentState wrapper removed as it was a single-field struct.
 
 impl DocumentStore {
     pub fn new(cache: SharedRenderCache) -> Self {
+        Self::with_registry(cache, create_document_registry())
+    }
+
+    /// Build a store that shares parsed documents with every other store on `registry`.
+    pub fn with_registry(cache: SharedRenderCache, registry: SharedDocumentRegistry) -> Self {
         Self {
-            documents: HashMap::new(),
-            paths: HashMap::new(),
+            registry,
             render_cache: cache,
-            cache_keys: HashMap::new(),
-            oc_configs: HashMap::new(),
+            #[cfg(feature = "gpu-render")]
+            gpu: false,
+        }
+    }
+
+    #[must_use]
+    pub fn with_backend(mut self, backend: RasterBackend) -> Self {
+        if backend == RasterBackend::Gpu && !cfg!(feature = "gpu-render") {
+            tracing::warn!("GPU rendering requested but not built in; using the CPU");
         }
+        #[cfg(feature = "gpu-render")]
+        {
+            self.gpu = backend == RasterBackend::Gpu;
+        }
+        self
+    }
+
+    /// Engine metrics plus what the render cache holds, in total and for
+    /// each open document.
+    pub fn metrics_snapshot(&self) -> crate::metrics::MetricsSnapshot {
+        let mut snapshot = crate::metrics::metrics().snapshot();
+        (snapshot.cache_bytes, snapshot.compressed_bytes) = self.render_cache.weights();
+        snapshot.document_bytes = self
+            .registry
+            .all()
+            .into_iter()
+            .map(|(doc_id, shared)| {
+                let keys = shared
+                    .cache_keys
+                    .lock()
+                    .unwrap_or_else(PoisonError::into_inner);
+                let bytes = keys
+                    .values()
+                    .flatten()
+                    .map(|key| self.render_cache.held_bytes(key))
+                    .sum();
+                (doc_id.0, bytes)
+            })
+            .collect();
+        snapshot
+    }
+
+    pub fn has_document(&self, doc_id: DocumentId) -> bool {
+        self.registry.contains(doc_id)
+    }
+
+    fn document(&self, doc_id: DocumentId) -> PdfResult<Arc<SharedDocument>> {
+        self.registry
+            .get(doc_id)
+            .ok_or(PdfError::EngineError(EngineErrorKind::DocumentNotFound))
+    }
+
+    fn invalidate_renders(&self, shared: &SharedDocument) {
+        for key in shared.take_cache_keys() {
+            self.render_cache.remove(&key);
+        }
+        for key in shared.take_display_list_keys() {
+            self.render_cache.remove_display_list(&key);
+        }
+    }
+
+    /// Interpreted display list for a page, reusing a cached one when the
+    /// rotation and layer state still match.
+    fn page_display_list(
+        &self,
+        shared: &SharedDocument,
+        doc_id: DocumentId,
+        page_num: usize,
+        rotation: i32,
+    ) -> PdfResult<DisplayListEntry> {
+        let layers = shared.layers.read().unwrap_or_else(PoisonError::into_inner);
+        let key = DisplayListKey {
+            doc_id,
+            page_num,
+            rotation,
+            oc_state: shared.oc_state_locked(&layers, page_num),
+            generation: shared.generation,
+        };
+        if let Some(entry) = self.render_cache.get_display_list(&key) {
+            return Ok(entry);
+        }
+
+        let doc = &shared.doc;
+        let page = doc
+            .page(page_num)
+            .map_err(|_| PdfError::PageNotFound(page_num))?;
+        let content = doc
+            .page_content_bytes(&page)
+            .map_err(|e| PdfError::RenderFailed(e.to_string()))?;
+
+        // The spans for the text layer and table candidates come from this
+        // same pass when it sees the page as a text-only pass would:
+        // unrotated, with every layer drawn. Only the spans are kept here;
+        // the rest is built when the UI asks for it.
+        let capture_text = layers.config.is_none()
+            && (page.rotate + rotation).rem_euclid(360) == 0
+            && shared.captured_spans.peek(&page_num).is_none()
+            && (shared.text_index.page(page_num).is_none()
+                || shared.tables.peek(&page_num).is_none());
+        let mut spans: Vec<zpdf::TextSpan> = Vec::new();
+
+        let resources = shared.page_resources(page_num, || doc.load_page_fonts(&page));
+        let list = {
+            let mut guard = resources.write().unwrap_or_else(PoisonError::into_inner);
+            let PageResources { fonts, images } = &mut *guard;
+
+            // Incorporate custom option rotation into the display list rotation
+            let mut interp = ContentInterpreter::new(page.effective_box())
+                .with_page_rotation(page.rotate + rotation)
+                .with_fonts(fonts)
+                .with_document(doc.file(), &page.resources)
+                .with_images(images);
+
+            if let Some(oc) = &layers.config {
+                interp = interp.with_optional_content(oc);
+            }
+            if capture_text {
+                interp = interp.with_text_sink(&mut spans);
+            }
+
+            let started = std::time::Instant::now();
+            let list = interp.interpret(&content);
+            crate::metrics::metrics().record_interpret(started.elapsed());
+            list
+        };
+        if capture_text {
+            let page_height = page.effective_box().height() as f32;
+            Self::record_page_spans(shared, page_num, page_height, spans);
+        }
+
+        let entry = DisplayListEntry {
+            list: Arc::new(list),
+            resources,
+            weight: content.len() as u64,
+            oc_state: key.oc_state,
+        };
+        shared.track_display_list_key(key.clone());
+        self.render_cache.put_display_list(key, entry.clone());
+        Ok(entry)
+    }
+
+    pub fn open_document(
+        &mut self,
+        path: &str,
+        password: Option<&str>,
+        doc_id: DocumentId,
+    ) -> PdfResult<crate::models::OpenResult> {
+        let (doc, file_bytes) = Self::parse_document(path, password)?;
+        let generation = self.registry.get(doc_id).map_or(0, |d| d.generation + 1);
+        let mut result = Self::open_result(&doc, doc_id, generation, file_bytes);
+
+        // Layer visibility is seeded here so the first render already honours
+        // the document's default OC state; the layer list itself is deferred.
+        let oc_config = doc.oc_config();
+        let shared = SharedDocument::new(doc, path, oc_config, generation);
+        result.fingerprint = shared.fingerprint;
+        if let Some(previous) = self.registry.insert(doc_id, shared) {
+            self.invalidate_renders(&previous);
+        }
+        if let Some(shared) = self.registry.get(doc_id) {
+            shared.index_layers_in_background();
+        }
+
+        Ok(result)
+    }
+
+    /// Re-reads a document that changed on disk, keeping its id. Cached
+    /// renders survive for every page whose `page_content_hash` is unchanged;
+    /// only the rest are dropped. Encrypted documents fail with
+    /// `PasswordRequired`, as the password is not kept.
+    pub fn reload_document(
+        &mut self,
+        doc_id: DocumentId,
+    ) -> PdfResult<crate::models::ReloadResult> {
+        let previous = self.document(doc_id)?;
+        if previous.doc.is_encrypted() {
+            return Err(PdfError::PasswordRequired);
+        }
+        let (doc, file_bytes) = Self::parse_document(&previous.path, None)?;
+        let generation = previous.generation + 1;
+        let mut open = Self::open_result(&doc, doc_id, generation, file_bytes);
+
+        let oc_config = doc.oc_config();
+        let shared = SharedDocument::new(doc, &previous.path, oc_config, generation);
+        open.fingerprint = shared.fingerprint;
+        // Pages drawn under toggled layers do not match the reset layer state.
+        let old_hashes = previous.page_hashes();
+        let changed_pages: Vec<usize> = shared
+            .page_hashes()
+            .iter()
+            .enumerate()
+            .filter(|&(page, hash)| {
+                hash.is_none() || old_hashes.get(page) != Some(hash) || previous.oc_state(page) != 0
+            })
+            .map(|(page, _)| page)
+            .collect();
+
+        let stale: HashSet<usize> = changed_pages.iter().copied().collect();
+        for key in previous.take_cache_keys() {
+            if key.oc_state != 0 || key.page_num >= open.page_count || stale.contains(&key.page_num)
+            {
+                self.render_cache.remove(&key);
+            } else {
+                // Renders still in flight for `previous` store under its
+                // generation and are never found again.
+                let kept = RenderKey {
+                    generation,
+                    ..key.clone()
+                };
+                self.render_cache.rekey(&key, kept.clone());
+                shared.track_cache_key(&self.render_cache, kept);
+            }
+        }
+        for key in previous.take_display_list_keys() {
+            self.render_cache.remove_display_list(&key);
+        }
+        self.registry.insert(doc_id, shared);
+        if let Some(shared) = self.registry.get(doc_id) {
+            shared.index_layers_in_background();
+        }
+
+        Ok(crate::models::ReloadResult {
+            open,
+            changed_pages,
+        })
     }
 
-    pub fn has_document(&self, doc_id: DocumentId) -> bool {
-        self.documents.contains_key(&doc_id)
+    /// The parsed document and the size of the file it was read from.
+    fn parse_document(path: &str, password: Option<&str>) -> PdfResult<(PdfDocument, u64)> {
+        let data = std::fs::read(path).map_err(|e| PdfError::OpenFailed(e.to_string()))?;
+        let file_bytes = data.len() as u64;
+        match PdfDocument::open_with_password(data, password.unwrap_or("").as_bytes()) {
+            Ok(doc) => Ok((doc, file_bytes)),
+            Err(zpdf::Error::WrongPassword) => Err(PdfError::PasswordRequired),
+            Err(e) => Err(PdfError::OpenFailed(e.to_string())),
+        }
     }
 
-    pub fn open_document(
-        &mut self,
-        path: &str,
-        password: Option<&str>,
+    fn open_result(
+        doc: &PdfDocument,
         doc_id: DocumentId,
-    ) -> PdfResult<crate::models::OpenResult> {
-        let data = std::fs::read(path).map_err(|e| PdfError::OpenFailed(e.to_string()))?;
-        let doc = match PdfDocument::open_with_password(data, password.unwrap_or("").as_bytes()) {
-            Ok(doc) => doc,
-            Err(zpdf::Error::WrongPassword) => {
-                return Err(PdfError::PasswordRequired);
-            }
-            Err(e) => {
-                return Err(PdfError::OpenFailed(e.to_string()));
-            }
-        };
+        generation: u64,
+        file_bytes: u64,
+    ) -> crate::models::OpenResult {
+        let (page_heights, max_width) = Self::measure_pages(doc, INITIAL_LAYOUT_PAGES);
+        let info = doc.info();
+        let xmp = doc.xmp_metadata();
+        crate::models::OpenResult {
+            id: doc_id,
+            page_count: doc.page_count(),
+            page_heights,
+            max_width,
+            metadata: Self::doc_info_to_metadata(info.as_ref(), xmp.as_ref()),
+            is_encrypted: doc.is_encrypted(),
+            generation,
+            file_bytes,
+            // Taken from the `SharedDocument`, which computes it once.
+            fingerprint: None,
+        }
+    }
 
+    /// Measures the first `limit` pages and fills the rest with the last
+    /// measured height, so the view can lay out before every page is parsed.
+    fn measure_pages(doc: &PdfDocument, limit: usize) -> (Vec<f32>, f32) {
         let page_count = doc.page_count();
         let mut heights = Vec::with_capacity(page_count);
         let mut max_width = 0.0;
 
-        for i in 0..page_count {
+        for i in 0..page_count.min(limit) {
             if let Ok(page) = doc.page(i) {
                 let rect = page.effective_box();
                 let w = rect.width() as f32;
@@ -163,137 +1150,14 @@ impl DocumentStore {
             }
         }
 
-        let outline = self.get_outline_internal(&doc);
-        let links = self.extract_links_internal(&doc);
-        let info = doc.info();
-        let xmp = doc.xmp_metadata();
-        let metadata = Self::doc_info_to_metadata(info.as_ref(), xmp.as_ref());
-
-        let page_labels_obj = doc.page_labels();
-        let page_labels: Vec<String> = (0..page_count)
-            .map(|i| {
-                page_labels_obj
-                    .as_ref()
-                    .and_then(|pl| pl.label(i))
-                    .unwrap_or_else(|| (i + 1).to_string())
-            })
-            .collect();
-        let is_encrypted = doc.is_encrypted();
-        let signatures = doc
-            .signatures()
-            .into_iter()
-            .map(|sig| crate::models::SignatureInfo {
-                field_name: sig.field_name,
-                signer_name: sig.signer_common_name.or(sig.name),
-                signing_time: sig.signing_time,
-                location: sig.location,
-                reason: sig.reason,
-                digest_verified: matches!(sig.digest, zpdf::DigestStatus::Verified),
-                crypto_valid: matches!(sig.crypto, zpdf::CryptoStatus::Valid),
-            })
-            .collect();
-
-        let attachments = doc
-            .embedded_files()
-            .into_iter()
-            .map(|ef| crate::models::AttachmentInfo {
-                name: ef.name,
-                description: ef.description,
-                size: ef.size,
-                creation_date: ef.creation_date,
-                mod_date: ef.mod_date,
-                object_id: ef.stream.map(|id| (id.0, id.1)),
-            })
-            .collect();
-
-        let oc_config = doc.oc_config();
-        let mut layers = Vec::new();
-        if let Some(oc) = &oc_config {
-            if let Ok(root_ref) = doc.file().trailer.get_ref("Root") {
-                if let Ok(root) = doc.file().resolve(root_ref) {
-                    if let Ok(root_dict) = root.as_dict() {
-                        if let Some(ocp_obj) = root_dict.get("OCProperties") {
-                            let resolved_ocp = match ocp_obj {
-                                zpdf::PdfObject::Ref(r) => doc.file().resolve(*r).ok(),
-                                other => Some(other.clone()),
-                            };
-                            if let Some(zpdf::PdfObject::Dict(ocp_dict)) = &resolved_ocp {
-                                if let Some(ocgs_obj) = ocp_dict.get("OCGs") {
-                                    let resolved_ocgs = match ocgs_obj {
-                                        zpdf::PdfObject::Ref(r) => doc.file().resolve(*r).ok(),
-                                        other => Some(other.clone()),
-                                    };
-                                    if let Some(zpdf::PdfObject::Array(ocgs_arr)) = &resolved_ocgs {
-                                        for item in ocgs_arr {
-                                            if let zpdf::PdfObject::Ref(r) = item {
-                                                if let Ok(ocg_obj) = doc.file().resolve(*r) {
-                                                    if let Ok(ocg_dict) = ocg_obj.as_dict() {
-                                                        let name_opt =
-                                                            ocg_dict.get("Name").and_then(|n| {
-                                                                let resolved = match n {
-                                                                    zpdf::PdfObject::Ref(
-                                                                        ref_id,
-                                                                    ) => doc
-                                                                        .file()
-                                                                        .resolve(*ref_id)
-                                                                        .ok()?,
-                                                                    other => other.clone(),
-                                                                };
-                                                                resolved
-                                                                    .as_name()
-                                                                    .map(ToString::to_string)
-                                                                    .or_else(|_| {
-                                                                        resolved.as_str().map(|s| {
-                                                                            String::from_utf8_lossy(
-                                                                                &s.0,
-                                                                            )
-                                                                            .to_string()
-                                                                        })
-                                                                    })
-                                                                    .ok()
-                                                            });
-                                                        if let Some(name) = name_opt {
-                                                            let visible = oc.group_visible(*r);
-                                                            layers.push(crate::models::LayerInfo {
-                                                                name,
-                                                                object_id: (r.0, r.1),
-                                                                visible,
-                                                            });
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
-        if let Some(oc) = &oc_config {
-            self.oc_configs.insert(doc_id, oc.clone());
-        }
-        self.documents.insert(doc_id, doc);
-        self.paths.insert(doc_id, path.to_string());
-
-        Ok(crate::models::OpenResult {
-            id: doc_id,
-            page_count,
-            page_heights: heights,
-            max_width,
-            outline,
-            links,
-            metadata,
-            page_labels,
-            is_encrypted,
-            signatures,
-            attachments,
-            layers,
-            oc_config,
-        })
+        let estimate = heights
+            .iter()
+            .rev()
+            .copied()
+            .find(|h| *h > 0.0)
+            .unwrap_or(0.0);
+        heights.resize(page_count, estimate);
+        (heights, max_width)
     }
 
     fn extract_links_internal(&self, doc: &PdfDocument) -> Vec<Hyperlink> {
@@ -332,10 +1196,8 @@ impl DocumentStore {
         &mut self,
         doc_id: DocumentId,
     ) -> PdfResult<crate::models::DocumentMeta> {
-        let doc = self
-            .documents
-            .get(&doc_id)
-            .ok_or(PdfError::EngineError(EngineErrorKind::DocumentNotFound))?;
+        let shared = self.document(doc_id)?;
+        let doc = &shared.doc;
 
         let outline = self.get_outline_internal(doc);
         let links = self.extract_links_internal(doc);
@@ -383,59 +1245,79 @@ impl DocumentStore {
             .collect();
 
         let oc_config = doc.oc_config();
+        let layers = oc_config
+            .as_ref()
+            .map(|oc| Self::collect_layers(doc, oc))
+            .unwrap_or_default();
+        let (page_heights, max_width) = Self::measure_pages(doc, usize::MAX);
+
+        Ok(crate::models::DocumentMeta {
+            page_heights,
+            max_width,
+            outline,
+            links,
+            metadata,
+            page_labels,
+            is_encrypted,
+            signatures,
+            attachments,
+            layers,
+            oc_config,
+        })
+    }
+
+    /// Walks `/OCProperties/OCGs` and reports each named group with its
+    /// visibility under `oc`.
+    fn collect_layers(doc: &PdfDocument, oc: &zpdf::OcConfig) -> Vec<crate::models::LayerInfo> {
         let mut layers = Vec::new();
-        if let Some(oc) = &oc_config {
-            if let Ok(root_ref) = doc.file().trailer.get_ref("Root") {
-                if let Ok(root) = doc.file().resolve(root_ref) {
-                    if let Ok(root_dict) = root.as_dict() {
-                        if let Some(ocp_obj) = root_dict.get("OCProperties") {
-                            let resolved_ocp = match ocp_obj {
-                                zpdf::PdfObject::Ref(r) => doc.file().resolve(*r).ok(),
-                                other => Some(other.clone()),
-                            };
-                            if let Some(zpdf::PdfObject::Dict(ocp_dict)) = &resolved_ocp {
-                                if let Some(ocgs_obj) = ocp_dict.get("OCGs") {
-                                    let resolved_ocgs = match ocgs_obj {
-                                        zpdf::PdfObject::Ref(r) => doc.file().resolve(*r).ok(),
-                                        other => Some(other.clone()),
-                                    };
-                                    if let Some(zpdf::PdfObject::Array(ocgs_arr)) = &resolved_ocgs {
-                                        for item in ocgs_arr {
-                                            if let zpdf::PdfObject::Ref(r) = item {
-                                                if let Ok(ocg_obj) = doc.file().resolve(*r) {
-                                                    if let Ok(ocg_dict) = ocg_obj.as_dict() {
-                                                        let name_opt =
-                                                            ocg_dict.get("Name").and_then(|n| {
-                                                                let resolved = match n {
-                                                                    zpdf::PdfObject::Ref(
-                                                                        ref_id,
-                                                                    ) => doc
-                                                                        .file()
-                                                                        .resolve(*ref_id)
-                                                                        .ok()?,
-                                                                    other => other.clone(),
-                                                                };
-                                                                resolved
-                                                                    .as_name()
-                                                                    .map(ToString::to_string)
-                                                                    .or_else(|_| {
-                                                                        resolved.as_str().map(|s| {
-                                                                            String::from_utf8_lossy(
-                                                                                &s.0,
-                                                                            )
-                                                                            .to_string()
-                                                                        })
+        if let Ok(root_ref) = doc.file().trailer.get_ref("Root") {
+            if let Ok(root) = doc.file().resolve(root_ref) {
+                if let Ok(root_dict) = root.as_dict() {
+                    if let Some(ocp_obj) = root_dict.get("OCProperties") {
+                        let resolved_ocp = match ocp_obj {
+                            zpdf::PdfObject::Ref(r) => doc.file().resolve(*r).ok(),
+                            other => Some(other.clone()),
+                        };
+                        if let Some(zpdf::PdfObject::Dict(ocp_dict)) = &resolved_ocp {
+                            if let Some(ocgs_obj) = ocp_dict.get("OCGs") {
+                                let resolved_ocgs = match ocgs_obj {
+                                    zpdf::PdfObject::Ref(r) => doc.file().resolve(*r).ok(),
+                                    other => Some(other.clone()),
+                                };
+                                if let Some(zpdf::PdfObject::Array(ocgs_arr)) = &resolved_ocgs {
+                                    for item in ocgs_arr {
+                                        if let zpdf::PdfObject::Ref(r) = item {
+                                            if let Ok(ocg_obj) = doc.file().resolve(*r) {
+                                                if let Ok(ocg_dict) = ocg_obj.as_dict() {
+                                                    let name_opt =
+                                                        ocg_dict.get("Name").and_then(|n| {
+                                                            let resolved = match n {
+                                                                zpdf::PdfObject::Ref(ref_id) => doc
+                                                                    .file()
+                                                                    .resolve(*ref_id)
+                                                                    .ok()?,
+                                                                other => other.clone(),
+                                                            };
+                                                            resolved
+                                                                .as_name()
+                                                                .map(ToString::to_string)
+                                                                .or_else(|_| {
+                                                                    resolved.as_str().map(|s| {
+                                                                        String::from_utf8_lossy(
+                                                                            &s.0,
+                                                                        )
+                                                                        .to_string()
                                                                     })
-                                                                    .ok()
-                                                            });
-                                                        if let Some(name) = name_opt {
-                                                            let visible = oc.group_visible(*r);
-                                                            layers.push(crate::models::LayerInfo {
-                                                                name,
-                                                                object_id: (r.0, r.1),
-                                                                visible,
-                                                            });
-                                                        }
+                                                                })
+                                                                .ok()
+                                                        });
+                                                    if let Some(name) = name_opt {
+                                                        let visible = oc.group_visible(*r);
+                                                        layers.push(crate::models::LayerInfo {
+                                                            name,
+                                                            object_id: (r.0, r.1),
+                                                            visible,
+                                                        });
                                                     }
                                                 }
                                             }
@@ -448,62 +1330,90 @@ impl DocumentStore {
                 }
             }
         }
+        layers
+    }
 
-        if let Some(oc) = &oc_config {
-            self.oc_configs.insert(doc_id, oc.clone());
+    pub fn close_document(&mut self, doc_id: DocumentId) {
+        if let Some(shared) = self.registry.remove(doc_id) {
+            self.invalidate_renders(&shared);
+            self.render_cache.publish_resident_bytes();
         }
-
-        Ok(crate::models::DocumentMeta {
-            outline,
-            links,
-            metadata,
-            page_labels,
-            is_encrypted,
-            signatures,
-            attachments,
-            layers,
-            oc_config,
-        })
     }
 
-    pub fn close_document(&mut self, doc_id: DocumentId) {
-        self.documents.remove(&doc_id);
-        self.paths.remove(&doc_id);
-        self.oc_configs.remove(&doc_id);
-        if let Some(doc_keys) = self.cache_keys.remove(&doc_id) {
-            for key in doc_keys {
-                self.render_cache.remove(&key);
+    /// Shrinks the memory held for rendering toward `target_bytes`, giving
+    /// up the least useful state first: renders and decoded resources of
+    /// documents other than `keep`, then the compressed tier, then `keep`'s
+    /// own renders. The disk tier is left alone. Returns the bytes freed.
+    pub fn trim_memory(&self, keep: Option<DocumentId>, target_bytes: u64) -> u64 {
+        let cache = &self.render_cache;
+        let before = cache.resident_bytes();
+        let documents = self.registry.all();
+        for (doc_id, shared) in &documents {
+            if Some(*doc_id) != keep {
+                shared.resources.clear();
+                if cache.resident_bytes() > target_bytes {
+                    self.invalidate_renders(shared);
+                }
             }
         }
+        if cache.resident_bytes() > target_bytes {
+            cache.clear_compressed();
+        }
+        if cache.resident_bytes() > target_bytes
+            && let Some((_, shared)) = documents.iter().find(|(id, _)| Some(*id) == keep)
+        {
+            self.invalidate_renders(shared);
+        }
+        cache.publish_resident_bytes();
+        before.saturating_sub(cache.resident_bytes())
     }
 
+    /// Shows or hides a layer for every worker. Nothing is invalidated:
+    /// render keys carry each page's `oc_state`, so only pages that reference
+    /// the group miss the cache, and flipping it back finds the old renders.
     pub fn toggle_layer(&mut self, doc_id: DocumentId, object_id: (u32, u16), visible: bool) {
-        if let Some(oc) = self.oc_configs.get_mut(&doc_id) {
-            unsafe {
-                struct OcConfigMirror {
-                    off: std::collections::HashSet<zpdf::ObjectId>,
-                    on: std::collections::HashSet<zpdf::ObjectId>,
-                    #[allow(dead_code)]
-                    base_state_off: bool,
-                }
-                #[allow(clippy::transmute_ptr_to_ptr, clippy::transmute_undefined_repr)]
-                let mirror: &mut OcConfigMirror =
-                    &mut *(oc as *mut zpdf::OcConfig as *mut OcConfigMirror);
-                let id = zpdf::ObjectId(object_id.0, object_id.1);
-                if visible {
-                    mirror.off.remove(&id);
-                    mirror.on.insert(id);
-                } else {
-                    mirror.on.remove(&id);
-                    mirror.off.insert(id);
-                }
+        let Some(shared) = self.registry.get(doc_id) else {
+            return;
+        };
+        let mut layers = shared
+            .layers
+            .write()
+            .unwrap_or_else(PoisonError::into_inner);
+        let LayerState {
+            config: Some(oc),
+            defaults,
+            changed,
+        } = &mut *layers
+        else {
+            return;
+        };
+        let id = zpdf::ObjectId(object_id.0, object_id.1);
+        let default = *defaults
+            .entry(object_id)
+            .or_insert_with(|| oc.group_visible(id));
+        unsafe {
+            struct OcConfigMirror {
+                off: std::collections::HashSet<zpdf::ObjectId>,
+                on: std::collections::HashSet<zpdf::ObjectId>,
+                #[allow(dead_code)]
+                base_state_off: bool,
             }
-            if let Some(keys) = self.cache_keys.get(&doc_id) {
-                for key in keys {
-                    self.render_cache.remove(key);
-                }
+            #[allow(clippy::transmute_ptr_to_ptr, clippy::transmute_undefined_repr)]
+            let mirror: &mut OcConfigMirror =
+                &mut *(oc as *mut zpdf::OcConfig as *mut OcConfigMirror);
+            if visible {
+                mirror.off.remove(&id);
+                mirror.on.insert(id);
+            } else {
+                mirror.on.remove(&id);
+                mirror.off.insert(id);
             }
         }
+        if visible == default {
+            changed.remove(&object_id);
+        } else {
+            changed.insert(object_id);
+        }
     }
 
     pub fn get_attachment_bytes(
@@ -511,10 +1421,8 @@ impl DocumentStore {
         doc_id: DocumentId,
         object_id: (u32, u16),
     ) -> PdfResult<Vec<u8>> {
-        let doc = self
-            .documents
-            .get(&doc_id)
-            .ok_or(PdfError::EngineError(EngineErrorKind::DocumentNotFound))?;
+        let shared = self.document(doc_id)?;
+        let doc = &shared.doc;
 
         let efs = doc.embedded_files();
         let target_ef = efs
@@ -754,10 +1662,26 @@ impl DocumentStore {
         options: RenderOptions,
         is_thumbnail: bool,
     ) -> PdfResult<crate::models::RenderResult> {
+        let started = std::time::Instant::now();
+        let result = self.render_page_cached(doc_id, page_num, options, is_thumbnail);
+        crate::metrics::metrics().record_render(started.elapsed());
+        result
+    }
+
+    fn render_page_cached(
+        &self,
+        doc_id: DocumentId,
+        page_num: usize,
+        options: RenderOptions,
+        is_thumbnail: bool,
+    ) -> PdfResult<crate::models::RenderResult> {
+        let metrics = crate::metrics::metrics();
+        let shared = self.document(doc_id)?;
         let rounded_scale = (options.scale * 100.0).round() as u32;
         let cache_key = RenderKey {
             doc_id,
             page_num,
+            rotation: options.rotation,
             scale: rounded_scale,
             auto_crop: if is_thumbnail {
                 false
@@ -769,57 +1693,49 @@ impl DocumentStore {
             } else {
                 options.quality
             },
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: shared.oc_state(page_num),
+            generation: shared.generation,
+        };
+        let filtered_key = RenderKey {
+            filter: options.filter,
+            ..cache_key.clone()
         };
 
+        if let Some(hit) = self.render_cache.get(&filtered_key) {
+            metrics.cache_hit();
+            return Ok(hit);
+        }
         if let Some(base) = self.render_cache.get(&cache_key) {
-            if options.filter == RenderFilter::None {
-                return Ok(base);
-            }
-            let mut filtered = base.data.to_vec();
-            Self::apply_filter(&mut filtered, options.filter);
-            return Ok(crate::models::RenderResult {
-                width: base.width,
-                height: base.height,
-                data: filtered.into(),
-            });
+            metrics.cache_hit();
+            return Ok(self.cache_filtered(&shared, filtered_key, base));
         }
-
-        let doc = self
-            .documents
-            .get(&doc_id)
-            .ok_or(PdfError::EngineError(EngineErrorKind::DocumentNotFound))?;
-        let page = doc
-            .page(page_num)
-            .map_err(|_| PdfError::PageNotFound(page_num))?;
-
-        let mut fonts = doc.load_page_fonts(&page);
-        let mut images = ImageCache::new();
-        let content = doc
-            .page_content_bytes(&page)
-            .map_err(|e| PdfError::RenderFailed(e.to_string()))?;
-
-        // Incorporate custom option rotation into the display list rotation
-        let mut interp = ContentInterpreter::new(page.effective_box())
-            .with_page_rotation(page.rotate + options.rotation)
-            .with_fonts(&mut fonts)
-            .with_document(doc.file(), &page.resources)
-            .with_images(&mut images);
-
-        if let Some(oc) = self.oc_configs.get(&doc_id) {
-            interp = interp.with_optional_content(oc);
+        if let Some(fingerprint) = shared.disk_fingerprint(&cache_key)
+            && let Some(base) = self.render_cache.get_persisted(fingerprint, &cache_key)
+        {
+            metrics.cache_hit();
+            self.render_cache.put(cache_key.clone(), base.clone());
+            shared.track_cache_key(&self.render_cache, cache_key);
+            return Ok(self.cache_filtered(&shared, filtered_key, base));
         }
 
-        let display_list = interp.interpret(&content);
-
-        let mut renderer = CpuRenderer::new().with_fonts(&fonts).with_images(&images);
-        let page_img = renderer
-            .render_display_list(&display_list, options.scale)
-            .map_err(|e| PdfError::RenderFailed(e.to_string()))?;
-        let w = page_img.width;
-        let h = page_img.height;
+        metrics.cache_miss();
+        let entry = self.page_display_list(&shared, doc_id, page_num, options.rotation)?;
+        // A layer toggled since the lookup is already in the list.
+        let cache_key = RenderKey {
+            oc_state: entry.oc_state,
+            ..cache_key
+        };
+        let filtered_key = RenderKey {
+            oc_state: entry.oc_state,
+            ..filtered_key
+        };
+        let fingerprint = shared.disk_fingerprint(&cache_key);
+        let (w, h, page_data) = self.rasterize_page(&shared, page_num, &entry, options.scale)?;
 
         let (final_w, final_h, final_data) = if !is_thumbnail && options.auto_crop {
-            let result_data = page_img.data;
+            let result_data = page_data;
 
             if let Some((x1, y1, x2, y2)) = Self::detect_content_bbox_parallel(&result_data, w, h) {
                 let crop_w = (x2 - x1) + 1;
@@ -835,7 +1751,7 @@ impl DocumentStore {
                 (w, h, result_data)
             }
         } else {
-            (w, h, page_img.data)
+            (w, h, page_data)
         };
 
         let base = crate::models::RenderResult {
@@ -844,67 +1760,513 @@ impl DocumentStore {
             data: final_data.into(),
         };
 
-        self.cache_keys
-            .entry(doc_id)
-            .or_default()
-            .push(cache_key.clone());
-        self.render_cache.put(cache_key, base.clone());
+        if let Some(fingerprint) = fingerprint
+            && u64::from(base.width) * u64::from(base.height) <= DISK_CACHE_MAX_PIXELS
+        {
+            self.render_cache
+                .persist(fingerprint, cache_key.clone(), base.clone());
+        }
+        self.render_cache.put(cache_key.clone(), base.clone());
+        shared.track_cache_key(&self.render_cache, cache_key);
+
+        Ok(self.cache_filtered(&shared, filtered_key, base))
+    }
+
+    /// Rasterizes the whole page at `scale`, returning `(width, height, rgba)`.
+    fn rasterize_page(
+        &self,
+        shared: &SharedDocument,
+        page_num: usize,
+        entry: &DisplayListEntry,
+        scale: f32,
+    ) -> PdfResult<(u32, u32, Vec<u8>)> {
+        let resources = entry
+            .resources
+            .read()
+            .unwrap_or_else(PoisonError::into_inner);
+        let started = std::time::Instant::now();
+        let image = match self.rasterize_on_gpu(shared, page_num, &entry.list, &resources, scale) {
+            Some(image) => image,
+            None => {
+                let mut renderer = CpuRenderer::new()
+                    .with_fonts(&resources.fonts)
+                    .with_images(&resources.images);
+                let page_img = renderer
+                    .render_display_list(&entry.list, scale)
+                    .map_err(|e| PdfError::RenderFailed(e.to_string()))?;
+                (page_img.width, page_img.height, page_img.data)
+            }
+        };
+        crate::metrics::metrics().record_rasterize(started.elapsed());
+        Ok(image)
+    }
+
+    /// GPU render of a display list, or `None` when the CPU should draw it:
+    /// the backend is not selected, or this page already failed on the GPU.
+    /// Renders from every worker take turns on the registry's GPU lane.
+    #[cfg(feature = "gpu-render")]
+    fn rasterize_on_gpu(
+        &self,
+        shared: &SharedDocument,
+        page_num: usize,
+        list: &PageDisplayList,
+        resources: &PageResources,
+        scale: f32,
+    ) -> Option<(u32, u32, Vec<u8>)> {
+        if !self.gpu {
+            return None;
+        }
+        let mut failed = shared
+            .gpu_failed_pages
+            .lock()
+            .unwrap_or_else(PoisonError::into_inner);
+        if failed.contains(&page_num) {
+            return None;
+        }
+        drop(failed);
+        let result = {
+            let _lane = self
+                .registry
+                .gpu_lane
+                .lock()
+                .unwrap_or_else(PoisonError::into_inner);
+            let mut renderer = zpdf::gpu::WgpuRenderer::new()
+                .with_fonts(&resources.fonts)
+                .with_images(&resources.images);
+            renderer.render_display_list(list, scale)
+        };
+        match result {
+            Ok(page_img) => Some((page_img.width, page_img.height, page_img.data)),
+            Err(e) => {
+                tracing::warn!("GPU render of page {page_num} failed, using the CPU: {e}");
+                failed = shared
+                    .gpu_failed_pages
+                    .lock()
+                    .unwrap_or_else(PoisonError::into_inner);
+                failed.insert(page_num);
+                None
+            }
+        }
+    }
 
-        if options.filter == RenderFilter::None {
-            Ok(base)
+    #[cfg(not(feature = "gpu-render"))]
+    #[allow(clippy::unused_self)]
+    const fn rasterize_on_gpu(
+        &self,
+        _shared: &SharedDocument,
+        _page_num: usize,
+        _list: &PageDisplayList,
+        _resources: &PageResources,
+        _scale: f32,
+    ) -> Option<(u32, u32, Vec<u8>)> {
+        None
+    }
+
+    /// Applies `key.filter` to the unfiltered `base` and caches the result
+    /// under `key`, so repainting a page in a filtered mode is a plain cache
+    /// hit. Returns `base` itself when no filter is active.
+    fn cache_filtered(
+        &self,
+        shared: &SharedDocument,
+        key: RenderKey,
+        base: crate::models::RenderResult,
+    ) -> crate::models::RenderResult {
+        if key.filter == RenderFilter::None {
+            return base;
+        }
+        let mut filtered = base.data.to_vec();
+        Self::apply_filter(&mut filtered, key.filter);
+        let result = crate::models::RenderResult {
+            width: base.width,
+            height: base.height,
+            data: filtered.into(),
+        };
+        self.render_cache.put(key.clone(), result.clone());
+        shared.track_cache_key(&self.render_cache, key);
+        result
+    }
+
+    /// Renders the requested `(column, row)` tiles of a page at `options.scale`.
+    ///
+    /// Tiles are cached individually, never the whole page, so deep zoom keeps
+    /// only what the viewport needs resident. zpdf rasterizes a display list
+    /// as a whole, so a miss draws the full page once and slices every
+    /// missing tile out of that one bitmap; tiles past the page edge are
+    /// cached empty without drawing anything. Auto-crop does not apply.
+    pub fn render_tiles(
+        &mut self,
+        doc_id: DocumentId,
+        page_num: usize,
+        options: RenderOptions,
+        tiles: &[(u32, u32)],
+    ) -> PdfResult<Vec<crate::models::RenderTile>> {
+        let shared = self.document(doc_id)?;
+        let oc_state = shared.oc_state(page_num);
+        let tile_key = |col: u32, row: u32, filter: RenderFilter| RenderKey {
+            doc_id,
+            page_num,
+            rotation: options.rotation,
+            scale: (options.scale * 100.0).round() as u32,
+            auto_crop: false,
+            quality: options.quality,
+            tile: Some((col, row)),
+            filter,
+            oc_state,
+            generation: shared.generation,
+        };
+
+        let mut rendered = Vec::with_capacity(tiles.len());
+        let mut missing = Vec::new();
+        for &(col, row) in tiles {
+            let filtered_key = tile_key(col, row, options.filter);
+            let result = match self.render_cache.get(&filtered_key) {
+                Some(hit) => hit,
+                None => match self
+                    .render_cache
+                    .get(&tile_key(col, row, RenderFilter::None))
+                {
+                    Some(base) => self.cache_filtered(&shared, filtered_key, base),
+                    None => {
+                        missing.push((col, row));
+                        continue;
+                    }
+                },
+            };
+            rendered.push(crate::models::RenderTile { col, row, result });
+        }
+        if missing.is_empty() {
+            return Ok(rendered);
+        }
+
+        let page = shared
+            .doc
+            .page(page_num)
+            .map_err(|_| PdfError::PageNotFound(page_num))?;
+        let page_size = page_pixel_size(&page, options.rotation, options.scale);
+        let entry = self.page_display_list(&shared, doc_id, page_num, options.rotation)?;
+        let on_page = |&(col, row): &(u32, u32)| {
+            col * TILE_SIZE < page_size.0 && row * TILE_SIZE < page_size.1
+        };
+        // Tiles past the page edge are cached empty so they are not
+        // requested again; the page is drawn only if some tile is on it.
+        let page_bitmap = if missing.iter().any(on_page) {
+            Some(self.rasterize_page(&shared, page_num, &entry, options.scale)?)
         } else {
-            let mut filtered = base.data.to_vec();
-            Self::apply_filter(&mut filtered, options.filter);
-            Ok(crate::models::RenderResult {
-                width: base.width,
-                height: base.height,
-                data: filtered.into(),
+            None
+        };
+
+        for (col, row) in missing {
+            let (width, height, data) = match &page_bitmap {
+                Some((w, h, page_data)) => {
+                    slice_tile(page_data, (*w, *h), (col * TILE_SIZE, row * TILE_SIZE))
+                }
+                None => (0, 0, Vec::new()),
+            };
+            let base = crate::models::RenderResult {
+                width,
+                height,
+                data: data.into(),
+            };
+            // Keyed by the layer state the list was built under, which a
+            // toggle since the lookup may have changed.
+            let key = RenderKey {
+                oc_state: entry.oc_state,
+                ..tile_key(col, row, RenderFilter::None)
+            };
+            let filtered_key = RenderKey {
+                filter: options.filter,
+                ..key.clone()
+            };
+            self.render_cache.put(key.clone(), base.clone());
+            shared.track_cache_key(&self.render_cache, key);
+            rendered.push(crate::models::RenderTile {
+                col,
+                row,
+                result: self.cache_filtered(&shared, filtered_key, base),
+            });
+        }
+
+        Ok(rendered)
+    }
+
+    pub fn render_page(
+        &mut self,
+        doc_id: DocumentId,
+        page_num: usize,
+        options: RenderOptions,
+    ) -> PdfResult<crate::models::RenderResult> {
+        self.render_page_internal(doc_id, page_num, options, false)
+    }
+
+    /// A quick stand-in for a page while its full render runs. Reuses the
+    /// largest cached render of the page below the requested scale, such as
+    /// its sidebar thumbnail, or else renders at `RenderQuality::Low` and a
+    /// quarter of the scale. `None` when the full render is already cached,
+    /// or when auto-crop would make the preview's geometry differ.
+    pub fn render_preview(
+        &mut self,
+        doc_id: DocumentId,
+        page_num: usize,
+        options: &RenderOptions,
+    ) -> PdfResult<Option<crate::models::RenderResult>> {
+        if options.auto_crop {
+            return Ok(None);
+        }
+        let shared = self.document(doc_id)?;
+        let scale = (options.scale * 100.0).round() as u32;
+        let full_key = RenderKey {
+            doc_id,
+            page_num,
+            rotation: options.rotation,
+            scale,
+            auto_crop: false,
+            quality: options.quality,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: shared.oc_state(page_num),
+            generation: shared.generation,
+        };
+        if self.render_cache.get(&full_key).is_some() {
+            return Ok(None);
+        }
+
+        let mut smaller: Vec<RenderKey> = shared
+            .page_cache_keys(page_num)
+            .into_iter()
+            .filter(|key| {
+                key.rotation == options.rotation
+                    && !key.auto_crop
+                    && key.scale < scale
+                    && key.filter == RenderFilter::None
+                    && key.oc_state == full_key.oc_state
             })
+            .collect();
+        smaller.sort_by_key(|key| std::cmp::Reverse(key.scale));
+        for key in smaller {
+            let filtered_key = RenderKey {
+                filter: options.filter,
+                ..key.clone()
+            };
+            if let Some(hit) = self.render_cache.get(&filtered_key) {
+                return Ok(Some(hit));
+            }
+            if let Some(base) = self.render_cache.get(&key) {
+                return Ok(Some(self.cache_filtered(&shared, filtered_key, base)));
+            }
         }
+
+        let preview = RenderOptions {
+            scale: options.scale / PREVIEW_SCALE_DIVISOR,
+            rotation: options.rotation,
+            filter: options.filter,
+            auto_crop: false,
+            quality: RenderQuality::Low,
+        };
+        self.render_page_internal(doc_id, page_num, preview, false)
+            .map(Some)
     }
 
-    pub fn render_page(
+    /// A sidebar thumbnail. A page already cached at a larger scale, e.g. by
+    /// the main view, is box-filtered down from that render rather than
+    /// interpreted again.
+    pub fn render_thumbnail(
         &mut self,
         doc_id: DocumentId,
         page_num: usize,
         options: RenderOptions,
     ) -> PdfResult<crate::models::RenderResult> {
-        self.render_page_internal(doc_id, page_num, options, false)
+        if let Some(thumbnail) = self.thumbnail_from_cached_render(doc_id, page_num, &options)? {
+            return Ok(thumbnail);
+        }
+        self.render_page_internal(doc_id, page_num, options, true)
     }
 
-    pub fn render_thumbnail(
-        &mut self,
+    /// Downsamples the smallest cached render of the page larger than the
+    /// thumbnail, caching the result under the thumbnail's own key. `None`
+    /// if the thumbnail is cached already or there is nothing to derive it
+    /// from.
+    fn thumbnail_from_cached_render(
+        &self,
         doc_id: DocumentId,
         page_num: usize,
-        options: RenderOptions,
-    ) -> PdfResult<crate::models::RenderResult> {
-        self.render_page_internal(doc_id, page_num, options, true)
+        options: &RenderOptions,
+    ) -> PdfResult<Option<crate::models::RenderResult>> {
+        let shared = self.document(doc_id)?;
+        let scale = (options.scale * 100.0).round() as u32;
+        let thumbnail_key = RenderKey {
+            doc_id,
+            page_num,
+            rotation: options.rotation,
+            scale,
+            auto_crop: false,
+            quality: RenderQuality::Low,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: shared.oc_state(page_num),
+            generation: shared.generation,
+        };
+        if self.render_cache.contains(&thumbnail_key) {
+            return Ok(None);
+        }
+
+        let mut larger: Vec<RenderKey> = shared
+            .page_cache_keys(page_num)
+            .into_iter()
+            .filter(|key| {
+                key.rotation == options.rotation
+                    && !key.auto_crop
+                    && key.scale > scale
+                    && key.filter == RenderFilter::None
+                    && key.oc_state == thumbnail_key.oc_state
+            })
+            .collect();
+        larger.sort_by_key(|key| key.scale);
+        for key in larger {
+            let Some(source) = self.render_cache.get(&key) else {
+                continue;
+            };
+            let ratio = scale as f32 / key.scale as f32;
+            let width = ((source.width as f32 * ratio).round() as u32).max(1);
+            let height = ((source.height as f32 * ratio).round() as u32).max(1);
+            let thumbnail = crate::models::RenderResult {
+                width,
+                height,
+                data: Self::downsample_box(
+                    &source.data,
+                    source.width,
+                    source.height,
+                    width,
+                    height,
+                )
+                .into(),
+            };
+            crate::metrics::metrics().cache_hit();
+            self.render_cache
+                .put(thumbnail_key.clone(), thumbnail.clone());
+            shared.track_cache_key(&self.render_cache, thumbnail_key);
+            return Ok(Some(thumbnail));
+        }
+        Ok(None)
     }
 
     pub fn extract_text(&self, doc_id: DocumentId, page_num: usize) -> PdfResult<String> {
-        let doc = self
-            .documents
-            .get(&doc_id)
-            .ok_or(PdfError::EngineError(EngineErrorKind::DocumentNotFound))?;
+        let shared = self.document(doc_id)?;
+        Ok(Self::page_text(&shared, page_num, true)?.plain.clone())
+    }
+
+    pub fn extract_text_items(
+        &self,
+        doc_id: DocumentId,
+        page_num: usize,
+    ) -> PdfResult<Vec<crate::models::TextItem>> {
+        let shared = self.document(doc_id)?;
+        Ok(Self::page_text(&shared, page_num, true)?.text_items())
+    }
+
+    /// Indexed text for a page, interpreting its content stream on first use.
+    /// `cache_resources` is false for whole-document passes so they don't
+    /// evict the decoded resources of the pages on screen.
+    fn page_text(
+        shared: &SharedDocument,
+        page_num: usize,
+        cache_resources: bool,
+    ) -> PdfResult<Arc<PageText>> {
+        if let Some(text) = shared.text_index.page(page_num) {
+            return Ok(text);
+        }
+        let captured = Self::page_spans(shared, page_num, cache_resources)?;
+        if cache_resources && shared.tables.peek(&page_num).is_none() {
+            let tables = page_tables(&captured.spans, captured.page_height);
+            shared.tables.insert(page_num, Arc::new(tables));
+        }
+        shared.captured_spans.remove(&page_num);
+        let CapturedSpans { spans, page_height } = Arc::unwrap_or_clone(captured);
+        Ok(Self::index_spans(shared, page_num, page_height, spans))
+    }
+
+    /// Spans a render captured for the page, or else those of a text-only
+    /// pass.
+    fn page_spans(
+        shared: &SharedDocument,
+        page_num: usize,
+        cache_resources: bool,
+    ) -> PdfResult<Arc<CapturedSpans>> {
+        if let Some(captured) = shared.captured_spans.get(&page_num) {
+            return Ok(captured);
+        }
+        let (spans, page_height) = Self::interpret_spans(shared, page_num, cache_resources)?;
+        Ok(Arc::new(CapturedSpans { spans, page_height }))
+    }
+
+    /// Text spans of a page from a text-only interpretation pass, with the
+    /// page's height for converting them to layout space.
+    fn interpret_spans(
+        shared: &SharedDocument,
+        page_num: usize,
+        cache_resources: bool,
+    ) -> PdfResult<(Vec<zpdf::TextSpan>, f32)> {
+        let doc = &shared.doc;
         let page = doc
             .page(page_num)
             .map_err(|_| PdfError::PageNotFound(page_num))?;
-        let mut fonts = doc.load_page_fonts(&page);
-        let mut images = ImageCache::new();
         let content = doc
             .page_content_bytes(&page)
             .map_err(|e| PdfError::SearchError(e.to_string()))?;
 
-        let mut spans = Vec::new();
-        {
-            let interp = ContentInterpreter::new(page.effective_box())
-                .with_fonts(&mut fonts)
-                .with_document(doc.file(), &page.resources)
-                .with_images(&mut images)
-                .with_text_sink(&mut spans);
-            let _ = interp.interpret(&content);
+        let mut spans: Vec<zpdf::TextSpan> = Vec::new();
+        let collect =
+            |fonts: &mut PageFonts, images: &mut ImageCache, spans: &mut Vec<zpdf::TextSpan>| {
+                let interp = ContentInterpreter::new(page.effective_box())
+                    .with_fonts(fonts)
+                    .with_document(doc.file(), &page.resources)
+                    .with_images(images)
+                    .with_text_sink(spans);
+                let _ = interp.interpret(&content);
+            };
+        // Whole-document passes reuse what rendering already decoded, but
+        // don't let a full scan evict the pages the user is looking at.
+        let resources = if cache_resources {
+            Some(shared.page_resources(page_num, || doc.load_page_fonts(&page)))
+        } else {
+            shared.cached_page_resources(page_num)
+        };
+        if let Some(resources) = resources {
+            let mut resources = resources.write().unwrap_or_else(PoisonError::into_inner);
+            let PageResources { fonts, images } = &mut *resources;
+            collect(fonts, images, &mut spans);
+        } else {
+            collect(
+                &mut doc.load_page_fonts(&page),
+                &mut ImageCache::new(),
+                &mut spans,
+            );
         }
-        let text = if doc.is_tagged() {
+        Ok((spans, page.effective_box().height() as f32))
+    }
+
+    /// Keeps the spans a render captured on a page, so its text layer and
+    /// tables are built from them when asked for instead of on the render
+    /// path.
+    fn record_page_spans(
+        shared: &SharedDocument,
+        page_num: usize,
+        page_height: f32,
+        spans: Vec<zpdf::TextSpan>,
+    ) {
+        shared
+            .captured_spans
+            .insert(page_num, Arc::new(CapturedSpans { spans, page_height }));
+    }
+
+    fn index_spans(
+        shared: &SharedDocument,
+        page_num: usize,
+        page_height: f32,
+        spans: Vec<zpdf::TextSpan>,
+    ) -> Arc<PageText> {
+        let doc = &shared.doc;
+        let indexed: Vec<IndexedSpan> = spans.iter().map(IndexedSpan::from).collect();
+        let plain = if doc.is_tagged() {
             if let Some(tree) = doc.struct_tree() {
                 struct_ordered_text(&spans, page_num, &tree)
             } else {
@@ -913,107 +2275,85 @@ impl DocumentStore {
         } else {
             spans_to_text(spans, 2.0)
         };
-        Ok(text)
-    }
 
-    pub fn extract_text_items(
-        &self,
-        doc_id: DocumentId,
-        page_num: usize,
-    ) -> PdfResult<Vec<crate::models::TextItem>> {
-        let doc = self
-            .documents
-            .get(&doc_id)
-            .ok_or(PdfError::EngineError(EngineErrorKind::DocumentNotFound))?;
-        let page = doc
-            .page(page_num)
-            .map_err(|_| PdfError::PageNotFound(page_num))?;
-        let mut fonts = doc.load_page_fonts(&page);
-        let mut images = ImageCache::new();
-        let content = doc
-            .page_content_bytes(&page)
-            .map_err(|e| PdfError::SearchError(e.to_string()))?;
+        shared
+            .text_index
+            .insert(page_num, PageText::new(page_height, indexed, plain))
+    }
 
-        let mut spans = Vec::new();
+    /// Fills the text index for every page, reusing a saved copy when the file
+    /// is unchanged. Stops early if the document is closed meanwhile.
+    pub fn build_text_index(&self, doc_id: DocumentId, persist: bool) -> PdfResult<()> {
+        let shared = self.document(doc_id)?;
+        // No fingerprint for encrypted documents: their text stays in memory.
+        let saved = shared
+            .fingerprint
+            .filter(|_| persist)
+            .map(|fingerprint| crate::text_index::index_path(&shared.path, fingerprint));
+        if let Some(path) = &saved
+            && shared.text_index.load(path)
         {
-            let interp = ContentInterpreter::new(page.effective_box())
-                .with_fonts(&mut fonts)
-                .with_document(doc.file(), &page.resources)
-                .with_images(&mut images)
-                .with_text_sink(&mut spans);
-            let _ = interp.interpret(&content);
+            tracing::debug!("Loaded text index for {:?} from {:?}", doc_id, path);
+            return Ok(());
         }
 
-        let page_height = page.effective_box().height() as f32;
-        let mut text_items = Vec::new();
-        for span in spans {
-            if span.text.trim().is_empty() {
-                continue;
+        for page_num in 0..shared.doc.page_count() {
+            if !self.registry.contains(doc_id) {
+                return Err(PdfError::Cancelled);
             }
-            text_items.push(crate::models::TextItem {
-                text: span.text,
-                x: span.x as f32,
-                y: page_height - span.y as f32,
-                width: span.advance.abs() as f32,
-                height: span.size,
-            });
+            if let Err(e) = Self::page_text(&shared, page_num, false) {
+                tracing::debug!("Text index skipped page {}: {}", page_num, e);
+            }
+        }
+
+        if let Some(path) = &saved
+            && let Err(e) = shared.text_index.save(path)
+        {
+            tracing::warn!("Failed to save text index to {:?}: {}", path, e);
         }
-        Ok(text_items)
+        Ok(())
     }
 
+    /// Table candidates of a page, usually found in the spans left behind
+    /// by the render that put it on screen.
     pub fn detect_tables_on_page(
         &self,
         doc_id: DocumentId,
         page_num: usize,
     ) -> PdfResult<Vec<crate::models::DetectedTable>> {
-        let doc = self
-            .documents
-            .get(&doc_id)
-            .ok_or(PdfError::EngineError(EngineErrorKind::DocumentNotFound))?;
-        let page = doc
-            .page(page_num)
-            .map_err(|_| PdfError::PageNotFound(page_num))?;
-        let mut fonts = doc.load_page_fonts(&page);
-        let mut images = ImageCache::new();
-        let content = doc
-            .page_content_bytes(&page)
-            .map_err(|e| PdfError::SearchError(e.to_string()))?;
-
-        let mut spans = Vec::new();
-        {
-            let interp = ContentInterpreter::new(page.effective_box())
-                .with_fonts(&mut fonts)
-                .with_document(doc.file(), &page.resources)
-                .with_images(&mut images)
-                .with_text_sink(&mut spans);
-            let _ = interp.interpret(&content);
+        let shared = self.document(doc_id)?;
+        if let Some(tables) = shared.tables.get(&page_num) {
+            return Ok(tables.as_ref().clone());
         }
+        let captured = Self::page_spans(&shared, page_num, true)?;
+        let tables = page_tables(&captured.spans, captured.page_height);
+        shared.tables.insert(page_num, Arc::new(tables.clone()));
+        // The spans stay for the text layer if it has not been built yet.
+        if shared.text_index.page(page_num).is_none() {
+            shared.captured_spans.insert(page_num, captured);
+        } else {
+            shared.captured_spans.remove(&page_num);
+        }
+        Ok(tables)
+    }
 
-        let tables = detect_tables(&spans);
-        let page_height = page.effective_box().height() as f32;
-
-        let detected = tables
+    /// Text layer and tables of each of `pages`, as the UI asks for them
+    /// once the pages' pixels arrive.
+    pub fn page_overlays(
+        &self,
+        doc_id: DocumentId,
+        pages: Vec<usize>,
+        text: bool,
+        tables: bool,
+    ) -> Vec<crate::models::PageOverlay> {
+        pages
             .into_iter()
-            .map(|t| {
-                let (x0, y0, x1, y1) = t.bbox();
-                // Coordinate conversion to y-down layout space:
-                // x = x0, y = page_height - y1, w = x1 - x0, h = y1 - y0
-                let bbox = (
-                    x0 as f32,
-                    page_height - y1 as f32,
-                    (x1 - x0) as f32,
-                    (y1 - y0) as f32,
-                );
-                crate::models::DetectedTable {
-                    bbox,
-                    csv: t.to_csv(),
-                    tsv: t.to_tsv(),
-                    cells: t.cells,
-                }
+            .map(|page| crate::models::PageOverlay {
+                page,
+                text_items: text.then(|| self.extract_text_items(doc_id, page)),
+                tables: tables.then(|| self.detect_tables_on_page(doc_id, page)),
             })
-            .collect();
-
-        Ok(detected)
+            .collect()
     }
 
     #[allow(clippy::suboptimal_flops)]
@@ -1023,12 +2363,23 @@ impl DocumentStore {
         annotations: &[Annotation],
         output_path: Option<String>,
     ) -> PdfResult<String> {
-        let pdf_path = self
-            .paths
-            .get(&doc_id)
+        let shared = self
+            .registry
+            .get(doc_id)
             .ok_or(PdfError::EngineError(EngineErrorKind::DocumentPathNotFound))?;
-
-        let mut doc = Document::load(pdf_path).map_err(|e| PdfError::OpenFailed(e.to_string()))?;
+        let pdf_path = &shared.path;
+
+        // Only the object structure is needed to attach annotations; stream
+        // bodies stay on disk and the update is appended after them.
+        // Encrypted files are rewritten whole, as appended objects would
+        // have to be encrypted too.
+        let mut doc = crate::incremental_save::load_structure(pdf_path)
+            .map_err(|e| PdfError::OpenFailed(e.to_string()))?;
+        let incremental = doc.trailer.get(b"Encrypt").is_err();
+        if !incremental {
+            doc = Document::load(pdf_path).map_err(|e| PdfError::OpenFailed(e.to_string()))?;
+        }
+        let mut changed = Vec::new();
 
         // Group annotations by page
         let mut page_annots: std::collections::BTreeMap<usize, Vec<&Annotation>> =
@@ -1046,16 +2397,10 @@ impl DocumentStore {
                 continue;
             };
 
-            let page_height = {
-                if let Some(doc_ref) = self.documents.get(&doc_id) {
-                    if let Ok(p) = doc_ref.page(page_idx) {
-                        p.effective_box().height() as f32
-                    } else {
-                        792.0_f32
-                    }
-                } else {
-                    792.0_f32
-                }
+            let page_height = if let Ok(p) = shared.doc.page(page_idx) {
+                p.effective_box().height() as f32
+            } else {
+                792.0_f32
             };
 
             let mut annot_refs = Vec::new();
@@ -1364,6 +2709,8 @@ impl DocumentStore {
             }
 
             if let Some(Object::Dictionary(page_dict)) = doc.objects.get_mut(&page_id) {
+                changed.extend(annot_refs.iter().filter_map(|r| r.as_reference().ok()));
+                changed.push(page_id);
                 annots_resolved.extend(annot_refs);
                 page_dict.set("Annots", Object::Array(annots_resolved));
             }
@@ -1380,8 +2727,23 @@ impl DocumentStore {
             p.to_string_lossy().to_string()
         });
 
-        doc.save(&final_path)
+        if incremental {
+            let same_file =
+                std::fs::canonicalize(&final_path).ok() == std::fs::canonicalize(pdf_path_buf).ok();
+            if !same_file {
+                std::fs::copy(pdf_path_buf, &final_path)
+                    .map_err(|e| PdfError::IoError(e.to_string()))?;
+            }
+            crate::incremental_save::append_update(
+                std::path::Path::new(&final_path),
+                &doc,
+                &changed,
+            )
             .map_err(|e| PdfError::IoError(e.to_string()))?;
+        } else {
+            doc.save(&final_path)
+                .map_err(|e| PdfError::IoError(e.to_string()))?;
+        }
 
         Ok(final_path)
     }
@@ -1392,66 +2754,158 @@ impl DocumentStore {
         page_num: usize,
         scale: f32,
     ) -> PdfResult<Vec<u8>> {
+        let shared = self.document(doc_id)?;
+        self.encode_page_png(&shared, doc_id, page_num, scale)
+    }
+
+    /// PNG of a page at `scale`, reusing a cached render when there is one.
+    /// Export renders are not cached, so a long export does not evict the
+    /// pages being viewed.
+    fn encode_page_png(
+        &self,
+        shared: &SharedDocument,
+        doc_id: DocumentId,
+        page_num: usize,
+        scale: f32,
+    ) -> PdfResult<Vec<u8>> {
+        let options = RenderOptions {
+            scale,
+            rotation: 0,
+            filter: RenderFilter::None,
+            auto_crop: false,
+            quality: RenderQuality::Medium,
+        };
         let cache_key = RenderKey {
             doc_id,
             page_num,
+            rotation: 0,
             scale: (scale * 100.0).round() as u32,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: shared.oc_state(page_num),
+            generation: shared.generation,
         };
 
-        if let Some(cached_res) = self.render_cache.get(&cache_key) {
-            let image = Image::from_u8(
-                &cached_res.data,
-                cached_res.width as usize,
-                cached_res.height as usize,
-                zune_core::colorspace::ColorSpace::RGBA,
-            );
-            let out_buf = image
-                .write_to_vec(ImageFormat::PNG)
-                .map_err(|e| PdfError::RenderFailed(format!("{e:?}")))?;
-            return Ok(out_buf);
-        }
-
-        let doc = self
-            .documents
-            .get(&doc_id)
-            .ok_or(PdfError::EngineError(EngineErrorKind::DocumentNotFound))?;
-        let page = doc
-            .page(page_num)
-            .map_err(|_| PdfError::PageNotFound(page_num))?;
-
-        let mut fonts = doc.load_page_fonts(&page);
-        let mut images = ImageCache::new();
-        let content = doc
-            .page_content_bytes(&page)
-            .map_err(|e| PdfError::RenderFailed(e.to_string()))?;
+        let (width, height, data) = match self.render_cache.get(&cache_key) {
+            Some(cached) => (cached.width, cached.height, cached.data),
+            None => {
+                let entry = self.page_display_list(shared, doc_id, page_num, options.rotation)?;
+                let (w, h, data) = self.rasterize_page(shared, page_num, &entry, scale)?;
+                (w, h, data.into())
+            }
+        };
+        Image::from_u8(
+            &data,
+            width as usize,
+            height as usize,
+            zune_core::colorspace::ColorSpace::RGBA,
+        )
+        .write_to_vec(ImageFormat::PNG)
+        .map_err(|e| PdfError::RenderFailed(format!("{e:?}")))
+    }
 
-        let display_list = ContentInterpreter::new(page.effective_box())
-            .with_page_rotation(page.rotate)
-            .with_fonts(&mut fonts)
-            .with_document(doc.file(), &page.resources)
-            .with_images(&mut images)
-            .interpret(&content);
+    /// Writes `pages` into `out_dir` as `page_N.png`, reporting every page on
+    /// `progress`. The stream ends after the last page.
+    ///
+    /// Pages are rendered, encoded and optimized in parallel on the shared
+    /// export pool while a writer thread does the disk I/O, so each stage
+    /// overlaps the others across pages. The calling worker waits for the
+    /// pool; the interactive render workers are not used, so the viewer
+    /// stays responsive. `png_level` is the oxipng preset (0-6); 0 skips
+    /// optimization. Stops with `Cancelled` once `cancel` is set or the
+    /// document closes.
+    #[allow(clippy::too_many_arguments)]
+    pub fn export_images(
+        &self,
+        doc_id: DocumentId,
+        pages: &[usize],
+        scale: f32,
+        out_dir: &str,
+        png_level: u8,
+        cancel: &AtomicBool,
+        progress: &ExportProgressSender,
+    ) {
+        let out_path = std::path::Path::new(out_dir);
+        if !out_path.is_dir() {
+            let _ = progress.unbounded_send(Err(PdfError::IoError(
+                "Output directory does not exist".into(),
+            )));
+            return;
+        }
+        let shared = match self.document(doc_id) {
+            Ok(shared) => shared,
+            Err(e) => {
+                let _ = progress.unbounded_send(Err(e));
+                return;
+            }
+        };
+        let pool = match export_pool() {
+            Ok(pool) => pool,
+            Err(e) => {
+                let _ = progress.unbounded_send(Err(e));
+                return;
+            }
+        };
+        let stopped = || cancel.load(Ordering::Relaxed) || !self.registry.contains(doc_id);
+        let optimize = (png_level > 0).then(|| oxipng::Options::from_preset(png_level.min(6)));
+        let total = pages.len();
 
-        let mut renderer = CpuRenderer::new().with_fonts(&fonts).with_images(&images);
-        let page_img = renderer
-            .render_display_list(&display_list, scale)
-            .map_err(|e| PdfError::RenderFailed(e.to_string()))?;
-        let width = page_img.width as usize;
-        let height = page_img.height as usize;
+        // Bounded so finished pages cannot pile up in memory behind a slow disk.
+        let (write_tx, write_rx) =
+            std::sync::mpsc::sync_channel::<(usize, Option<Vec<u8>>)>(pool.current_num_threads());
+        std::thread::scope(|scope| {
+            scope.spawn(move || {
+                let mut failed = 0;
+                for (done, (page_num, png)) in write_rx.into_iter().enumerate() {
+                    let out_file = out_path.join(format!("page_{page_num}.png"));
+                    let written = png.and_then(|png| match std::fs::write(&out_file, png) {
+                        Ok(()) => out_file.to_str().map(str::to_string),
+                        Err(e) => {
+                            tracing::warn!("Failed to write {:?}: {}", out_file, e);
+                            None
+                        }
+                    });
+                    failed += usize::from(written.is_none());
+                    let _ = progress.unbounded_send(Ok(ExportProgress {
+                        done: done + 1,
+                        total,
+                        failed,
+                        written,
+                    }));
+                }
+            });
 
-        let image = Image::from_u8(
-            &page_img.data,
-            width,
-            height,
-            zune_core::colorspace::ColorSpace::RGBA,
-        );
-        let out_buf = image
-            .write_to_vec(ImageFormat::PNG)
-            .map_err(|e| PdfError::RenderFailed(format!("{e:?}")))?;
+            // oxipng parallelizes through rayon too; `install` keeps it on
+            // the export pool rather than the global one.
+            pool.install(|| {
+                pages
+                    .par_iter()
+                    .for_each_with(write_tx, |write_tx, &page_num| {
+                        if stopped() {
+                            return;
+                        }
+                        let png = match self.encode_page_png(&shared, doc_id, page_num, scale) {
+                            Ok(png) => Some(match &optimize {
+                                Some(options) => {
+                                    oxipng::optimize_from_memory(&png, options).unwrap_or(png)
+                                }
+                                None => png,
+                            }),
+                            Err(e) => {
+                                tracing::warn!("Export skipped page {}: {}", page_num, e);
+                                None
+                            }
+                        };
+                        let _ = write_tx.send((page_num, png));
+                    });
+            });
+        });
 
-        Ok(out_buf)
+        if stopped() {
+            let _ = progress.unbounded_send(Err(PdfError::Cancelled));
+        }
     }
 
     fn flatten_outline(items: &[zpdf::OutlineItem], out: &mut Vec<Bookmark>, depth: usize) {
@@ -1537,110 +2991,59 @@ impl DocumentStore {
     }
 
     pub fn search(&self, doc_id: DocumentId, query: &str) -> PdfResult<Vec<SearchResultItem>> {
-        let doc = self
-            .documents
-            .get(&doc_id)
-            .ok_or(PdfError::EngineError(EngineErrorKind::DocumentNotFound))?;
-        let total_pages = doc.page_count();
-        let query_lower = query.to_lowercase();
-
         let mut results = Vec::new();
+        self.search_streaming(doc_id, query, &AtomicBool::new(false), |batch| {
+            results.extend(batch);
+        })?;
+        Ok(results)
+    }
 
-        for page_idx in 0..total_pages {
-            let Ok(page) = doc.page(page_idx) else {
-                continue;
-            };
-            let mut fonts = doc.load_page_fonts(&page);
-            let mut images = ImageCache::new();
-            let Ok(content) = doc.page_content_bytes(&page) else {
-                continue;
-            };
-
-            let mut spans: Vec<zpdf::TextSpan> = Vec::new();
-            {
-                let interp = ContentInterpreter::new(page.effective_box())
-                    .with_fonts(&mut fonts)
-                    .with_document(doc.file(), &page.resources)
-                    .with_images(&mut images)
-                    .with_text_sink(&mut spans);
-                let _ = interp.interpret(&content);
-            }
+    /// Searches pages in parallel, handing each batch of `SEARCH_BATCH_PAGES`
+    /// pages to `on_batch` in page order. Stops early once `cancel` is set.
+    pub fn search_streaming(
+        &self,
+        doc_id: DocumentId,
+        query: &str,
+        cancel: &AtomicBool,
+        mut on_batch: impl FnMut(Vec<SearchResultItem>),
+    ) -> PdfResult<()> {
+        let shared = self.document(doc_id)?;
+        let total_pages = shared.doc.page_count();
+        let query_lower = query.to_lowercase();
 
-            let page_height = page.effective_box().height() as f32;
-            let mut full_text = String::new();
-            let mut span_offsets = Vec::new();
-
-            for (idx, span) in spans.iter().enumerate() {
-                let start = full_text.len();
-                full_text.push_str(&span.text);
-                let end = full_text.len();
-                span_offsets.push((start, end, idx));
+        for first in (0..total_pages).step_by(SEARCH_BATCH_PAGES) {
+            if cancel.load(Ordering::Relaxed) {
+                return Err(PdfError::Cancelled);
             }
-
-            let full_text_lower = full_text.to_lowercase();
-            let char_boundaries: Vec<usize> = full_text
-                .char_indices()
-                .map(|(idx, _)| idx)
-                .chain(std::iter::once(full_text.len()))
-                .collect();
-            let char_boundaries_lower: Vec<usize> = full_text_lower
-                .char_indices()
-                .map(|(idx, _)| idx)
-                .chain(std::iter::once(full_text_lower.len()))
+            let last = (first + SEARCH_BATCH_PAGES).min(total_pages);
+            let batch: Vec<SearchResultItem> = (first..last)
+                .into_par_iter()
+                .flat_map_iter(|page_idx| {
+                    if cancel.load(Ordering::Relaxed) {
+                        Vec::new()
+                    } else {
+                        Self::search_page(&shared, page_idx, &query_lower)
+                    }
+                })
                 .collect();
-
-            let mut search_idx = 0;
-            while let Some(pos) = full_text_lower[search_idx..].find(&query_lower) {
-                let match_start = search_idx + pos;
-                let match_end = match_start + query_lower.len();
-
-                // Get char index in full_text_lower:
-                let char_start = char_boundaries_lower
-                    .binary_search(&match_start)
-                    .unwrap_or_else(|x| x);
-                let char_end = char_boundaries_lower
-                    .binary_search(&match_end)
-                    .unwrap_or_else(|x| x);
-
-                // Map to byte index in original full_text:
-                let orig_start = char_boundaries
-                    .get(char_start)
-                    .copied()
-                    .unwrap_or(full_text.len());
-                let orig_end = char_boundaries
-                    .get(char_end)
-                    .copied()
-                    .unwrap_or(full_text.len());
-                let matched_text = full_text[orig_start..orig_end].to_string();
-
-                if let Some(&(_, _, span_idx)) = span_offsets
-                    .iter()
-                    .find(|(s, e, _)| orig_start >= *s && orig_start < *e)
-                {
-                    let first_span = &spans[span_idx];
-                    let y_top_down = page_height - first_span.y as f32 - first_span.size;
-                    results.push(SearchResultItem {
-                        page_index: page_idx,
-                        text: matched_text,
-                        y: y_top_down,
-                        x: first_span.x as f32,
-                        width: first_span.advance.abs() as f32,
-                        height: first_span.size,
-                    });
-                }
-
-                // Advance search_idx safely to the next character boundary in full_text_lower
-                search_idx = char_boundaries_lower
-                    .get(char_start + 1)
-                    .copied()
-                    .unwrap_or(full_text_lower.len());
+            if !batch.is_empty() {
+                on_batch(batch);
             }
         }
+        Ok(())
+    }
 
-        Ok(results)
+    fn search_page(
+        shared: &SharedDocument,
+        page_idx: usize,
+        query_lower: &str,
+    ) -> Vec<SearchResultItem> {
+        Self::page_text(shared, page_idx, false)
+            .map(|text| text.find(page_idx, query_lower))
+            .unwrap_or_default()
     }
 
-    fn detect_content_bbox_parallel(
+    pub fn detect_content_bbox_parallel(
         data: &[u8],
         width: u32,
         height: u32,
@@ -1707,169 +3110,123 @@ impl DocumentStore {
         })
     }
 
-    #[allow(clippy::suboptimal_flops)]
-    pub fn apply_filter(data: &mut [u8], filter: RenderFilter) {
-        match filter {
-            RenderFilter::Inverted => {
-                data.par_chunks_exact_mut(4).for_each(|pixel| {
-                    pixel[0] = 255 - pixel[0];
-                    pixel[1] = 255 - pixel[1];
-                    pixel[2] = 255 - pixel[2];
-                });
-            }
-            RenderFilter::Eco => {
-                data.par_chunks_exact_mut(4).for_each(|pixel| {
-                    let avg = (pixel[0] as u32 + pixel[1] as u32 + pixel[2] as u32) / 3;
-                    if avg > 200 {
-                        pixel[0] = 255;
-                        pixel[1] = 255;
-                        pixel[2] = 255;
+    /// Shrinks an RGBA bitmap to `width` x `height`, each output pixel the
+    /// rounded mean of the source pixels it covers. Rows run in parallel.
+    pub fn downsample_box(
+        data: &[u8],
+        src_width: u32,
+        src_height: u32,
+        width: u32,
+        height: u32,
+    ) -> Vec<u8> {
+        let (src_width, src_height) = (src_width as usize, src_height as usize);
+        let (width, height) = (width.max(1) as usize, height.max(1) as usize);
+        if src_width == 0 || src_height == 0 || data.len() < src_width * src_height * 4 {
+            return vec![255; width * height * 4];
+        }
+        // Source range `[start, end)` covered by output index `i`.
+        let span = |i: usize, src: usize, dst: usize| {
+            let start = (i * src / dst).min(src - 1);
+            (start, ((i + 1) * src / dst).clamp(start + 1, src))
+        };
+        let columns: Vec<(usize, usize)> = (0..width).map(|x| span(x, src_width, width)).collect();
+
+        let mut out = vec![0u8; width * height * 4];
+        out.par_chunks_exact_mut(width * 4)
+            .enumerate()
+            .for_each(|(y, row)| {
+                let (y0, y1) = span(y, src_height, height);
+                for (pixel, &(x0, x1)) in row.chunks_exact_mut(4).zip(&columns) {
+                    let mut sum = [0u32; 4];
+                    for sy in y0..y1 {
+                        let line = &data[(sy * src_width + x0) * 4..(sy * src_width + x1) * 4];
+                        for src in line.chunks_exact(4) {
+                            for (acc, &value) in sum.iter_mut().zip(src) {
+                                *acc += u32::from(value);
+                            }
+                        }
                     }
-                });
-            }
-            RenderFilter::BlackWhite => {
-                data.par_chunks_exact_mut(4).for_each(|pixel| {
-                    let avg = (pixel[0] as u32 + pixel[1] as u32 + pixel[2] as u32) / 3;
-                    let val = if avg > 128 { 255 } else { 0 };
-                    pixel[0] = val;
-                    pixel[1] = val;
-                    pixel[2] = val;
-                });
-            }
-            RenderFilter::Lighten => {
-                data.par_chunks_exact_mut(4).for_each(|pixel| {
-                    pixel[0] = pixel[0].saturating_add(20);
-                    pixel[1] = pixel[1].saturating_add(20);
-                    pixel[2] = pixel[2].saturating_add(20);
-                });
-            }
-            RenderFilter::NoShadow => {
-                data.par_chunks_exact_mut(4).for_each(|pixel| {
-                    if pixel[0] > NO_SHADOW_THRESHOLD
-                        && pixel[1] > NO_SHADOW_THRESHOLD
-                        && pixel[2] > NO_SHADOW_THRESHOLD
-                    {
-                        pixel[0] = 255;
-                        pixel[1] = 255;
-                        pixel[2] = 255;
+                    let count = ((y1 - y0) * (x1 - x0)) as u32;
+                    for (channel, acc) in pixel.iter_mut().zip(sum) {
+                        *channel = ((acc + count / 2) / count) as u8;
                     }
-                });
-            }
-            RenderFilter::Sepia => {
-                data.par_chunks_exact_mut(4).for_each(|pixel| {
-                    let r = pixel[0] as f32;
-                    let g = pixel[1] as f32;
-                    let b = pixel[2] as f32;
-                    pixel[0] = (r * 0.393 + g * 0.769 + b * 0.189).min(255.0) as u8;
-                    pixel[1] = (r * 0.349 + g * 0.686 + b * 0.168).min(255.0) as u8;
-                    pixel[2] = (r * 0.272 + g * 0.534 + b * 0.131).min(255.0) as u8;
-                });
-            }
-            RenderFilter::Grayscale => {
-                data.par_chunks_exact_mut(4).for_each(|pixel| {
-                    let luma =
-                        (pixel[0] as u32 * 299 + pixel[1] as u32 * 587 + pixel[2] as u32 * 114)
-                            / 1000;
-                    pixel[0] = luma as u8;
-                    pixel[1] = luma as u8;
-                    pixel[2] = luma as u8;
-                });
-            }
-            RenderFilter::None => {}
-        }
-    }
-
-    // apply_filter_parallel removed as it was just a misleading wrapper.
-
-    pub fn optimize_pdf(&self, input_path: &str, output_path: &str) -> PdfResult<String> {
-        let mut doc =
-            Document::load(input_path).map_err(|e| PdfError::OpenFailed(e.to_string()))?;
-        doc.compress();
-        let _ = doc.trailer.remove(b"Info");
-        doc.prune_objects();
-        doc.save(output_path)
-            .map_err(|e| PdfError::IoError(e.to_string()))?;
-        Ok(output_path.to_string())
+                }
+            });
+        out
     }
 
-    pub fn merge_documents(&self, paths: Vec<String>, output_path: String) -> PdfResult<String> {
-        let mut max_id = 1;
-        let mut documents = Vec::new();
-
-        for path in paths {
-            let mut doc = Document::load(&path).map_err(|e| PdfError::OpenFailed(e.to_string()))?;
-            doc.renumber_objects_with(max_id);
-            max_id = doc.max_id + 1;
-            documents.push(doc);
-        }
-
-        if documents.is_empty() {
-            return Err(PdfError::IoError("No documents to merge".into()));
-        }
-
-        let mut merged_doc = Document::with_version("1.5");
-        let mut merged_kids = Vec::new();
-        let mut merged_objects = std::collections::BTreeMap::new();
-
-        for doc in &documents {
-            for (id, object) in &doc.objects {
-                let is_catalog_or_pages = match object {
-                    Object::Dictionary(d) => {
-                        let type_name = d.get(b"Type").and_then(|o| o.as_name()).ok();
-                        type_name == Some(b"Catalog" as &[u8])
-                            || type_name == Some(b"Pages" as &[u8])
-                    }
-                    _ => false,
-                };
-                if !is_catalog_or_pages {
-                    merged_objects.insert(*id, object.clone());
+    #[allow(clippy::suboptimal_flops)]
+    pub fn apply_filter(data: &mut [u8], filter: RenderFilter) {
+        match filter {
+            RenderFilter::Inverted => Self::map_rgb(data, |[r, g, b]| [255 - r, 255 - g, 255 - b]),
+            RenderFilter::Eco => Self::map_rgb(data, |[r, g, b]| {
+                let avg = (r as u32 + g as u32 + b as u32) / 3;
+                if avg > 200 { [255; 3] } else { [r, g, b] }
+            }),
+            RenderFilter::BlackWhite => Self::map_rgb(data, |[r, g, b]| {
+                let avg = (r as u32 + g as u32 + b as u32) / 3;
+                [if avg > 128 { 255 } else { 0 }; 3]
+            }),
+            RenderFilter::Lighten => Self::map_rgb(data, |[r, g, b]| {
+                [
+                    r.saturating_add(20),
+                    g.saturating_add(20),
+                    b.saturating_add(20),
+                ]
+            }),
+            RenderFilter::NoShadow => Self::map_rgb(data, |[r, g, b]| {
+                if r > NO_SHADOW_THRESHOLD && g > NO_SHADOW_THRESHOLD && b > NO_SHADOW_THRESHOLD {
+                    [255; 3]
+                } else {
+                    [r, g, b]
                 }
-            }
-            let pages = doc.get_pages();
-            for (_, page_id) in pages {
-                merged_kids.push(Object::Reference(page_id));
-            }
+            }),
+            RenderFilter::Sepia => Self::map_rgb(data, |[r, g, b]| {
+                // The usual sepia matrix in thousandths, kept in integers.
+                let (r, g, b) = (r as u32, g as u32, b as u32);
+                [
+                    ((r * 393 + g * 769 + b * 189) / 1000).min(255) as u8,
+                    ((r * 349 + g * 686 + b * 168) / 1000).min(255) as u8,
+                    ((r * 272 + g * 534 + b * 131) / 1000).min(255) as u8,
+                ]
+            }),
+            RenderFilter::Grayscale => Self::map_rgb(data, |[r, g, b]| {
+                let luma = (r as u32 * 299 + g as u32 * 587 + b as u32 * 114) / 1000;
+                [luma as u8; 3]
+            }),
+            RenderFilter::None => {}
         }
+    }
 
-        let pages_id = max_id;
-        max_id += 1;
-
-        let count = merged_kids.len() as i32;
-        let pages_dict = lopdf::Dictionary::from_iter(vec![
-            ("Type", Object::Name(b"Pages".to_vec())),
-            ("Count", Object::Integer(count as i64)),
-            ("Kids", Object::Array(merged_kids)),
-        ]);
-        merged_objects.insert((pages_id, 0), Object::Dictionary(pages_dict));
-
-        let catalog_id = max_id;
-        max_id += 1;
-        let catalog_dict = lopdf::Dictionary::from_iter(vec![
-            ("Type", Object::Name(b"Catalog".to_vec())),
-            ("Pages", Object::Reference((pages_id, 0))),
-        ]);
-        merged_objects.insert((catalog_id, 0), Object::Dictionary(catalog_dict));
-
-        for doc in &documents {
-            let pages = doc.get_pages();
-            for (_, page_id) in pages {
-                if let Some(Object::Dictionary(dict)) = merged_objects.get_mut(&page_id) {
-                    dict.set("Parent", Object::Reference((pages_id, 0)));
-                }
+    /// Rewrites the RGB channels of every RGBA pixel, leaving alpha alone.
+    /// Work is split into `FILTER_CHUNK_BYTES` slabs rather than single
+    /// pixels, so each rayon task runs a branch-light loop that LLVM
+    /// vectorizes instead of one closure call per pixel.
+    #[inline]
+    fn map_rgb(data: &mut [u8], f: impl Fn([u8; 3]) -> [u8; 3] + Sync) {
+        data.par_chunks_mut(FILTER_CHUNK_BYTES).for_each(|slab| {
+            for pixel in slab.chunks_exact_mut(4) {
+                let [r, g, b] = f([pixel[0], pixel[1], pixel[2]]);
+                pixel[0] = r;
+                pixel[1] = g;
+                pixel[2] = b;
             }
-        }
+        });
+    }
 
-        merged_doc.objects = merged_objects;
-        merged_doc
-            .trailer
-            .set("Root", Object::Reference((catalog_id, 0)));
-        merged_doc.trailer.set("Size", max_id as i64);
-        merged_doc.max_id = max_id - 1;
+    // apply_filter_parallel removed as it was just a misleading wrapper.
 
-        merged_doc
-            .save(&output_path)
-            .map_err(|e| PdfError::IoError(e.to_string()))?;
+    pub fn optimize_pdf(
+        &self,
+        input_path: &str,
+        output_path: &str,
+        options: &crate::optimize::OptimizeOptions,
+    ) -> PdfResult<crate::optimize::OptimizeReport> {
+        crate::optimize::optimize(input_path, output_path, options)
+    }
 
+    pub fn merge_documents(&self, paths: Vec<String>, output_path: String) -> PdfResult<String> {
+        crate::doc_ops::merge(&paths, &output_path)?;
         Ok(output_path)
     }
 
@@ -1879,47 +3236,7 @@ impl DocumentStore {
         page_order: &[usize],
         output_path: &str,
     ) -> PdfResult<String> {
-        let mut doc = lopdf::Document::load(input_path)
-            .map_err(|e| PdfError::from(format!("Failed to load PDF for reorder: {e}")))?;
-
-        let pages: Vec<lopdf::ObjectId> = doc.page_iter().collect();
-        let total = pages.len();
-
-        // Build the new page list in the requested order (filter out-of-range indices)
-        let reordered: Vec<lopdf::ObjectId> = page_order
-            .iter()
-            .filter(|&&i| i < total)
-            .map(|&i| pages[i])
-            .collect();
-
-        if reordered.is_empty() {
-            return Err(PdfError::from("No valid pages in reorder mapping"));
-        }
-
-        // Get or build the Pages root
-        let pages_root_id = doc.get_pages().values().next().and_then(|&oid| {
-            doc.get_object(oid)
-                .ok()
-                .and_then(|o| o.as_dict().ok())
-                .and_then(|d| d.get(b"Parent").ok())
-                .and_then(|p| p.as_reference().ok())
-        });
-
-        if let Some(root_id) = pages_root_id {
-            // Update Kids array on the Pages root
-            if let Ok(lopdf::Object::Dictionary(dict)) = doc.get_object_mut(root_id) {
-                let kids: Vec<lopdf::Object> = reordered
-                    .iter()
-                    .map(|&id| lopdf::Object::Reference(id))
-                    .collect();
-                dict.set(b"Kids", lopdf::Object::Array(kids));
-                dict.set(b"Count", lopdf::Object::Integer(reordered.len() as i64));
-            }
-        }
-
-        doc.save(output_path)
-            .map_err(|e| PdfError::from(format!("Failed to save reordered PDF: {e}")))?;
-
+        crate::doc_ops::reorder(input_path, page_order, output_path)?;
         Ok(output_path.to_string())
     }
 
@@ -1929,48 +3246,12 @@ impl DocumentStore {
         page_indices: Vec<usize>,
         output_dir: String,
     ) -> PdfResult<Vec<String>> {
-        let mut created_paths = Vec::new();
-        let template_doc = Document::load(path).map_err(|e| PdfError::OpenFailed(e.to_string()))?;
-        let page_count = template_doc.get_pages().len();
-
-        for &page_idx in &page_indices {
-            let mut doc = template_doc.clone();
-            let keep_page_1_based = (page_idx + 1) as u32;
-
-            let mut to_delete = Vec::new();
-            for p in 1..=(page_count as u32) {
-                if p != keep_page_1_based {
-                    to_delete.push(p);
-                }
-            }
-
-            doc.delete_pages(&to_delete);
-
-            let filename = std::path::Path::new(path)
-                .file_stem()
-                .and_then(|s| s.to_str())
-                .unwrap_or("document");
-
-            let out_path = format!("{}/{}_page_{}.pdf", output_dir, filename, page_idx + 1);
-            doc.save(&out_path)
-                .map_err(|e| PdfError::IoError(e.to_string()))?;
-            created_paths.push(out_path);
-        }
-
-        Ok(created_paths)
+        crate::doc_ops::split(path, &page_indices, &output_dir)
     }
 
     pub fn get_form_fields(&mut self, path: &str) -> PdfResult<Vec<FormField>> {
-        let doc_id = self
-            .paths
-            .iter()
-            .find(|(_, p)| *p == path)
-            .map(|(id, _)| *id);
-
-        if let Some(id) = doc_id {
-            if let Some(doc) = self.documents.get(&id) {
-                return Ok(self.extract_form_fields_from_doc(doc));
-            }
+        if let Some(shared) = self.registry.find_by_path(path) {
+            return Ok(self.extract_form_fields_from_doc(&shared.doc));
         }
 
         let data = std::fs::read(path).map_err(|e| PdfError::OpenFailed(e.to_string()))?;
@@ -2266,15 +3547,50 @@ impl DocumentStore {
     }
 }
 
-pub fn create_render_cache(cache_size: u64, max_memory_mb: u64) -> SharedRenderCache {
+/// Tables `detect_tables` finds among a page's spans, in y-down layout space.
+fn page_tables(spans: &[zpdf::TextSpan], page_height: f32) -> Vec<crate::models::DetectedTable> {
+    detect_tables(spans)
+        .into_iter()
+        .map(|t| {
+            let (x0, y0, x1, y1) = t.bbox();
+            // Coordinate conversion to y-down layout space:
+            // x = x0, y = page_height - y1, w = x1 - x0, h = y1 - y0
+            let bbox = (
+                x0 as f32,
+                page_height - y1 as f32,
+                (x1 - x0) as f32,
+                (y1 - y0) as f32,
+            );
+            crate::models::DetectedTable {
+                bbox,
+                csv: t.to_csv(),
+                tsv: t.to_tsv(),
+                cells: t.cells,
+            }
+        })
+        .collect()
+}
+
+pub fn create_document_registry() -> SharedDocumentRegistry {
+    Arc::new(DocumentRegistry::default())
+}
+
+pub fn create_render_cache(
+    cache_size: u64,
+    max_memory_mb: u64,
+    disk_cache_mb: u64,
+) -> SharedRenderCache {
     let mb = (max_memory_mb * 1024 * 1024) as usize;
-    Arc::new(RenderCache::new(
-        cache_size as usize,
-        if mb == 0 { 512 * 1024 * 1024 } else { mb },
-    ))
+    Arc::new(
+        RenderCache::new(
+            cache_size as usize,
+            if mb == 0 { 512 * 1024 * 1024 } else { mb },
+        )
+        .with_disk(DiskCache::in_config_dir(disk_cache_mb)),
+    )
 }
 
-#[derive(Clone, Debug)]
+#[derive(Clone, Debug, serde::Serialize, serde::Deserialize)]
 pub struct Bookmark {
     pub title: String,
     pub page_index: usize,
@@ -2290,16 +3606,26 @@ mod tests {
         let key1 = RenderKey {
             doc_id,
             page_num: 0,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         let key2 = RenderKey {
             doc_id,
             page_num: 0,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         assert_eq!(key1, key2);
     }
@@ -2310,16 +3636,26 @@ mod tests {
         let key1 = RenderKey {
             doc_id,
             page_num: 0,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         let key2 = RenderKey {
             doc_id,
             page_num: 1,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         assert_ne!(key1, key2);
     }
@@ -2330,16 +3666,26 @@ mod tests {
         let key1 = RenderKey {
             doc_id,
             page_num: 0,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         let key2 = RenderKey {
             doc_id,
             page_num: 0,
+            rotation: 0,
             scale: 200,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         assert_ne!(key1, key2);
     }
@@ -2349,16 +3695,26 @@ mod tests {
         let key1 = RenderKey {
             doc_id: DocumentId(1),
             page_num: 0,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         let key2 = RenderKey {
             doc_id: DocumentId(2),
             page_num: 0,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         assert_ne!(key1, key2);
     }
@@ -2369,20 +3725,103 @@ mod tests {
         let key_low = RenderKey {
             doc_id,
             page_num: 0,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         let key_high = RenderKey {
             doc_id,
             page_num: 0,
+            rotation: 0,
             scale: 200,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         assert_ne!(key_low, key_high);
     }
 
+    #[test]
+    fn test_render_key_distinguishes_rotation() {
+        let upright = RenderKey {
+            doc_id: DocumentId(1),
+            page_num: 0,
+            rotation: 0,
+            scale: 100,
+            auto_crop: false,
+            quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
+        };
+        let rotated = RenderKey {
+            rotation: 90,
+            ..upright.clone()
+        };
+        assert_ne!(upright, rotated);
+    }
+
+    #[test]
+    fn test_display_list_key_tracks_rotation_and_layers() {
+        let key = DisplayListKey {
+            doc_id: DocumentId(1),
+            page_num: 3,
+            rotation: 0,
+            oc_state: 0,
+            generation: 0,
+        };
+        assert_eq!(key, key.clone());
+        assert_ne!(
+            key,
+            DisplayListKey {
+                oc_state: 1,
+                ..key.clone()
+            }
+        );
+        assert_ne!(
+            key,
+            DisplayListKey {
+                rotation: 180,
+                ..key.clone()
+            }
+        );
+    }
+
+    #[test]
+    fn test_oc_state_only_counts_groups_the_page_uses() {
+        let walls = (10, 0);
+        let wiring = (11, 0);
+        let mut changed = BTreeSet::new();
+        assert_eq!(oc_state_hash(&changed, None), 0);
+
+        changed.insert(wiring);
+        assert_eq!(
+            oc_state_hash(&changed, Some(&[walls])),
+            0,
+            "unrelated layer"
+        );
+        let toggled = oc_state_hash(&changed, Some(&[walls, wiring]));
+        assert_ne!(toggled, 0);
+        assert_eq!(
+            oc_state_hash(&changed, None),
+            toggled,
+            "unknown pages count all"
+        );
+
+        changed.insert(walls);
+        assert_ne!(oc_state_hash(&changed, Some(&[walls, wiring])), toggled);
+        assert_eq!(oc_state_hash(&changed, Some(&[wiring])), toggled);
+    }
+
     #[test]
     fn test_render_cache_creation() {
         let cache = RenderCache::new(10, 100);
@@ -2390,9 +3829,14 @@ mod tests {
             cache.get(&RenderKey {
                 doc_id: DocumentId(1),
                 page_num: 0,
+                rotation: 0,
                 scale: 100,
                 auto_crop: false,
                 quality: RenderQuality::Medium,
+                tile: None,
+                filter: RenderFilter::None,
+                oc_state: 0,
+                generation: 0,
             }),
             None
         );
@@ -2404,9 +3848,14 @@ mod tests {
         let key = RenderKey {
             doc_id: DocumentId(1),
             page_num: 0,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         let result = crate::models::RenderResult {
             width: 100,
@@ -2425,9 +3874,14 @@ mod tests {
         let key = RenderKey {
             doc_id: DocumentId(1),
             page_num: 0,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         let result1 = crate::models::RenderResult {
             width: 100,
@@ -2451,16 +3905,26 @@ mod tests {
         let key1 = RenderKey {
             doc_id: DocumentId(1),
             page_num: 0,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         let key2 = RenderKey {
             doc_id: DocumentId(1),
             page_num: 1,
+            rotation: 0,
             scale: 100,
             auto_crop: false,
             quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
         };
         let result1 = crate::models::RenderResult {
             width: 100,
@@ -2478,6 +3942,54 @@ mod tests {
         assert_eq!(cache.get(&key2).unwrap().width, 200);
     }
 
+    #[test]
+    fn test_render_cache_promotes_demoted_bitmap() {
+        let cache = RenderCache::new(10, 1024 * 1024);
+        let key = RenderKey {
+            doc_id: DocumentId(1),
+            page_num: 0,
+            rotation: 0,
+            scale: 100,
+            auto_crop: false,
+            quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
+        };
+        let page = crate::models::RenderResult {
+            width: 32,
+            height: 32,
+            data: vec![255u8; 32 * 32 * 4].into(),
+        };
+        cache.demote(key.clone(), &page);
+        assert!(cache.cache.get(&key).is_none());
+        assert_eq!(cache.get(&key), Some(page.clone()));
+        assert!(cache.cache.get(&key).is_some(), "promoted to raw tier");
+        assert!(cache.compressed.get(&key).is_none());
+
+        let filtered = RenderKey {
+            filter: RenderFilter::Inverted,
+            ..key.clone()
+        };
+        cache.demote(filtered.clone(), &page);
+        assert!(cache.get(&filtered).is_none(), "filtered bitmaps not kept");
+
+        let noise = crate::models::RenderResult {
+            data: (0..32 * 32 * 4)
+                .map(|i| (i * 7) as u8)
+                .collect::<Vec<_>>()
+                .into(),
+            ..page
+        };
+        let other = RenderKey { page_num: 1, ..key };
+        cache.demote(other.clone(), &noise);
+        assert!(
+            cache.get(&other).is_none(),
+            "incompressible bitmaps dropped"
+        );
+    }
+
     #[test]
     fn test_apply_filter_inverted() {
         let mut data = vec![100, 150, 200, 255, 50, 75, 100, 255];
@@ -2579,6 +4091,43 @@ mod tests {
         assert_eq!(data[2], 200);
     }
 
+    #[test]
+    fn test_apply_filter_sepia() {
+        let mut data = vec![100, 150, 200, 255, 255, 255, 255, 7];
+        DocumentStore::apply_filter(&mut data, RenderFilter::Sepia);
+        assert_eq!(&data[..4], &[192, 171, 133, 255]);
+        assert_eq!(&data[4..], &[255, 255, 238, 7]);
+    }
+
+    #[test]
+    fn test_apply_filter_spans_chunks() {
+        let pixels = FILTER_CHUNK_BYTES / 4 * 3 + 5;
+        let mut data = [10u8, 20, 30, 40].repeat(pixels);
+        DocumentStore::apply_filter(&mut data, RenderFilter::Inverted);
+        assert!(data.chunks_exact(4).all(|p| p == [245, 235, 225, 40]));
+    }
+
+    #[test]
+    fn test_render_key_distinguishes_filter() {
+        let base = RenderKey {
+            doc_id: DocumentId(1),
+            page_num: 0,
+            rotation: 0,
+            scale: 100,
+            auto_crop: false,
+            quality: RenderQuality::Medium,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
+        };
+        let inverted = RenderKey {
+            filter: RenderFilter::Inverted,
+            ..base.clone()
+        };
+        assert_ne!(base, inverted);
+    }
+
     #[test]
     fn test_apply_filter_large_buffer() {
         let mut data = vec![0u8; 10000];
@@ -2596,6 +4145,23 @@ mod tests {
         }
     }
 
+    #[test]
+    fn test_downsample_box_averages_covered_pixels() {
+        // 4x2 source: left half black, right half white.
+        let mut data = vec![255u8; 4 * 2 * 4];
+        for y in 0..2 {
+            for x in 0..2 {
+                data[(y * 4 + x) * 4..(y * 4 + x) * 4 + 3].fill(0);
+            }
+        }
+        let out = DocumentStore::downsample_box(&data, 4, 2, 2, 1);
+        assert_eq!(out, vec![0, 0, 0, 255, 255, 255, 255, 255]);
+
+        let out = DocumentStore::downsample_box(&data, 4, 2, 1, 1);
+        assert_eq!(out, vec![128, 128, 128, 255]);
+        assert_eq!(DocumentStore::downsample_box(&[], 0, 0, 3, 2).len(), 24);
+    }
+
     #[test]
     fn test_detect_content_bbox_parallel_empty() {
         let data = vec![255u8; 400];
@@ -2628,15 +4194,20 @@ mod tests {
 
     #[test]
     fn test_create_render_cache_defaults() {
-        let cache = create_render_cache(10, 0);
+        let cache = create_render_cache(10, 0, 0);
         assert!(
             cache
                 .get(&RenderKey {
                     doc_id: DocumentId(1),
                     page_num: 0,
+                    rotation: 0,
                     scale: 100,
                     auto_crop: false,
                     quality: RenderQuality::Medium,
+                    tile: None,
+                    filter: RenderFilter::None,
+                    oc_state: 0,
+                    generation: 0,
                 })
                 .is_none()
         );
@@ -2695,10 +4266,332 @@ mod tests {
         assert_eq!(inverted, RenderFilter::Inverted);
     }
 
+    #[test]
+    fn test_export_images_streams_progress() {
+        let mut store = DocumentStore::new(create_render_cache(10, 0, 0));
+        let mut path = std::path::PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+        path.push("tests");
+        path.push("test_document.pdf");
+        let doc_id = DocumentId(1);
+        store
+            .open_document(path.to_str().unwrap(), None, doc_id)
+            .unwrap();
+
+        let out_dir = std::env::temp_dir().join(format!("pdfbull_export_{}", std::process::id()));
+        std::fs::create_dir_all(&out_dir).unwrap();
+        let (tx, mut rx) = iced::futures::channel::mpsc::unbounded();
+        let cancel = AtomicBool::new(false);
+        store.export_images(
+            doc_id,
+            &[0, 999],
+            0.5,
+            out_dir.to_str().unwrap(),
+            0,
+            &cancel,
+            &tx,
+        );
+        drop(tx);
+
+        let mut updates = Vec::new();
+        while let Ok(Some(update)) = rx.try_next() {
+            updates.push(update.unwrap());
+        }
+        assert_eq!(updates.len(), 2);
+        assert_eq!(updates[1].done, 2);
+        assert_eq!(updates[1].failed, 1, "page 999 does not exist");
+        assert!(out_dir.join("page_0.png").exists());
+
+        let (tx, mut rx) = iced::futures::channel::mpsc::unbounded();
+        store.export_images(doc_id, &[0], 0.5, "/nonexistent/pdfbull", 0, &cancel, &tx);
+        assert!(matches!(rx.try_next(), Ok(Some(Err(PdfError::IoError(_))))));
+
+        let (tx, mut rx) = iced::futures::channel::mpsc::unbounded();
+        cancel.store(true, Ordering::Relaxed);
+        store.export_images(
+            doc_id,
+            &[0],
+            0.5,
+            out_dir.to_str().unwrap(),
+            0,
+            &cancel,
+            &tx,
+        );
+        assert!(matches!(rx.try_next(), Ok(Some(Err(PdfError::Cancelled)))));
+
+        let _ = std::fs::remove_dir_all(&out_dir);
+    }
+
+    #[test]
+    fn test_reload_keeps_renders_of_unchanged_pages() {
+        let mut store = DocumentStore::new(create_render_cache(10, 0, 0));
+        let path = std::env::temp_dir().join(format!("pdfbull_reload_{}.pdf", std::process::id()));
+        std::fs::copy(
+            concat!(env!("CARGO_MANIFEST_DIR"), "/tests/test_document.pdf"),
+            &path,
+        )
+        .unwrap();
+        let doc_id = DocumentId(1);
+        store
+            .open_document(path.to_str().unwrap(), None, doc_id)
+            .unwrap();
+        let options = RenderOptions {
+            scale: 0.5,
+            rotation: 0,
+            filter: RenderFilter::None,
+            auto_crop: false,
+            quality: RenderQuality::Low,
+        };
+        store.render_page(doc_id, 0, options).unwrap();
+        let key = RenderKey {
+            doc_id,
+            page_num: 0,
+            rotation: 0,
+            scale: 50,
+            auto_crop: false,
+            quality: RenderQuality::Low,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
+        };
+
+        let reloaded = store.reload_document(doc_id).unwrap();
+        assert!(reloaded.changed_pages.is_empty());
+        assert_eq!(reloaded.open.generation, 1);
+        let kept = RenderKey {
+            generation: 1,
+            ..key.clone()
+        };
+        assert!(
+            store.render_cache.get(&key).is_none(),
+            "old generation moved"
+        );
+        assert!(
+            store.render_cache.get(&kept).is_some(),
+            "unchanged page kept"
+        );
+
+        store.close_document(doc_id);
+        assert!(
+            store.render_cache.get(&kept).is_none(),
+            "kept key still tracked"
+        );
+        assert!(store.reload_document(doc_id).is_err());
+        let _ = std::fs::remove_file(&path);
+    }
+
+    /// One page drawing image `Im0`, whose single gray sample is `shade`.
+    fn write_image_page(path: &std::path::Path, shade: u8) {
+        let mut doc = Document::with_version("1.7");
+        let mut image = lopdf::Dictionary::new();
+        image.set("Subtype", Object::Name(b"Image".to_vec()));
+        image.set("Width", Object::Integer(1));
+        image.set("Height", Object::Integer(1));
+        image.set("ColorSpace", Object::Name(b"DeviceGray".to_vec()));
+        image.set("BitsPerComponent", Object::Integer(8));
+        let image_id = doc.add_object(lopdf::Stream::new(image, vec![shade]));
+        let mut xobjects = lopdf::Dictionary::new();
+        xobjects.set("Im0", Object::Reference(image_id));
+        let mut resources = lopdf::Dictionary::new();
+        resources.set("XObject", Object::Dictionary(xobjects));
+        let content = doc.add_object(lopdf::Stream::new(
+            lopdf::Dictionary::new(),
+            b"q 100 0 0 100 0 0 cm /Im0 Do Q".to_vec(),
+        ));
+
+        let pages_id = doc.new_object_id();
+        let mut page = lopdf::Dictionary::new();
+        page.set("Type", Object::Name(b"Page".to_vec()));
+        page.set("Parent", Object::Reference(pages_id));
+        page.set("Resources", Object::Dictionary(resources));
+        page.set("Contents", Object::Reference(content));
+        page.set(
+            "MediaBox",
+            Object::Array([0, 0, 100, 100].map(Object::Integer).to_vec()),
+        );
+        let page_id = doc.add_object(page);
+        let mut pages = lopdf::Dictionary::new();
+        pages.set("Type", Object::Name(b"Pages".to_vec()));
+        pages.set("Count", Object::Integer(1));
+        pages.set("Kids", Object::Array(vec![Object::Reference(page_id)]));
+        doc.objects.insert(pages_id, Object::Dictionary(pages));
+        let mut catalog = lopdf::Dictionary::new();
+        catalog.set("Type", Object::Name(b"Catalog".to_vec()));
+        catalog.set("Pages", Object::Reference(pages_id));
+        let catalog_id = doc.add_object(catalog);
+        doc.trailer.set("Root", Object::Reference(catalog_id));
+        doc.save(path).unwrap();
+    }
+
+    #[test]
+    fn test_reload_notices_changed_image_behind_same_content() {
+        let mut store = DocumentStore::new(create_render_cache(10, 0, 0));
+        let path =
+            std::env::temp_dir().join(format!("pdfbull_reload_image_{}.pdf", std::process::id()));
+        write_image_page(&path, 0);
+        let doc_id = DocumentId(1);
+        store
+            .open_document(path.to_str().unwrap(), None, doc_id)
+            .unwrap();
+        assert!(
+            store
+                .reload_document(doc_id)
+                .unwrap()
+                .changed_pages
+                .is_empty()
+        );
+
+        write_image_page(&path, 255);
+        let reloaded = store.reload_document(doc_id).unwrap();
+        let _ = std::fs::remove_file(&path);
+        assert_eq!(reloaded.changed_pages, vec![0]);
+    }
+
+    #[test]
+    fn test_thumbnail_derived_from_cached_render() {
+        let mut store = DocumentStore::new(create_render_cache(10, 0, 0));
+        let path = concat!(env!("CARGO_MANIFEST_DIR"), "/tests/test_document.pdf");
+        let doc_id = DocumentId(1);
+        store.open_document(path, None, doc_id).unwrap();
+        let options = |scale, quality| RenderOptions {
+            scale,
+            rotation: 0,
+            filter: RenderFilter::None,
+            auto_crop: false,
+            quality,
+        };
+        let page = store
+            .render_page(doc_id, 0, options(1.0, RenderQuality::Medium))
+            .unwrap();
+
+        let thumbnail = store
+            .render_thumbnail(doc_id, 0, options(0.2, RenderQuality::Low))
+            .unwrap();
+        assert_eq!(thumbnail.width, (page.width as f32 * 0.2).round() as u32);
+        assert_eq!(thumbnail.height, (page.height as f32 * 0.2).round() as u32);
+        let again = store
+            .render_thumbnail(doc_id, 0, options(0.2, RenderQuality::Low))
+            .unwrap();
+        assert_eq!(again, thumbnail, "second request is a cache hit");
+    }
+
+    #[test]
+    fn test_render_leaves_spans_for_text_and_tables() {
+        let mut store = DocumentStore::new(create_render_cache(10, 0, 0));
+        let path = concat!(env!("CARGO_MANIFEST_DIR"), "/tests/test_document.pdf");
+        let doc_id = DocumentId(1);
+        store.open_document(path, None, doc_id).unwrap();
+        let options = RenderOptions {
+            scale: 0.5,
+            rotation: 0,
+            filter: RenderFilter::None,
+            auto_crop: false,
+            quality: RenderQuality::Low,
+        };
+        store.render_page(doc_id, 0, options).unwrap();
+
+        let shared = store.document(doc_id).unwrap();
+        assert!(shared.captured_spans.peek(&0).is_some());
+        assert!(
+            shared.text_index.page(0).is_none(),
+            "text layer is not built on the render path"
+        );
+        assert!(shared.tables.peek(&0).is_none());
+
+        let overlays = store.page_overlays(doc_id, vec![0], true, true);
+        assert_eq!(overlays.len(), 1);
+        assert!(matches!(overlays[0].text_items, Some(Ok(_))));
+        assert!(matches!(overlays[0].tables, Some(Ok(_))));
+        let text = shared
+            .text_index
+            .page(0)
+            .expect("built from the captured spans");
+        assert_eq!(
+            overlays[0].text_items.as_ref().unwrap().as_ref().unwrap(),
+            &text.text_items()
+        );
+        assert!(shared.tables.peek(&0).is_some());
+        assert!(shared.captured_spans.peek(&0).is_none(), "spans released");
+    }
+
+    #[test]
+    fn test_render_tiles_draws_tile_sized_bitmaps() {
+        let mut store = DocumentStore::new(create_render_cache(10, 64, 0));
+        let path = concat!(env!("CARGO_MANIFEST_DIR"), "/tests/test_document.pdf");
+        let doc_id = DocumentId(1);
+        store.open_document(path, None, doc_id).unwrap();
+        let options = RenderOptions {
+            scale: 4.0,
+            rotation: 0,
+            filter: RenderFilter::None,
+            auto_crop: false,
+            quality: RenderQuality::Low,
+        };
+        let tiles = store
+            .render_tiles(doc_id, 0, options.clone(), &[(0, 0), (100, 100)])
+            .unwrap();
+        assert_eq!(tiles.len(), 2, "tiles past the page come back empty");
+        assert_eq!(tiles[0].result.width, TILE_SIZE);
+        assert_eq!(
+            tiles[0].result.data.len(),
+            (TILE_SIZE * TILE_SIZE * 4) as usize
+        );
+        assert!(tiles[1].result.data.is_empty());
+
+        let shared = store.document(doc_id).unwrap();
+        let keys = shared.cache_keys.lock().unwrap();
+        let keys: Vec<&RenderKey> = keys.values().flatten().collect();
+        assert!(keys.iter().any(|key| key.tile == Some((100, 100))));
+        assert!(
+            keys.iter().all(|key| key.tile.is_some()),
+            "no whole-page render"
+        );
+    }
+
+    #[test]
+    fn test_trim_memory_drops_background_documents_first() {
+        let mut store = DocumentStore::new(create_render_cache(10, 0, 0));
+        let path = concat!(env!("CARGO_MANIFEST_DIR"), "/tests/test_document.pdf");
+        let (active, background) = (DocumentId(1), DocumentId(2));
+        let options = RenderOptions {
+            scale: 0.5,
+            rotation: 0,
+            filter: RenderFilter::None,
+            auto_crop: false,
+            quality: RenderQuality::Low,
+        };
+        let key = |doc_id| RenderKey {
+            doc_id,
+            page_num: 0,
+            rotation: 0,
+            scale: 50,
+            auto_crop: false,
+            quality: RenderQuality::Low,
+            tile: None,
+            filter: RenderFilter::None,
+            oc_state: 0,
+            generation: 0,
+        };
+        for doc_id in [active, background] {
+            store.open_document(path, None, doc_id).unwrap();
+            store.render_page(doc_id, 0, options).unwrap();
+        }
+
+        assert_eq!(store.trim_memory(Some(active), u64::MAX), 0);
+        let held = store.render_cache.resident_bytes();
+        assert!(store.trim_memory(Some(active), held - 1) > 0);
+        assert!(store.render_cache.get(&key(active)).is_some());
+        assert!(store.render_cache.get(&key(background)).is_none());
+
+        store.trim_memory(Some(active), 0);
+        assert!(store.render_cache.get(&key(active)).is_none());
+        assert_eq!(store.render_cache.resident_bytes(), 0);
+    }
+
     #[test]
     fn test_crash_investigation() {
         let handle = std::thread::spawn(move || {
-            let mut store = DocumentStore::new(create_render_cache(10, 0));
+            let mut store = DocumentStore::new(create_render_cache(10, 0, 0));
             let mut path = std::path::PathBuf::from(env!("CARGO_MANIFEST_DIR"));
             path.push("tests");
             path.push("test_document.pdf");
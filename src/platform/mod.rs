@@ -7,6 +7,29 @@ pub mod dummy {
     pub fn ensure_single_instance(_args: &[String]) -> Result<bool, Box<dyn std::error::Error>> {
         Ok(false)
     }
+
+    /// Share of physical memory still available, from `/proc/meminfo`.
+    #[cfg(target_os = "linux")]
+    pub fn available_memory_percent() -> Option<u8> {
+        let meminfo = std::fs::read_to_string("/proc/meminfo").ok()?;
+        let field = |name: &str| -> Option<u64> {
+            meminfo
+                .lines()
+                .find_map(|line| line.strip_prefix(name)?.strip_prefix(':'))?
+                .split_whitespace()
+                .next()?
+                .parse()
+                .ok()
+        };
+        let total = field("MemTotal")?;
+        let available = field("MemAvailable")?;
+        (total > 0).then(|| (available * 100 / total).min(100) as u8)
+    }
+
+    #[cfg(not(target_os = "linux"))]
+    pub fn available_memory_percent() -> Option<u8> {
+        None
+    }
 }
 
 #[cfg(windows)]
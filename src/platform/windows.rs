@@ -10,6 +10,44 @@ unsafe extern "system" {
 
 const SW_RESTORE: i32 = 9;
 
+#[repr(C)]
+#[allow(dead_code)]
+struct MemoryStatusEx {
+    length: u32,
+    memory_load: u32,
+    total_phys: u64,
+    avail_phys: u64,
+    total_page_file: u64,
+    avail_page_file: u64,
+    total_virtual: u64,
+    avail_virtual: u64,
+    avail_extended_virtual: u64,
+}
+
+#[link(name = "kernel32")]
+unsafe extern "system" {
+    fn GlobalMemoryStatusEx(buffer: *mut MemoryStatusEx) -> i32;
+}
+
+/// Share of physical memory still available, from `GlobalMemoryStatusEx`.
+pub fn available_memory_percent() -> Option<u8> {
+    let mut status = MemoryStatusEx {
+        length: std::mem::size_of::<MemoryStatusEx>() as u32,
+        memory_load: 0,
+        total_phys: 0,
+        avail_phys: 0,
+        total_page_file: 0,
+        avail_page_file: 0,
+        total_virtual: 0,
+        avail_virtual: 0,
+        avail_extended_virtual: 0,
+    };
+    if unsafe { GlobalMemoryStatusEx(&mut status) } == 0 {
+        return None;
+    }
+    Some(100u32.saturating_sub(status.memory_load).min(100) as u8)
+}
+
 pub fn ensure_single_instance(args: &[String]) -> Result<bool, Box<dyn std::error::Error>> {
     use interprocess::local_socket::{GenericNamespaced, Stream, prelude::*};
     use std::io::Write;
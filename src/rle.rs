@@ -0,0 +1,115 @@
+//! Run-length coding of RGBA bitmaps for the compressed render-cache tier.
+//!
+//! Page renders are mostly runs of one colour, white above all, so whole-pixel
+//! runs shrink them by an order of magnitude while staying far cheaper to code
+//! than a general-purpose compressor. The stream is a sequence of tokens, each
+//! a little-endian `u32` header: with the top bit set, a run of `header & !RUN`
+//! copies of the one pixel that follows; otherwise that many literal pixels.
+
+const RUN: u32 = 1 << 31;
+/// Shorter repeats stay in literals; a run token costs two pixels' worth.
+const MIN_RUN: usize = 3;
+
+pub fn encode(rgba: &[u8]) -> Vec<u8> {
+    let count = rgba.len() / 4;
+    let pixel = |i: usize| &rgba[i * 4..i * 4 + 4];
+    let word = |i: usize| {
+        u32::from_ne_bytes([
+            rgba[i * 4],
+            rgba[i * 4 + 1],
+            rgba[i * 4 + 2],
+            rgba[i * 4 + 3],
+        ])
+    };
+    let mut out = Vec::with_capacity(rgba.len() / 16);
+    let mut literal_start = 0;
+    let mut i = 0;
+    while i < count {
+        let first = word(i);
+        let mut j = i + 1;
+        while j < count && word(j) == first && j - i < (RUN - 1) as usize {
+            j += 1;
+        }
+        if j - i >= MIN_RUN {
+            push_literals(&mut out, &rgba[literal_start * 4..i * 4]);
+            out.extend_from_slice(&(RUN | (j - i) as u32).to_le_bytes());
+            out.extend_from_slice(pixel(i));
+            literal_start = j;
+        }
+        i = j;
+    }
+    push_literals(&mut out, &rgba[literal_start * 4..count * 4]);
+    out
+}
+
+/// Writes the whole pixels of `literals` as literal tokens.
+fn push_literals(out: &mut Vec<u8>, literals: &[u8]) {
+    for chunk in literals.chunks(((RUN - 1) as usize).saturating_mul(4)) {
+        out.extend_from_slice(&((chunk.len() / 4) as u32).to_le_bytes());
+        out.extend_from_slice(chunk);
+    }
+}
+
+/// Decodes a stream from `encode`; `None` if it is corrupt or does not hold
+/// exactly `len` bytes of pixels.
+pub fn decode(encoded: &[u8], len: usize) -> Option<Vec<u8>> {
+    let mut out = Vec::with_capacity(len);
+    let mut rest = encoded;
+    while let Some((header, tail)) = rest.split_first_chunk::<4>() {
+        let header = u32::from_le_bytes(*header);
+        let count = (header & !RUN) as usize;
+        if header & RUN != 0 {
+            let (pixel, tail) = tail.split_first_chunk::<4>()?;
+            if out.len() + count * 4 > len {
+                return None;
+            }
+            for _ in 0..count {
+                out.extend_from_slice(pixel);
+            }
+            rest = tail;
+        } else {
+            let bytes = tail.get(..count * 4)?;
+            out.extend_from_slice(bytes);
+            rest = &tail[count * 4..];
+        }
+    }
+    (rest.is_empty() && out.len() == len).then_some(out)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn page_like() -> Vec<u8> {
+        let mut data = [255u8; 4].repeat(1000);
+        for i in (400..420).step_by(2) {
+            data[i * 4..i * 4 + 3].copy_from_slice(&[0, 0, 0]);
+        }
+        data
+    }
+
+    #[test]
+    fn test_roundtrip_mixed_content() {
+        let data = page_like();
+        let encoded = encode(&data);
+        assert!(encoded.len() * 10 < data.len(), "white runs compress");
+        assert_eq!(decode(&encoded, data.len()), Some(data));
+    }
+
+    #[test]
+    fn test_roundtrip_without_runs() {
+        let data: Vec<u8> = (0..400u32).flat_map(|i| i.to_le_bytes()).collect();
+        let encoded = encode(&data);
+        assert_eq!(encoded.len(), data.len() + 4);
+        assert_eq!(decode(&encoded, data.len()), Some(data));
+        assert_eq!(decode(&[], 0), Some(Vec::new()));
+    }
+
+    #[test]
+    fn test_decode_rejects_corrupt_input() {
+        let data = page_like();
+        let encoded = encode(&data);
+        assert_eq!(decode(&encoded, data.len() - 4), None);
+        assert_eq!(decode(&encoded[..encoded.len() - 1], data.len()), None);
+    }
+}
@@ -62,7 +62,7 @@ pub fn get_config_dir() -> PathBuf {
     new_dir
 }
 
-fn atomic_write(path: &Path, data: &str) -> io::Result<()> {
+pub(crate) fn atomic_write(path: &Path, data: &str) -> io::Result<()> {
     use atomicwrites::{AllowOverwrite, AtomicFile};
     let af = AtomicFile::new(path, AllowOverwrite);
     af.write(|f| f.write_all(data.as_bytes()))
@@ -266,6 +266,22 @@ mod tests {
         assert_eq!(deserialized.cache_size, settings.cache_size);
     }
 
+    #[test]
+    fn test_app_settings_missing_fields_use_defaults() {
+        let deserialized: AppSettings =
+            serde_json::from_str(r#"{"theme":"Dark","auto_save":false}"#).unwrap();
+        assert_eq!(deserialized.theme, AppTheme::Dark);
+        assert!(!deserialized.auto_save);
+        assert!(deserialized.persist_text_index);
+        assert!(deserialized.progressive_render);
+        assert_eq!(deserialized.disk_cache_mb, 256);
+        assert_eq!(deserialized.heavy_jobs, 1);
+        assert_eq!(
+            deserialized.render_backend,
+            crate::pdf_engine::RasterBackend::Cpu
+        );
+    }
+
     #[test]
     fn test_recent_file_serialization() {
         let file = RecentFile {
@@ -0,0 +1,431 @@
+use crate::models::{SearchResultItem, TextItem};
+use serde::{Deserialize, Serialize};
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, RwLock};
+
+/// Bumped whenever the on-disk layout of `StoredIndex` changes.
+const INDEX_VERSION: u32 = 2;
+/// Saved indexes kept on disk; the least recently used go first past it.
+const INDEX_DIR_MAX_BYTES: u64 = 256 * 1024 * 1024;
+const INDEX_EXTENSION: &str = "json";
+
+/// One text run from the content stream, in PDF (y-up) page space.
+#[derive(Debug, Clone, Serialize, Deserialize, PartialEq)]
+pub struct IndexedSpan {
+    pub text: String,
+    pub x: f32,
+    pub y: f32,
+    pub width: f32,
+    pub size: f32,
+}
+
+impl From<&zpdf::TextSpan> for IndexedSpan {
+    fn from(span: &zpdf::TextSpan) -> Self {
+        Self {
+            text: span.text.clone(),
+            x: span.x as f32,
+            y: span.y as f32,
+            width: span.advance.abs() as f32,
+            size: span.size,
+        }
+    }
+}
+
+/// Everything search and text extraction need from one page, so the content
+/// stream only has to be interpreted once per document.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct PageText {
+    pub page_height: f32,
+    pub spans: Vec<IndexedSpan>,
+    /// Reading-order text, as returned by `extract_text`.
+    pub plain: String,
+    /// Span texts concatenated; `offsets[i]` is the byte range of span `i`.
+    /// Derived from `spans`, so not saved; `TextIndex::load` rebuilds them.
+    #[serde(skip)]
+    joined: String,
+    #[serde(skip)]
+    folded: String,
+    #[serde(skip)]
+    offsets: Vec<(usize, usize)>,
+}
+
+impl PageText {
+    pub fn new(page_height: f32, spans: Vec<IndexedSpan>, plain: String) -> Self {
+        let mut joined = String::new();
+        let mut offsets = Vec::with_capacity(spans.len());
+        for span in &spans {
+            let start = joined.len();
+            joined.push_str(&span.text);
+            offsets.push((start, joined.len()));
+        }
+        let folded = joined.to_lowercase();
+        Self {
+            page_height,
+            spans,
+            plain,
+            joined,
+            folded,
+            offsets,
+        }
+    }
+
+    /// Non-blank spans in y-down layout space.
+    pub fn text_items(&self) -> Vec<TextItem> {
+        self.spans
+            .iter()
+            .filter(|span| !span.text.trim().is_empty())
+            .map(|span| TextItem {
+                text: span.text.clone(),
+                x: span.x,
+                y: self.page_height - span.y,
+                width: span.width,
+                height: span.size,
+            })
+            .collect()
+    }
+
+    /// Case-insensitive matches of `query_lower`, which must already be lowercased.
+    pub fn find(&self, page_index: usize, query_lower: &str) -> Vec<SearchResultItem> {
+        let mut results = Vec::new();
+        if query_lower.is_empty() || !self.folded.contains(query_lower) {
+            return results;
+        }
+
+        // Lowercasing can change byte lengths, so matches are mapped back to
+        // the original text by character index.
+        let char_boundaries: Vec<usize> = self
+            .joined
+            .char_indices()
+            .map(|(idx, _)| idx)
+            .chain(std::iter::once(self.joined.len()))
+            .collect();
+        let char_boundaries_lower: Vec<usize> = self
+            .folded
+            .char_indices()
+            .map(|(idx, _)| idx)
+            .chain(std::iter::once(self.folded.len()))
+            .collect();
+
+        let mut search_idx = 0;
+        while let Some(pos) = self.folded[search_idx..].find(query_lower) {
+            let match_start = search_idx + pos;
+            let match_end = match_start + query_lower.len();
+
+            let char_start = char_boundaries_lower
+                .binary_search(&match_start)
+                .unwrap_or_else(|x| x);
+            let char_end = char_boundaries_lower
+                .binary_search(&match_end)
+                .unwrap_or_else(|x| x);
+
+            let orig_start = char_boundaries
+                .get(char_start)
+                .copied()
+                .unwrap_or(self.joined.len());
+            let orig_end = char_boundaries
+                .get(char_end)
+                .copied()
+                .unwrap_or(self.joined.len());
+
+            let span_idx = self.offsets.partition_point(|(_, end)| *end <= orig_start);
+            if let Some(&(start, end)) = self.offsets.get(span_idx)
+                && orig_start >= start
+                && orig_start < end
+            {
+                let span = &self.spans[span_idx];
+                results.push(SearchResultItem {
+                    page_index,
+                    text: self.joined[orig_start..orig_end].to_string(),
+                    y: self.page_height - span.y - span.size,
+                    x: span.x,
+                    width: span.width,
+                    height: span.size,
+                });
+            }
+
+            search_idx = char_boundaries_lower
+                .get(char_start + 1)
+                .copied()
+                .unwrap_or(self.folded.len());
+        }
+        results
+    }
+}
+
+/// Saved as `StoredIndex<&PageText>` straight from the shared pages, loaded
+/// as `StoredIndex<PageText>`.
+#[derive(Serialize, Deserialize)]
+struct StoredIndex<P> {
+    version: u32,
+    pages: Vec<P>,
+}
+
+/// Lazily filled per-page text for one open document.
+#[derive(Default)]
+pub struct TextIndex {
+    pages: RwLock<Vec<Option<Arc<PageText>>>>,
+}
+
+impl TextIndex {
+    pub fn with_pages(page_count: usize) -> Self {
+        Self {
+            pages: RwLock::new(vec![None; page_count]),
+        }
+    }
+
+    pub fn page(&self, page_num: usize) -> Option<Arc<PageText>> {
+        self.pages
+            .read()
+            .ok()
+            .and_then(|pages| pages.get(page_num).cloned().flatten())
+    }
+
+    pub fn insert(&self, page_num: usize, text: PageText) -> Arc<PageText> {
+        let text = Arc::new(text);
+        if let Ok(mut pages) = self.pages.write()
+            && let Some(slot) = pages.get_mut(page_num)
+        {
+            *slot = Some(text.clone());
+        }
+        text
+    }
+
+    pub fn is_complete(&self) -> bool {
+        self.pages
+            .read()
+            .is_ok_and(|pages| pages.iter().all(Option::is_some))
+    }
+
+    /// Replaces the in-memory index with one saved earlier, if it matches the page count.
+    pub fn load(&self, path: &Path) -> bool {
+        let Ok(data) = std::fs::read_to_string(path) else {
+            return false;
+        };
+        let Ok(stored) = serde_json::from_str::<StoredIndex<PageText>>(&data) else {
+            tracing::warn!("Discarding unreadable text index {:?}", path);
+            return false;
+        };
+        let Ok(mut pages) = self.pages.write() else {
+            return false;
+        };
+        if stored.version != INDEX_VERSION || stored.pages.len() != pages.len() {
+            return false;
+        }
+        *pages = stored
+            .pages
+            .into_iter()
+            .map(|p| Some(Arc::new(PageText::new(p.page_height, p.spans, p.plain))))
+            .collect();
+        // The mtime is what `trim_saved_indexes` evicts by.
+        if let Ok(file) = std::fs::File::options().write(true).open(path) {
+            let _ = file.set_modified(std::time::SystemTime::now());
+        }
+        true
+    }
+
+    /// Writes the index to `path`; does nothing until every page is indexed.
+    /// Then drops indexes saved for earlier versions of the same file and
+    /// trims the directory to `INDEX_DIR_MAX_BYTES`.
+    pub fn save(&self, path: &Path) -> std::io::Result<()> {
+        let pages: Vec<Arc<PageText>> = {
+            let Ok(pages) = self.pages.read() else {
+                return Ok(());
+            };
+            let Some(pages) = pages.iter().cloned().collect::<Option<Vec<_>>>() else {
+                return Ok(());
+            };
+            pages
+        };
+        if let Some(parent) = path.parent() {
+            std::fs::create_dir_all(parent)?;
+        }
+        let data = serde_json::to_string(&StoredIndex {
+            version: INDEX_VERSION,
+            pages: pages.iter().map(|p| &**p).collect(),
+        })
+        .map_err(std::io::Error::other)?;
+        crate::storage::atomic_write(path, &data)?;
+        trim_saved_indexes(path);
+        Ok(())
+    }
+}
+
+/// Where the saved index for `pdf_path` lives. Named by a hash of the path
+/// and the file's fingerprint, so an edited file never picks up a stale
+/// index and the one it replaces can be found and deleted. Encrypted
+/// documents have no fingerprint, so their text is never written out.
+pub fn index_path(pdf_path: &str, fingerprint: u64) -> PathBuf {
+    let path_hash = fnv1a64(pdf_path.as_bytes());
+    crate::storage::get_config_dir()
+        .join("text_index")
+        .join(format!(
+            "{path_hash:016x}-{fingerprint:016x}.{INDEX_EXTENSION}"
+        ))
+}
+
+/// Deletes the other indexes saved for the file `saved` belongs to, then the
+/// least recently used ones while the directory exceeds `INDEX_DIR_MAX_BYTES`.
+fn trim_saved_indexes(saved: &Path) {
+    let (Some(dir), Some(name)) = (saved.parent(), saved.file_name()) else {
+        return;
+    };
+    let name = name.to_string_lossy();
+    let same_file = name
+        .split_once('-')
+        .map(|(path_hash, _)| format!("{path_hash}-"));
+    let Ok(entries) = std::fs::read_dir(dir) else {
+        return;
+    };
+    let mut kept = Vec::new();
+    for entry in entries.filter_map(Result::ok) {
+        let path = entry.path();
+        if path.extension().is_none_or(|ext| ext != INDEX_EXTENSION) || path == saved {
+            continue;
+        }
+        let entry_name = entry.file_name();
+        if same_file
+            .as_deref()
+            .is_some_and(|prefix| entry_name.to_string_lossy().starts_with(prefix))
+        {
+            let _ = std::fs::remove_file(&path);
+            continue;
+        }
+        if let Ok(meta) = entry.metadata()
+            && let Ok(modified) = meta.modified()
+        {
+            kept.push((path, meta.len(), modified));
+        }
+    }
+
+    let saved_len = std::fs::metadata(saved).map_or(0, |meta| meta.len());
+    let mut total = saved_len + kept.iter().map(|e| e.1).sum::<u64>();
+    kept.sort_by_key(|e| e.2);
+    for (path, size, _) in kept {
+        if total <= INDEX_DIR_MAX_BYTES {
+            break;
+        }
+        if std::fs::remove_file(&path).is_ok() {
+            total -= size;
+        }
+    }
+}
+
+/// Hash of a file's path, size and mtime; changes whenever the file is edited.
+pub fn file_fingerprint(pdf_path: &str) -> Option<u64> {
+    let meta = std::fs::metadata(pdf_path).ok()?;
+    let mtime = meta
+        .modified()
+        .ok()?
+        .duration_since(std::time::UNIX_EPOCH)
+        .ok()?
+        .as_nanos();
+    let key = format!("{pdf_path}\0{}\0{mtime}", meta.len());
+    Some(fnv1a64(key.as_bytes()))
+}
+
+/// Stable across builds, unlike `DefaultHasher`, so saved file names stay valid.
+fn fnv1a64(bytes: &[u8]) -> u64 {
+    bytes.iter().fold(0xcbf2_9ce4_8422_2325, |hash, b| {
+        (hash ^ u64::from(*b)).wrapping_mul(0x0100_0000_01b3)
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn span(text: &str, x: f32) -> IndexedSpan {
+        IndexedSpan {
+            text: text.to_string(),
+            x,
+            y: 700.0,
+            width: 40.0,
+            size: 12.0,
+        }
+    }
+
+    fn sample_page() -> PageText {
+        PageText::new(
+            800.0,
+            vec![span("Hello ", 10.0), span("World", 60.0), span("  ", 100.0)],
+            "Hello World".to_string(),
+        )
+    }
+
+    #[test]
+    fn test_find_is_case_insensitive() {
+        let page = sample_page();
+        let hits = page.find(2, "world");
+        assert_eq!(hits.len(), 1);
+        assert_eq!(hits[0].page_index, 2);
+        assert_eq!(hits[0].text, "World");
+        assert_eq!(hits[0].x, 60.0);
+        assert_eq!(hits[0].y, 800.0 - 700.0 - 12.0);
+    }
+
+    #[test]
+    fn test_find_reports_every_occurrence() {
+        let page = PageText::new(800.0, vec![span("abcabc", 0.0)], String::new());
+        assert_eq!(page.find(0, "abc").len(), 2);
+        assert!(page.find(0, "xyz").is_empty());
+        assert!(page.find(0, "").is_empty());
+    }
+
+    #[test]
+    fn test_text_items_skip_blank_spans() {
+        let items = sample_page().text_items();
+        assert_eq!(items.len(), 2);
+        assert_eq!(items[1].text, "World");
+        assert_eq!(items[1].y, 100.0);
+    }
+
+    #[test]
+    fn test_index_save_and_load_roundtrip() {
+        let dir = std::env::temp_dir().join(format!("pdfbull_index_{}", std::process::id()));
+        let path = dir.join("index.json");
+
+        let index = TextIndex::with_pages(2);
+        index.insert(0, sample_page());
+        index.save(&path).unwrap();
+        assert!(!path.exists(), "incomplete index must not be saved");
+
+        index.insert(1, sample_page());
+        assert!(index.is_complete());
+        index.save(&path).unwrap();
+
+        let loaded = TextIndex::with_pages(2);
+        assert!(loaded.load(&path));
+        assert_eq!(loaded.page(1).unwrap().plain, "Hello World");
+        assert_eq!(loaded.page(1).unwrap().find(1, "world").len(), 1);
+        assert!(!TextIndex::with_pages(3).load(&path));
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_save_replaces_index_of_earlier_file_version() {
+        let dir = std::env::temp_dir().join(format!("pdfbull_index_trim_{}", std::process::id()));
+        let old = dir.join("00000000000000aa-0000000000000001.json");
+        let other = dir.join("00000000000000bb-0000000000000001.json");
+        std::fs::create_dir_all(&dir).unwrap();
+        std::fs::write(&old, "{}").unwrap();
+        std::fs::write(&other, "{}").unwrap();
+
+        let index = TextIndex::with_pages(1);
+        index.insert(0, sample_page());
+        let new = dir.join("00000000000000aa-0000000000000002.json");
+        index.save(&new).unwrap();
+
+        assert!(new.exists());
+        assert!(!old.exists(), "the edited file's old index is deleted");
+        assert!(other.exists(), "other files' indexes are kept");
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn test_fnv1a64_is_stable() {
+        assert_eq!(fnv1a64(b""), 0xcbf2_9ce4_8422_2325);
+        assert_eq!(fnv1a64(b"a"), 0xaf63_dc4c_8601_ec8c);
+    }
+}
@@ -8,6 +8,7 @@ use crate::app::{INTER_BOLD, INTER_REGULAR};
 use crate::ui_document::document_view;
 use crate::ui_keyboard_help::keyboard_help_view;
 use crate::ui_metadata::metadata_view;
+use crate::ui_metrics::metrics_overlay_view;
 use crate::ui_settings::settings_view;
 use crate::ui_welcome::welcome_view;
 use iced::widget::{
@@ -777,5 +778,9 @@ pub fn view(app: &PdfBullApp) -> Element<'_, crate::message::Message> {
         base_stack = base_stack.push(signatures_detail_view(app));
     }
 
+    if app.show_metrics {
+        base_stack = base_stack.push(metrics_overlay_view(app));
+    }
+
     base_stack.into()
 }
@@ -1,18 +1,26 @@
 use crate::app::PdfBullApp;
 use crate::app::{INTER_BOLD, INTER_REGULAR, LUCIDE, icons};
 use crate::models::{AnnotationStyle, DocumentTab, PendingAnnotationKind};
+use crate::overlay_cache::{self, PageLayers};
 use crate::ui::theme::{self, hex_to_rgb};
 use iced::widget::{
     Space, Stack, button, canvas, column, container, mouse_area, row, scrollable, text,
 };
 use iced::{Alignment, Border, Color, Element, Length, Padding, Rectangle, Shadow, Vector};
+use std::hash::{DefaultHasher, Hash};
+use std::rc::Rc;
 
 use crate::ui::{sidebar, tabs, toolbar};
 
+/// The page's canvas overlays. The text layer, selection and search
+/// highlights and line/arrow annotations are drawn from the page's retained
+/// layers; only the line or arrow being dragged out is drawn afresh.
 struct AnnotationCanvas<'a> {
     page_idx: usize,
     active: bool,
-    annotations: &'a [crate::models::Annotation],
+    tab: &'a DocumentTab,
+    layers: Rc<PageLayers>,
+    search_active: bool,
     zoom: f32,
     drag: Option<crate::models::AnnotationDrag>,
     rotation: i32,
@@ -20,7 +28,143 @@ struct AnnotationCanvas<'a> {
     page_height: f32,
 }
 
-impl<'a> canvas::Program<crate::message::Message> for AnnotationCanvas<'a> {
+impl AnnotationCanvas<'_> {
+    /// `(x, y, width, height)` in page space, rotated and scaled to the canvas.
+    fn place(&self, x: f32, y: f32, width: f32, height: f32) -> (iced::Point, iced::Size) {
+        let (rx, ry, rw, rh) = crate::models::rotate_coords(
+            x,
+            y,
+            width,
+            height,
+            self.page_width,
+            self.page_height,
+            self.rotation,
+        );
+        (
+            iced::Point::new(rx * self.zoom, ry * self.zoom),
+            iced::Size::new(rw * self.zoom, rh * self.zoom),
+        )
+    }
+
+    /// What every layer's placement depends on.
+    fn hash_geometry(&self, hasher: &mut DefaultHasher) {
+        self.zoom.to_bits().hash(hasher);
+        self.rotation.hash(hasher);
+        self.page_width.to_bits().hash(hasher);
+        self.page_height.to_bits().hash(hasher);
+    }
+
+    fn draw_text_layer(&self, renderer: &iced::Renderer, size: iced::Size) -> canvas::Geometry {
+        let items = self
+            .tab
+            .view_state
+            .text_layers
+            .get(&self.page_idx)
+            .map_or(&[][..], Vec::as_slice);
+        let stamp = overlay_cache::stamp(|h| {
+            self.hash_geometry(h);
+            for item in items {
+                item.text.hash(h);
+                hash_floats(h, &[item.x, item.y, item.width, item.height]);
+            }
+        });
+        self.layers.text.draw(renderer, size, stamp, |frame| {
+            for item in items {
+                let (position, _) = self.place(item.x, item.y, item.width, item.height);
+                frame.fill_text(canvas::Text {
+                    content: item.text.clone(),
+                    position,
+                    size: (item.height * self.zoom).into(),
+                    color: Color::TRANSPARENT,
+                    ..canvas::Text::default()
+                });
+            }
+        })
+    }
+
+    fn draw_highlights(&self, renderer: &iced::Renderer, size: iced::Size) -> canvas::Geometry {
+        let tab = self.tab;
+        let hits: Vec<(bool, &crate::models::SearchResult)> = if self.search_active {
+            tab.search_results
+                .iter()
+                .enumerate()
+                .filter(|(_, result)| result.page == self.page_idx)
+                .map(|(idx, result)| (idx == tab.current_search_index, result))
+                .collect()
+        } else {
+            Vec::new()
+        };
+        let stamp = overlay_cache::stamp(|h| {
+            self.hash_geometry(h);
+            for &(bx, by, bw, bh) in &tab.selected_boxes {
+                hash_floats(h, &[bx, by, bw, bh]);
+            }
+            for (is_active, result) in &hits {
+                is_active.hash(h);
+                hash_floats(
+                    h,
+                    &[result.x, result.y_position, result.width, result.height],
+                );
+            }
+        });
+        self.layers.highlights.draw(renderer, size, stamp, |frame| {
+            for &(bx, by, bw, bh) in &tab.selected_boxes {
+                let (top_left, size) = self.place(bx, by, bw, bh);
+                frame.fill_rectangle(top_left, size, Color::from_rgba(0.0, 0.4, 1.0, 0.25));
+            }
+            for (is_active, result) in &hits {
+                let highlight_color = if *is_active {
+                    Color::from_rgba(1.0, 0.6, 0.0, 0.6)
+                } else {
+                    Color::from_rgba(1.0, 1.0, 0.0, 0.4)
+                };
+                let (top_left, size) =
+                    self.place(result.x, result.y_position, result.width, result.height);
+                frame.fill_rectangle(top_left, size, highlight_color);
+            }
+        })
+    }
+
+    fn draw_shapes(&self, renderer: &iced::Renderer, size: iced::Size) -> canvas::Geometry {
+        let shapes: Vec<_> = self
+            .tab
+            .annotations
+            .iter()
+            .filter(|ann| ann.page == self.page_idx)
+            .filter_map(|ann| match &ann.style {
+                AnnotationStyle::Line { color, thickness } => Some((ann, false, color, *thickness)),
+                AnnotationStyle::Arrow { color, thickness } => Some((ann, true, color, *thickness)),
+                _ => None,
+            })
+            .collect();
+        let stamp = overlay_cache::stamp(|h| {
+            self.hash_geometry(h);
+            for (ann, is_arrow, color, thickness) in &shapes {
+                is_arrow.hash(h);
+                color.hash(h);
+                hash_floats(h, &[ann.x, ann.y, ann.width, ann.height, *thickness]);
+            }
+        });
+        self.layers.shapes.draw(renderer, size, stamp, |frame| {
+            for (ann, is_arrow, color, thickness) in &shapes {
+                let (r, g, b) = hex_to_rgb(color);
+                let (start, _) = self.place(ann.x, ann.y, 0.0, 0.0);
+                let (end, _) = self.place(ann.x + ann.width, ann.y + ann.height, 0.0, 0.0);
+                let wing_len = is_arrow.then_some((10.0 + thickness * 2.0) * self.zoom);
+                stroke_line(
+                    frame,
+                    start,
+                    end,
+                    Color::from_rgb(r, g, b),
+                    thickness * self.zoom,
+                    wing_len,
+                );
+            }
+        })
+    }
+}
+
+impl canvas::Program<crate::message::Message> for AnnotationCanvas<'_> {
     type State = ();
 
     fn update(
@@ -69,7 +213,6 @@ impl<'a> canvas::Program<crate::message::Message> for AnnotationCanvas<'a> {
         }
     }
 
-    #[allow(clippy::suboptimal_flops)]
     fn draw(
         &self,
         _state: &Self::State,
@@ -78,193 +221,88 @@ impl<'a> canvas::Program<crate::message::Message> for AnnotationCanvas<'a> {
         bounds: Rectangle,
         _cursor: iced::mouse::Cursor,
     ) -> Vec<canvas::Geometry> {
-        let mut frame = canvas::Frame::new(renderer, bounds.size());
-
-        // 1. Draw existing Line & Arrow annotations for this page
-        for ann in self.annotations.iter().filter(|a| a.page == self.page_idx) {
-            match &ann.style {
-                AnnotationStyle::Line { color, thickness } => {
-                    let (r, g, b) = hex_to_rgb(color);
-                    let stroke_color = Color::from_rgb(r, g, b);
-                    let (rx1, ry1, _, _) = crate::models::rotate_coords(
-                        ann.x,
-                        ann.y,
-                        0.0,
-                        0.0,
-                        self.page_width,
-                        self.page_height,
-                        self.rotation,
-                    );
-                    let (rx2, ry2, _, _) = crate::models::rotate_coords(
-                        ann.x + ann.width,
-                        ann.y + ann.height,
-                        0.0,
-                        0.0,
-                        self.page_width,
-                        self.page_height,
-                        self.rotation,
-                    );
-                    let p1 = iced::Point::new(rx1 * self.zoom, ry1 * self.zoom);
-                    let p2 = iced::Point::new(rx2 * self.zoom, ry2 * self.zoom);
-
-                    let path = canvas::Path::new(|builder| {
-                        builder.move_to(p1);
-                        builder.line_to(p2);
-                    });
-                    frame.stroke(
-                        &path,
-                        canvas::Stroke::default()
-                            .with_color(stroke_color)
-                            .with_width(*thickness * self.zoom),
-                    );
-                }
-                AnnotationStyle::Arrow { color, thickness } => {
-                    let (r, g, b) = hex_to_rgb(color);
-                    let stroke_color = Color::from_rgb(r, g, b);
-                    let (rx1, ry1, _, _) = crate::models::rotate_coords(
-                        ann.x,
-                        ann.y,
-                        0.0,
-                        0.0,
-                        self.page_width,
-                        self.page_height,
-                        self.rotation,
-                    );
-                    let (rx2, ry2, _, _) = crate::models::rotate_coords(
-                        ann.x + ann.width,
-                        ann.y + ann.height,
-                        0.0,
-                        0.0,
-                        self.page_width,
-                        self.page_height,
-                        self.rotation,
-                    );
-                    let x1 = rx1 * self.zoom;
-                    let y1 = ry1 * self.zoom;
-                    let x2 = rx2 * self.zoom;
-                    let y2 = ry2 * self.zoom;
-
-                    // Draw shaft
-                    let path_shaft = canvas::Path::new(|builder| {
-                        builder.move_to(iced::Point::new(x1, y1));
-                        builder.line_to(iced::Point::new(x2, y2));
-                    });
-                    frame.stroke(
-                        &path_shaft,
-                        canvas::Stroke::default()
-                            .with_color(stroke_color)
-                            .with_width(*thickness * self.zoom),
-                    );
-
-                    // Draw wings
-                    let dx = x2 - x1;
-                    let dy = y2 - y1;
-                    let len = dx.hypot(dy);
-                    if len > 0.001 {
-                        let ux = dx / len;
-                        let uy = dy / len;
-                        let wing_len = (10.0 + thickness * 2.0) * self.zoom;
-                        let cos_30 = 0.866;
-                        let sin_30 = 0.500;
-
-                        let w1_x = x2 - wing_len * (ux * cos_30 + uy * sin_30);
-                        let w1_y = y2 - wing_len * (uy * cos_30 - ux * sin_30);
-
-                        let w2_x = x2 - wing_len * (ux * cos_30 - uy * sin_30);
-                        let w2_y = y2 - wing_len * (uy * cos_30 + ux * sin_30);
-
-                        let path_wings = canvas::Path::new(|builder| {
-                            builder.move_to(iced::Point::new(x2, y2));
-                            builder.line_to(iced::Point::new(w1_x, w1_y));
-                            builder.move_to(iced::Point::new(x2, y2));
-                            builder.line_to(iced::Point::new(w2_x, w2_y));
-                        });
-                        frame.stroke(
-                            &path_wings,
-                            canvas::Stroke::default()
-                                .with_color(stroke_color)
-                                .with_width(*thickness * self.zoom),
-                        );
-                    }
-                }
-                _ => {}
-            }
-        }
+        let size = bounds.size();
+        let mut layers = vec![
+            self.draw_text_layer(renderer, size),
+            self.draw_highlights(renderer, size),
+            self.draw_shapes(renderer, size),
+        ];
 
-        // 2. Draw active dragging preview if it is a Line or Arrow
+        // The line or arrow being dragged out changes with every cursor move.
         if let Some(drag) = &self.drag
             && drag.page == self.page_idx
         {
-            match drag.kind {
-                PendingAnnotationKind::Line => {
-                    let stroke_color = Color::from_rgb(1.0, 0.0, 0.0);
-                    let p1 = iced::Point::new(drag.start.0, drag.start.1);
-                    let p2 = iced::Point::new(drag.current.0, drag.current.1);
-
-                    let path = canvas::Path::new(|builder| {
-                        builder.move_to(p1);
-                        builder.line_to(p2);
-                    });
-                    frame.stroke(
-                        &path,
-                        canvas::Stroke::default()
-                            .with_color(stroke_color)
-                            .with_width(2.0 * self.zoom),
-                    );
-                }
-                PendingAnnotationKind::Arrow => {
-                    let stroke_color = Color::from_rgb(1.0, 0.0, 0.0);
-                    let x1 = drag.start.0;
-                    let y1 = drag.start.1;
-                    let x2 = drag.current.0;
-                    let y2 = drag.current.1;
-
-                    let path_shaft = canvas::Path::new(|builder| {
-                        builder.move_to(iced::Point::new(x1, y1));
-                        builder.line_to(iced::Point::new(x2, y2));
-                    });
-                    frame.stroke(
-                        &path_shaft,
-                        canvas::Stroke::default()
-                            .with_color(stroke_color)
-                            .with_width(2.0 * self.zoom),
-                    );
-
-                    let dx = x2 - x1;
-                    let dy = y2 - y1;
-                    let len = dx.hypot(dy);
-                    if len > 0.001 {
-                        let ux = dx / len;
-                        let uy = dy / len;
-                        let wing_len = 14.0 * self.zoom;
-                        let cos_30 = 0.866;
-                        let sin_30 = 0.500;
-
-                        let w1_x = x2 - wing_len * (ux * cos_30 + uy * sin_30);
-                        let w1_y = y2 - wing_len * (uy * cos_30 - ux * sin_30);
-
-                        let w2_x = x2 - wing_len * (ux * cos_30 - uy * sin_30);
-                        let w2_y = y2 - wing_len * (uy * cos_30 + ux * sin_30);
-
-                        let path_wings = canvas::Path::new(|builder| {
-                            builder.move_to(iced::Point::new(x2, y2));
-                            builder.line_to(iced::Point::new(w1_x, w1_y));
-                            builder.move_to(iced::Point::new(x2, y2));
-                            builder.line_to(iced::Point::new(w2_x, w2_y));
-                        });
-                        frame.stroke(
-                            &path_wings,
-                            canvas::Stroke::default()
-                                .with_color(stroke_color)
-                                .with_width(2.0 * self.zoom),
-                        );
-                    }
-                }
-                _ => {}
-            }
+            let wing_len = match drag.kind {
+                PendingAnnotationKind::Line => None,
+                PendingAnnotationKind::Arrow => Some(14.0 * self.zoom),
+                _ => return layers,
+            };
+            let mut frame = canvas::Frame::new(renderer, size);
+            stroke_line(
+                &mut frame,
+                iced::Point::new(drag.start.0, drag.start.1),
+                iced::Point::new(drag.current.0, drag.current.1),
+                Color::from_rgb(1.0, 0.0, 0.0),
+                2.0 * self.zoom,
+                wing_len,
+            );
+            layers.push(frame.into_geometry());
         }
 
-        vec![frame.into_geometry()]
+        layers
+    }
+}
+
+fn hash_floats(hasher: &mut DefaultHasher, values: &[f32]) {
+    for value in values {
+        value.to_bits().hash(hasher);
+    }
+}
+
+/// A line from `start` to `end`, with arrowhead wings of `wing_len` at `end`.
+#[allow(clippy::suboptimal_flops)]
+fn stroke_line(
+    frame: &mut canvas::Frame,
+    start: iced::Point,
+    end: iced::Point,
+    color: Color,
+    width: f32,
+    wing_len: Option<f32>,
+) {
+    let stroke = || {
+        canvas::Stroke::default()
+            .with_color(color)
+            .with_width(width)
+    };
+    let shaft = canvas::Path::line(start, end);
+    frame.stroke(&shaft, stroke());
+
+    let Some(wing_len) = wing_len else {
+        return;
+    };
+    let (x1, y1, x2, y2) = (start.x, start.y, end.x, end.y);
+    let dx = x2 - x1;
+    let dy = y2 - y1;
+    let len = dx.hypot(dy);
+    if len > 0.001 {
+        let ux = dx / len;
+        let uy = dy / len;
+        let cos_30 = 0.866;
+        let sin_30 = 0.500;
+
+        let w1_x = x2 - wing_len * (ux * cos_30 + uy * sin_30);
+        let w1_y = y2 - wing_len * (uy * cos_30 - ux * sin_30);
+
+        let w2_x = x2 - wing_len * (ux * cos_30 - uy * sin_30);
+        let w2_y = y2 - wing_len * (uy * cos_30 + ux * sin_30);
+
+        let wings = canvas::Path::new(|builder| {
+            builder.move_to(end);
+            builder.line_to(iced::Point::new(w1_x, w1_y));
+            builder.move_to(end);
+            builder.line_to(iced::Point::new(w2_x, w2_y));
+        });
+        frame.stroke(&wings, stroke());
     }
 }
 
@@ -516,65 +554,8 @@ fn render_hyperlinks<'a>(
         .collect()
 }
 
-fn render_search_highlights<'a>(
-    page_idx: usize,
-    tab: &'a DocumentTab,
-    zoom: f32,
-    app: &'a PdfBullApp,
-) -> Vec<Element<'a, crate::message::Message>> {
-    if app.search_query.is_empty() {
-        return vec![];
-    }
-
-    tab.search_results
-        .iter()
-        .enumerate()
-        .filter(|(_, result)| result.page == page_idx)
-        .map(|(result_idx, result)| {
-            let is_active = result_idx == tab.current_search_index;
-            let highlight_color = if is_active {
-                Color::from_rgba(1.0, 0.6, 0.0, 0.6)
-            } else {
-                Color::from_rgba(1.0, 1.0, 0.0, 0.4)
-            };
-
-            let actual_page = tab.page_mapping.get(page_idx).copied().unwrap_or(page_idx);
-            let page_rotation = tab
-                .page_rotations
-                .get(&actual_page)
-                .copied()
-                .unwrap_or(tab.rotation);
-            let original_height = tab.page_heights.get(page_idx).copied().unwrap_or(800.0);
-
-            let (rx, ry, rw, rh) = crate::models::rotate_coords(
-                result.x,
-                result.y_position,
-                result.width,
-                result.height,
-                tab.page_width,
-                original_height,
-                page_rotation,
-            );
-
-            container(
-                Space::new()
-                    .width(Length::Fixed(rw * zoom))
-                    .height(Length::Fixed(rh * zoom)),
-            )
-            .style(move |_| iced::widget::container::Style {
-                background: Some(iced::Background::Color(highlight_color)),
-                ..Default::default()
-            })
-            .padding(Padding {
-                top: ry * zoom,
-                left: rx * zoom,
-                ..Default::default()
-            })
-            .into()
-        })
-        .collect()
-}
-
+/// The box being dragged out to select text; selected words are drawn by
+/// the page's highlight layer.
 fn render_selection_overlay<'a>(
     page_idx: usize,
     tab: &'a DocumentTab,
@@ -582,7 +563,6 @@ fn render_selection_overlay<'a>(
 ) -> Vec<Element<'a, crate::message::Message>> {
     let mut overlays = Vec::new();
 
-    // 1. Draw the active selection drag blue box
     if let Some((drag_page, start, current)) = tab.selection_drag {
         if drag_page == page_idx {
             let x = start.0.min(current.0);
@@ -613,43 +593,6 @@ fn render_selection_overlay<'a>(
         }
     }
 
-    // 2. Draw permanent selection highlight boxes for selected words
-    for &(bx, by, bw, bh) in &tab.selected_boxes {
-        let actual_page = tab.page_mapping.get(page_idx).copied().unwrap_or(page_idx);
-        let page_rotation = tab
-            .page_rotations
-            .get(&actual_page)
-            .copied()
-            .unwrap_or(tab.rotation);
-        let original_height = tab.page_heights.get(page_idx).copied().unwrap_or(800.0);
-
-        let (rx, ry, rw, rh) = crate::models::rotate_coords(
-            bx,
-            by,
-            bw,
-            bh,
-            tab.page_width,
-            original_height,
-            page_rotation,
-        );
-
-        overlays.push(
-            container(Space::new())
-                .width(Length::Fixed(rw * zoom))
-                .height(Length::Fixed(rh * zoom))
-                .style(move |_| iced::widget::container::Style {
-                    background: Some(Color::from_rgba(0.0, 0.4, 1.0, 0.25).into()),
-                    ..Default::default()
-                })
-                .padding(Padding {
-                    top: ry * zoom,
-                    left: rx * zoom,
-                    ..Default::default()
-                })
-                .into(),
-        );
-    }
-
     overlays
 }
 
@@ -720,54 +663,6 @@ fn render_active_drag<'a>(
     vec![]
 }
 
-fn render_accessibility_layer<'a>(
-    page_idx: usize,
-    tab: &'a DocumentTab,
-    zoom: f32,
-) -> Vec<Element<'a, crate::message::Message>> {
-    tab.view_state
-        .text_layers
-        .get(&page_idx)
-        .map(|items| {
-            let actual_page = tab.page_mapping.get(page_idx).copied().unwrap_or(page_idx);
-            let page_rotation = tab
-                .page_rotations
-                .get(&actual_page)
-                .copied()
-                .unwrap_or(tab.rotation);
-            let original_height = tab.page_heights.get(page_idx).copied().unwrap_or(800.0);
-
-            items
-                .iter()
-                .map(|item| {
-                    let (rx, ry, rw, rh) = crate::models::rotate_coords(
-                        item.x,
-                        item.y,
-                        item.width,
-                        item.height,
-                        tab.page_width,
-                        original_height,
-                        page_rotation,
-                    );
-                    container(text(item.text.clone()).size(item.height * zoom).style(|_| {
-                        iced::widget::text::Style {
-                            color: Some(Color::TRANSPARENT),
-                        }
-                    }))
-                    .width(Length::Fixed((rx + rw) * zoom))
-                    .height(Length::Fixed((ry + rh) * zoom))
-                    .padding(Padding {
-                        top: ry * zoom,
-                        left: rx * zoom,
-                        ..Default::default()
-                    })
-                    .into()
-                })
-                .collect()
-        })
-        .unwrap_or_default()
-}
-
 fn render_table_overlays<'a>(
     page_idx: usize,
     tab: &'a DocumentTab,
@@ -874,6 +769,28 @@ fn render_table_overlays<'a>(
         .unwrap_or_default()
 }
 
+/// Tiles of a page rendered at the current zoom, each placed at its pixel offset.
+fn render_page_tiles<'a>(
+    page_idx: usize,
+    tab: &'a DocumentTab,
+) -> Vec<Element<'a, crate::message::Message>> {
+    let tile_size = crate::pdf_engine::TILE_SIZE as f32;
+    tab.view_state
+        .rendered_tiles
+        .iter()
+        .filter(|((page, _, _), (scale, _))| *page == page_idx && (scale - tab.zoom).abs() < 0.001)
+        .map(|(&(_, col, row), (_, handle))| {
+            container(iced::widget::Image::new(handle.clone()))
+                .padding(Padding {
+                    top: row as f32 * tile_size,
+                    left: col as f32 * tile_size,
+                    ..Default::default()
+                })
+                .into()
+        })
+        .collect()
+}
+
 fn render_page_canvas<'a>(
     page_idx: usize,
     tab: &'a DocumentTab,
@@ -887,30 +804,39 @@ fn render_page_canvas<'a>(
         .copied()
         .unwrap_or(tab.rotation);
     let original_height = tab.page_heights.get(page_idx).copied().unwrap_or(800.0);
-    let is_landscape = page_rotation % 180 != 0;
+    let (original_width, original_height_layout) = tab.page_size(page_idx);
+    let scaled_height = original_height_layout * zoom;
+    let scaled_width = original_width * zoom;
 
-    let (original_width, original_height_layout) = if is_landscape {
-        (original_height, tab.page_width)
+    let page_image = tab
+        .view_state
+        .rendered_pages
+        .get(&page_idx)
+        .map(|(_, handle)| {
+            iced::widget::Image::new(handle.clone())
+                .width(Length::Fixed(scaled_width))
+                .height(Length::Fixed(scaled_height))
+        });
+    let tiles = if tab.uses_tiles(page_idx) {
+        render_page_tiles(page_idx, tab)
     } else {
-        (tab.page_width, original_height)
+        Vec::new()
     };
-    let scaled_height = original_height_layout * zoom;
-    let scaled_width = original_width * zoom;
 
-    if let Some((_, handle)) = tab.view_state.rendered_pages.get(&page_idx) {
-        let img = iced::widget::Image::new(handle.clone())
+    if page_image.is_some() || !tiles.is_empty() {
+        // A whole-page bitmap from an earlier zoom stays underneath as a
+        // stretched preview until the tiles covering it arrive.
+        let mut page_stack = Stack::new()
             .width(Length::Fixed(scaled_width))
             .height(Length::Fixed(scaled_height));
-
-        let mut page_stack = Stack::new().push(img);
-
-        for el in render_accessibility_layer(page_idx, tab, zoom) {
-            page_stack = page_stack.push(el);
+        if let Some(img) = page_image {
+            page_stack = page_stack.push(img);
         }
-        for el in render_selection_overlay(page_idx, tab, zoom) {
+        for el in tiles {
             page_stack = page_stack.push(el);
         }
-        for el in render_search_highlights(page_idx, tab, zoom, app) {
+
+        for el in render_selection_overlay(page_idx, tab, zoom) {
             page_stack = page_stack.push(el);
         }
 
@@ -919,7 +845,9 @@ fn render_page_canvas<'a>(
             canvas(AnnotationCanvas {
                 page_idx,
                 active: true,
-                annotations: &tab.annotations,
+                tab,
+                layers: tab.view_state.overlays.page(page_idx),
+                search_active: !app.search_query.is_empty(),
                 zoom,
                 drag: app.annotation_drag.clone(),
                 rotation: page_rotation,
@@ -993,13 +921,7 @@ fn render_pdf_content(app: &PdfBullApp) -> Element<'_, crate::message::Message>
     let (start_idx, end_idx) = tab.view_state.visible_range;
 
     if start_idx > 0 {
-        let y_above: f32 = tab
-            .page_heights
-            .iter()
-            .take(start_idx)
-            .map(|h| (h + theme::PAGE_SPACING) * zoom)
-            .sum();
-        let y_above = (y_above - scaled_spacing).max(0.0);
+        let y_above = (tab.page_offset(start_idx) - scaled_spacing).max(0.0);
         if y_above > 0.0 {
             pdf_column = pdf_column.push(Space::new().height(y_above));
         }
@@ -1010,12 +932,7 @@ fn render_pdf_content(app: &PdfBullApp) -> Element<'_, crate::message::Message>
     }
 
     if end_idx < tab.total_pages {
-        let y_below: f32 = tab
-            .page_heights
-            .iter()
-            .skip(end_idx)
-            .map(|h| (h + theme::PAGE_SPACING) * zoom)
-            .sum();
+        let y_below = tab.page_offset(tab.layout.len()) - tab.page_offset(end_idx);
         let y_below = (y_below - scaled_spacing).max(0.0);
         if y_below > 0.0 {
             pdf_column = pdf_column.push(Space::new().height(y_below));
@@ -1035,7 +952,9 @@ fn render_pdf_content(app: &PdfBullApp) -> Element<'_, crate::message::Message>
     })
     .on_scroll(|viewport| {
         crate::message::Message::ViewportChanged(
+            viewport.absolute_offset().x,
             viewport.absolute_offset().y,
+            viewport.bounds().width,
             viewport.bounds().height,
         )
     })
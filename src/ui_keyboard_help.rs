@@ -27,6 +27,7 @@ pub fn keyboard_help_view(_app: &crate::app::PdfBullApp) -> Element<'_, crate::m
                 ("Ctrl + +", "Zoom In"),
                 ("Ctrl + -", "Zoom Out"),
                 ("F11", "Toggle Fullscreen"),
+                ("F12", "Engine Stats"),
             ]
         ),
         shortcut_section(
@@ -0,0 +1,111 @@
+use crate::app::{INTER_BOLD, INTER_REGULAR, PdfBullApp};
+use crate::message::Message;
+use crate::metrics::{LatencySummary, MetricsSnapshot};
+use iced::widget::{Space, button, column, container, row, text};
+use iced::{Alignment, Color, Element, Length};
+
+/// Engine stats in a corner panel over the document, refreshed every second
+/// while shown. Toggled with F12.
+pub fn metrics_overlay_view(app: &PdfBullApp) -> Element<'_, Message> {
+    let header = row![
+        text("Engine Stats").size(15).font(INTER_BOLD),
+        Space::new().width(Length::Fill),
+        button(text("Save JSON").size(12).font(INTER_REGULAR))
+            .on_press(Message::DumpMetrics)
+            .padding([4, 8])
+            .style(iced::widget::button::text),
+        button(text("Close").size(12).font(INTER_REGULAR))
+            .on_press(Message::ToggleMetricsOverlay)
+            .padding([4, 8])
+            .style(iced::widget::button::text),
+    ]
+    .align_y(Alignment::Center);
+
+    let body: Element<'_, Message> = match &app.metrics {
+        Some(snapshot) => stats_lines(app, snapshot),
+        None => stat_line("Collecting…".to_string()),
+    };
+
+    let panel = container(column![header, body].spacing(8))
+        .width(Length::Fixed(340.0))
+        .padding(14)
+        .style(|_| iced::widget::container::Style {
+            background: Some(Color::from_rgba8(20, 22, 26, 0.88).into()),
+            border: iced::Border {
+                radius: 10.0.into(),
+                width: 1.0,
+                color: Color::from_rgb8(60, 60, 65),
+            },
+            ..Default::default()
+        });
+
+    container(panel)
+        .width(Length::Fill)
+        .height(Length::Fill)
+        .align_right(Length::Fill)
+        .align_bottom(Length::Fill)
+        .padding(16)
+        .into()
+}
+
+fn stats_lines<'a>(app: &PdfBullApp, snapshot: &MetricsSnapshot) -> Element<'a, Message> {
+    let mut lines = vec![
+        format!(
+            "Queued: {} interactive, {} heavy",
+            snapshot.interactive_queue, snapshot.heavy_queue
+        ),
+        format!(
+            "Cache: {:.0}% hits ({} hits, {} from compressed, {} misses, {} evicted)",
+            snapshot.hit_rate(),
+            snapshot.cache_hits,
+            snapshot.compressed_hits,
+            snapshot.cache_misses,
+            snapshot.cache_evictions
+        ),
+        format!(
+            "Cache memory: {} raw, {} compressed",
+            megabytes(snapshot.cache_bytes),
+            megabytes(snapshot.compressed_bytes)
+        ),
+        latency("Render", &snapshot.render),
+        latency("Interpret", &snapshot.interpret),
+        latency("Rasterize", &snapshot.rasterize),
+    ];
+    for tab in &app.tabs {
+        if let Some(&bytes) = snapshot.document_bytes.get(&tab.id.0) {
+            let name = tab.path.file_name().unwrap_or_default().to_string_lossy();
+            lines.push(format!("{name}: {}", megabytes(bytes)));
+        }
+    }
+    let mut slowest: Vec<_> = snapshot.commands.iter().collect();
+    slowest.sort_by(|a, b| b.1.p95_ms.total_cmp(&a.1.p95_ms));
+    lines.extend(
+        slowest
+            .into_iter()
+            .take(5)
+            .map(|(name, summary)| latency(name, summary)),
+    );
+
+    column(lines.into_iter().map(stat_line)).spacing(4).into()
+}
+
+fn stat_line<'a>(line: String) -> Element<'a, Message> {
+    text(line)
+        .size(12)
+        .font(INTER_REGULAR)
+        .style(|_| iced::widget::text::Style {
+            color: Some(Color::from_rgb8(210, 210, 215)),
+        })
+        .into()
+}
+
+fn latency(label: &str, summary: &LatencySummary) -> String {
+    format!(
+        "{label}: {} × p50 {:.1} ms, p95 {:.1} ms, max {:.1} ms",
+        summary.count, summary.p50_ms, summary.p95_ms, summary.max_ms
+    )
+}
+
+fn megabytes(bytes: u64) -> String {
+    format!("{:.1} MB", bytes as f64 / (1024.0 * 1024.0))
+}
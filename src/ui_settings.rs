@@ -1,6 +1,6 @@
 use crate::app::{INTER_BOLD, INTER_REGULAR};
 use crate::models::AppTheme;
-use crate::pdf_engine::{RenderFilter, RenderQuality};
+use crate::pdf_engine::{RasterBackend, RenderFilter, RenderQuality};
 use iced::widget::{Space, button, column, container, image, row, scrollable, text};
 use iced::{Alignment, Border, Color, Element, Length, Shadow, Vector};
 
@@ -139,6 +139,16 @@ pub fn settings_view(app: &crate::app::PdfBullApp) -> Element<'_, crate::message
             s.restore_session = !s.restore_session;
             crate::message::Message::SaveSettings(s)
         }),
+        setting_btn("Save Search Index", app.settings.persist_text_index, {
+            let mut s = app.settings.clone();
+            s.persist_text_index = !s.persist_text_index;
+            crate::message::Message::SaveSettings(s)
+        }),
+        setting_btn("Progressive Rendering", app.settings.progressive_render, {
+            let mut s = app.settings.clone();
+            s.progressive_render = !s.progressive_render;
+            crate::message::Message::SaveSettings(s)
+        }),
     ]
     .spacing(10);
 
@@ -169,6 +179,28 @@ pub fn settings_view(app: &crate::app::PdfBullApp) -> Element<'_, crate::message
     ]
     .spacing(10);
 
+    let backend_buttons = row![
+        setting_btn(
+            "CPU Rendering",
+            app.settings.render_backend == RasterBackend::Cpu,
+            {
+                let mut s = app.settings.clone();
+                s.render_backend = RasterBackend::Cpu;
+                crate::message::Message::SaveSettings(s)
+            }
+        ),
+        setting_btn(
+            "GPU Rendering",
+            app.settings.render_backend == RasterBackend::Gpu,
+            {
+                let mut s = app.settings.clone();
+                s.render_backend = RasterBackend::Gpu;
+                crate::message::Message::SaveSettings(s)
+            }
+        ),
+    ]
+    .spacing(10);
+
     let filter_buttons = row![
         setting_btn("None", app.settings.default_filter == RenderFilter::None, {
             let mut s = app.settings.clone();
@@ -253,6 +285,225 @@ pub fn settings_view(app: &crate::app::PdfBullApp) -> Element<'_, crate::message
     ]
     .align_y(Alignment::Center);
 
+    let prefetch_row = row![
+        text(if app.settings.prefetch_memory_mb == 0 {
+            "Prefetch: off".to_string()
+        } else {
+            format!("Prefetch: {} MB", app.settings.prefetch_memory_mb)
+        })
+        .font(INTER_REGULAR)
+        .style(|_theme| {
+            iced::widget::text::Style {
+                color: Some(Color::WHITE),
+            }
+        }),
+        Space::new().width(Length::Fill),
+        action_btn("-", {
+            let mut s = app.settings.clone();
+            s.prefetch_memory_mb = s.prefetch_memory_mb.saturating_sub(32);
+            crate::message::Message::SaveSettings(s)
+        }),
+        Space::new().width(10),
+        action_btn("+", {
+            let mut s = app.settings.clone();
+            s.prefetch_memory_mb = (s.prefetch_memory_mb + 32).min(512);
+            crate::message::Message::SaveSettings(s)
+        }),
+    ]
+    .align_y(Alignment::Center);
+
+    let export_level_row = row![
+        text(if app.settings.export_png_level == 0 {
+            "PNG export optimization: off".to_string()
+        } else {
+            format!(
+                "PNG export optimization: level {}",
+                app.settings.export_png_level
+            )
+        })
+        .font(INTER_REGULAR)
+        .style(|_theme| {
+            iced::widget::text::Style {
+                color: Some(Color::WHITE),
+            }
+        }),
+        Space::new().width(Length::Fill),
+        action_btn("-", {
+            let mut s = app.settings.clone();
+            s.export_png_level = s.export_png_level.saturating_sub(1);
+            crate::message::Message::SaveSettings(s)
+        }),
+        Space::new().width(10),
+        action_btn("+", {
+            let mut s = app.settings.clone();
+            s.export_png_level = (s.export_png_level + 1).min(6);
+            crate::message::Message::SaveSettings(s)
+        }),
+    ]
+    .align_y(Alignment::Center);
+
+    let optimize_dpi_row = row![
+        text(if app.settings.optimize_image_dpi == 0 {
+            "Optimize PDF images: full resolution".to_string()
+        } else {
+            format!(
+                "Optimize PDF images: {} DPI",
+                app.settings.optimize_image_dpi
+            )
+        })
+        .font(INTER_REGULAR)
+        .style(|_theme| {
+            iced::widget::text::Style {
+                color: Some(Color::WHITE),
+            }
+        }),
+        Space::new().width(Length::Fill),
+        action_btn("-", {
+            let mut s = app.settings.clone();
+            s.optimize_image_dpi = s.optimize_image_dpi.saturating_sub(50);
+            crate::message::Message::SaveSettings(s)
+        }),
+        Space::new().width(10),
+        action_btn("+", {
+            let mut s = app.settings.clone();
+            s.optimize_image_dpi = (s.optimize_image_dpi + 50).min(600);
+            crate::message::Message::SaveSettings(s)
+        }),
+    ]
+    .align_y(Alignment::Center);
+
+    let optimize_quality_row = row![
+        text(format!(
+            "Optimize PDF JPEG quality: {}",
+            app.settings.optimize_jpeg_quality
+        ))
+        .font(INTER_REGULAR)
+        .style(|_theme| {
+            iced::widget::text::Style {
+                color: Some(Color::WHITE),
+            }
+        }),
+        Space::new().width(Length::Fill),
+        action_btn("-", {
+            let mut s = app.settings.clone();
+            s.optimize_jpeg_quality = s.optimize_jpeg_quality.saturating_sub(5).max(10);
+            crate::message::Message::SaveSettings(s)
+        }),
+        Space::new().width(10),
+        action_btn("+", {
+            let mut s = app.settings.clone();
+            s.optimize_jpeg_quality = (s.optimize_jpeg_quality + 5).min(95);
+            crate::message::Message::SaveSettings(s)
+        }),
+    ]
+    .align_y(Alignment::Center);
+
+    let workers_row = row![
+        text(if app.settings.render_workers == 0 {
+            "Render threads: automatic".to_string()
+        } else {
+            format!("Render threads: {}", app.settings.render_workers)
+        })
+        .font(INTER_REGULAR)
+        .style(|_theme| {
+            iced::widget::text::Style {
+                color: Some(Color::WHITE),
+            }
+        }),
+        Space::new().width(Length::Fill),
+        action_btn("-", {
+            let mut s = app.settings.clone();
+            s.render_workers = s.render_workers.saturating_sub(1);
+            crate::message::Message::SaveSettings(s)
+        }),
+        Space::new().width(10),
+        action_btn("+", {
+            let mut s = app.settings.clone();
+            s.render_workers = (s.render_workers + 1).min(64);
+            crate::message::Message::SaveSettings(s)
+        }),
+    ]
+    .align_y(Alignment::Center);
+
+    let heavy_jobs_row = row![
+        text(format!(
+            "Concurrent document operations: {}",
+            app.settings.heavy_jobs
+        ))
+        .font(INTER_REGULAR)
+        .style(|_theme| {
+            iced::widget::text::Style {
+                color: Some(Color::WHITE),
+            }
+        }),
+        Space::new().width(Length::Fill),
+        action_btn("-", {
+            let mut s = app.settings.clone();
+            s.heavy_jobs = s.heavy_jobs.saturating_sub(1).max(1);
+            crate::message::Message::SaveSettings(s)
+        }),
+        Space::new().width(10),
+        action_btn("+", {
+            let mut s = app.settings.clone();
+            s.heavy_jobs = (s.heavy_jobs + 1).min(8);
+            crate::message::Message::SaveSettings(s)
+        }),
+    ]
+    .align_y(Alignment::Center);
+
+    let memory_budget_row = row![
+        text(format!(
+            "Memory budget: {} MB",
+            app.settings.memory_budget_mb
+        ))
+        .font(INTER_REGULAR)
+        .style(|_theme| {
+            iced::widget::text::Style {
+                color: Some(Color::WHITE),
+            }
+        }),
+        Space::new().width(Length::Fill),
+        action_btn("-", {
+            let mut s = app.settings.clone();
+            s.memory_budget_mb = s.memory_budget_mb.saturating_sub(256).max(256);
+            crate::message::Message::SaveSettings(s)
+        }),
+        Space::new().width(10),
+        action_btn("+", {
+            let mut s = app.settings.clone();
+            s.memory_budget_mb = (s.memory_budget_mb + 256).min(16384);
+            crate::message::Message::SaveSettings(s)
+        }),
+    ]
+    .align_y(Alignment::Center);
+
+    let disk_cache_row = row![
+        text(if app.settings.disk_cache_mb == 0 {
+            "Disk cache: off".to_string()
+        } else {
+            format!("Disk cache: {} MB", app.settings.disk_cache_mb)
+        })
+        .font(INTER_REGULAR)
+        .style(|_theme| {
+            iced::widget::text::Style {
+                color: Some(Color::WHITE),
+            }
+        }),
+        Space::new().width(Length::Fill),
+        action_btn("-", {
+            let mut s = app.settings.clone();
+            s.disk_cache_mb = s.disk_cache_mb.saturating_sub(128);
+            crate::message::Message::SaveSettings(s)
+        }),
+        Space::new().width(10),
+        action_btn("+", {
+            let mut s = app.settings.clone();
+            s.disk_cache_mb = (s.disk_cache_mb + 128).min(4096);
+            crate::message::Message::SaveSettings(s)
+        }),
+    ]
+    .align_y(Alignment::Center);
+
     let appearance_card = custom_card(
         text("Appearance")
             .size(18)
@@ -302,7 +553,22 @@ pub fn settings_view(app: &crate::app::PdfBullApp) -> Element<'_, crate::message
             .style(|_theme| iced::widget::text::Style {
                 color: Some(Color::WHITE),
             }),
-        column![quality_buttons, cache_row].spacing(16),
+        // Only builds with the `gpu-render` feature can draw on the GPU.
+        if cfg!(feature = "gpu-render") {
+            column![quality_buttons, backend_buttons]
+        } else {
+            column![quality_buttons]
+        }
+        .push(cache_row)
+        .push(prefetch_row)
+        .push(memory_budget_row)
+        .push(disk_cache_row)
+        .push(export_level_row)
+        .push(optimize_dpi_row)
+        .push(optimize_quality_row)
+        .push(workers_row)
+        .push(heavy_jobs_row)
+        .spacing(16),
     );
 
     let defaults_card = custom_card(
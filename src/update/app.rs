@@ -46,17 +46,66 @@ pub fn handle_app_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
             app.show_keyboard_help = !app.show_keyboard_help;
             Task::none()
         }
+        Message::ToggleMetricsOverlay => {
+            app.show_metrics = !app.show_metrics;
+            if app.show_metrics {
+                return Task::done(Message::RefreshMetrics);
+            }
+            app.metrics = None;
+            Task::none()
+        }
+        Message::RefreshMetrics => match &app.engine {
+            Some(engine) => Task::perform(
+                collect_metrics(engine.cmd_tx.clone()),
+                Message::MetricsCollected,
+            ),
+            None => Task::none(),
+        },
+        Message::MetricsCollected(snapshot) => {
+            if app.show_metrics && snapshot.is_some() {
+                app.metrics = snapshot;
+            }
+            Task::none()
+        }
+        Message::DumpMetrics => match &app.engine {
+            Some(engine) => {
+                let cmd_tx = engine.cmd_tx.clone();
+                Task::perform(
+                    async move {
+                        let snapshot = collect_metrics(cmd_tx)
+                            .await
+                            .ok_or_else(|| "engine is not running".to_string())?;
+                        crate::metrics::dump(&snapshot).map_err(|e| e.to_string())
+                    },
+                    Message::MetricsDumped,
+                )
+            }
+            None => Task::none(),
+        },
+        Message::MetricsDumped(result) => {
+            app.status_message = Some(match result {
+                Ok(path) => format!("Metrics saved to {}", path.display()),
+                Err(e) => format!("Error saving metrics: {e}"),
+            });
+            Task::none()
+        }
+        Message::CheckMemory => {
+            app.enforce_memory_budget();
+            Task::none()
+        }
         Message::RotateClockwise => {
             if let Some(tab) = app.current_tab_mut() {
                 tab.rotation = (tab.rotation + 90) % 360;
-                tab.view_state.rendered_pages.clear();
+                tab.rebuild_layout();
+                tab.view_state.clear_rendered();
             }
             app.render_visible_pages()
         }
         Message::RotateCounterClockwise => {
             if let Some(tab) = app.current_tab_mut() {
                 tab.rotation = (tab.rotation - 90 + 360) % 360;
-                tab.view_state.rendered_pages.clear();
+                tab.rebuild_layout();
+                tab.view_state.clear_rendered();
             }
             app.render_visible_pages()
         }
@@ -83,7 +132,7 @@ pub fn handle_app_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
                     crate::models::ReadingMode::Sepia => RenderFilter::Sepia,
                     crate::models::ReadingMode::Grayscale => RenderFilter::Grayscale,
                 };
-                tab.view_state.rendered_pages.clear();
+                tab.view_state.clear_rendered();
             }
             app.render_visible_pages()
         }
@@ -121,45 +170,29 @@ pub fn handle_app_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
         }
         Message::ToggleTableMode => {
             app.table_mode_active = !app.table_mode_active;
-            if app.table_mode_active {
-                if let Some(tab) = app.current_tab() {
-                    let doc_id = tab.id;
-                    let (start_idx, end_idx) = tab.view_state.visible_range;
-                    let mut tasks = Vec::new();
-                    if let Some(engine) = &app.engine {
-                        let cmd_tx = engine.cmd_tx.clone();
-                        for page_idx in start_idx..end_idx {
-                            if !tab.view_state.detected_tables.contains_key(&page_idx) {
-                                let tx = cmd_tx.clone();
-                                tasks.push(Task::perform(
-                                    async move {
-                                        let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
-                                        let _ = tx
-                                            .send(crate::commands::PdfCommand::DetectTables(
-                                                doc_id, page_idx, resp_tx,
-                                            ))
-                                            .await;
-                                        match resp_rx.await {
-                                            Ok(res) => (doc_id, page_idx, res),
-                                            Err(_) => (
-                                                doc_id,
-                                                page_idx,
-                                                Err(crate::models::PdfError::ChannelClosed),
-                                            ),
-                                        }
-                                    },
-                                    |(d, p, r)| Message::TablesDetected(d, p, r),
-                                ));
-                            }
-                        }
-                    }
-                    if !tasks.is_empty() {
-                        return Task::batch(tasks);
-                    }
-                }
+            if app.table_mode_active
+                && let Some(tab) = app.current_tab()
+            {
+                let (start_idx, end_idx) = tab.view_state.visible_range;
+                let pages = (start_idx..end_idx)
+                    .filter(|page_idx| !tab.view_state.detected_tables.contains_key(page_idx))
+                    .collect();
+                return super::render::request_page_overlays(app, tab.id, pages, false, true);
             }
             Task::none()
         }
         _ => Task::none(),
     }
 }
+
+/// Asks a worker for a metrics snapshot; `None` if the engine is gone.
+async fn collect_metrics(
+    cmd_tx: tokio::sync::mpsc::Sender<crate::commands::PdfCommand>,
+) -> Option<crate::metrics::MetricsSnapshot> {
+    let (tx, rx) = tokio::sync::oneshot::channel();
+    cmd_tx
+        .send(crate::commands::PdfCommand::CollectMetrics(tx))
+        .await
+        .ok()?;
+    rx.await.ok()
+}
@@ -2,6 +2,8 @@ use crate::app::PdfBullApp;
 use crate::commands::PdfCommand;
 use crate::message::Message;
 use iced::Task;
+use std::sync::Arc;
+use std::sync::atomic::{AtomicBool, Ordering};
 
 pub fn handle_export_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
     match message {
@@ -132,7 +134,12 @@ pub fn handle_export_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
                     };
                     if let Err(_e) = cmd_tx
                         .send(crate::commands::PdfCommand::Render(
-                            doc_id, page, options, resp_tx,
+                            doc_id,
+                            page,
+                            options,
+                            crate::commands::JobPriority::Background,
+                            None,
+                            resp_tx,
                         ))
                         .await
                     {
@@ -270,51 +277,68 @@ pub fn handle_export_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
                 return Task::none();
             };
 
+            let level = app.settings.export_png_level;
             let cmd_tx = engine.cmd_tx.clone();
-            Task::perform(
-                async move {
-                    let folder = rfd::AsyncFileDialog::new().pick_folder().await;
+            if let Some(previous) = app.export_cancel.take() {
+                previous.store(true, Ordering::Relaxed);
+            }
+            let cancel = Arc::new(AtomicBool::new(false));
+            app.export_cancel = Some(cancel.clone());
+            let (progress_tx, progress_rx) = iced::futures::channel::mpsc::unbounded();
+            // Picking no folder drops the sender, which ends the stream quietly.
+            let send = Task::future(async move {
+                let Some(folder) = rfd::AsyncFileDialog::new().pick_folder().await else {
+                    return;
+                };
+                let path = folder.path().to_string_lossy().to_string();
+                let pages: Vec<usize> = (0..total_pages).collect();
+                let err_tx = progress_tx.clone();
+                if let Err(e) = cmd_tx
+                    .send(PdfCommand::ExportImages(
+                        doc_id,
+                        pages,
+                        zoom,
+                        path,
+                        level,
+                        cancel,
+                        progress_tx,
+                    ))
+                    .await
+                {
+                    tracing::error!("Failed to send ExportImages command: {e}");
+                    let _ = err_tx.unbounded_send(Err(crate::models::PdfError::EngineDied));
+                }
+            })
+            .discard();
 
-                    match folder {
-                        Some(f) => {
-                            let path = f.path().to_string_lossy().to_string();
-                            let pages: Vec<usize> = (0..total_pages).collect();
-                            let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
-                            if let Err(e) = cmd_tx
-                                .send(PdfCommand::ExportImages(
-                                    doc_id,
-                                    pages,
-                                    zoom,
-                                    path.clone(),
-                                    resp_tx,
-                                ))
-                                .await
-                            {
-                                tracing::error!("Failed to send ExportImages command: {e}");
-                                return Err(crate::models::PdfError::EngineDied);
-                            }
-                            match resp_rx.await {
-                                Ok(Ok(paths)) => Ok(paths.join(", ")),
-                                Ok(Err(e)) => Err(e),
-                                Err(_) => Err(crate::models::PdfError::EngineDied),
-                            }
-                        }
-                        None => Err(crate::models::PdfError::OpenFailed("Cancelled".into())),
-                    }
-                },
-                |res| match res {
-                    Ok(p) => Message::ImageExported(Ok(p)),
+            Task::batch(vec![
+                send,
+                Task::run(progress_rx, |res| match res {
+                    Ok(progress) => Message::ImagesExportProgress(progress),
                     Err(e) => Message::ImageExported(Err(e)),
-                },
-            )
+                }),
+            ])
+        }
+        Message::ImagesExportProgress(progress) => {
+            app.status_message = Some(if progress.done < progress.total {
+                format!("Exporting images… {}/{}", progress.done, progress.total)
+            } else if progress.failed > 0 {
+                format!(
+                    "Exported {} of {} pages; {} failed",
+                    progress.total - progress.failed,
+                    progress.total,
+                    progress.failed
+                )
+            } else {
+                format!("Exported {} pages as images", progress.total)
+            });
+            Task::none()
         }
         Message::MergeDocuments(paths) => {
             let engine = if let Some(e) = &app.engine {
                 e
             } else {
-                let cache_size = app.settings.cache_size as u64;
-                let max_mem = app.settings.max_cache_memory as u64;
-                app.engine = Some(crate::engine::spawn_engine_thread(cache_size, max_mem));
+                app.engine = Some(crate::engine::spawn_engine_thread(&app.settings));
                 app.engine.as_ref().unwrap()
             };
             let cmd_tx = engine.cmd_tx.clone();
@@ -678,6 +702,10 @@ pub fn handle_export_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
                 return Task::none();
             };
             let cmd_tx = engine.cmd_tx.clone();
+            let options = crate::optimize::OptimizeOptions {
+                target_dpi: app.settings.optimize_image_dpi,
+                jpeg_quality: app.settings.optimize_jpeg_quality,
+            };
             Task::perform(
                 async move {
                     let save = rfd::AsyncFileDialog::new()
@@ -691,10 +719,10 @@ pub fn handle_export_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
                             let out = f.path().to_string_lossy().to_string();
                             let (tx, rx) = tokio::sync::oneshot::channel();
                             let _ = cmd_tx
-                                .send(PdfCommand::Optimize(path, out.clone(), tx))
+                                .send(PdfCommand::Optimize(path, out, options, tx))
                                 .await;
                             match rx.await {
-                                Ok(Ok(path)) => Ok(path),
+                                Ok(Ok(report)) => Ok(report),
                                 Ok(Err(e)) => Err(e),
                                 Err(_) => Err(crate::models::PdfError::EngineDied),
                             }
@@ -707,8 +735,12 @@ pub fn handle_export_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
         }
         Message::PDFOptimized(res) => {
             match res {
-                Ok(path) => {
-                    app.status_message = Some(format!("Optimized PDF saved to: {path}"));
+                Ok(report) => {
+                    app.status_message = Some(format!(
+                        "Optimized PDF saved to: {} ({})",
+                        report.output_path,
+                        report.summary()
+                    ));
                 }
                 Err(e) => {
                     if e != "Cancelled" {
@@ -80,6 +80,9 @@ pub fn handle_misc_message(app: &mut PdfBullApp, message: Message) -> Task<Messa
                         Key::Named(iced::keyboard::key::Named::F1) => {
                             return app.update(Message::ToggleKeyboardHelp);
                         }
+                        Key::Named(iced::keyboard::key::Named::F12) => {
+                            return app.update(Message::ToggleMetricsOverlay);
+                        }
                         Key::Character(c) => match c.as_str() {
                             "o" if modifiers.command() => return app.update(Message::OpenDocument),
                             "e" if modifiers.command() => return app.update(Message::ExportImage),
@@ -15,12 +15,7 @@ use crate::storage;
 use iced::Task;
 
 pub fn scroll_to_page(tab: &crate::models::DocumentTab, page: usize) -> Task<Message> {
-    let y_offset: f32 = tab
-        .page_heights
-        .iter()
-        .take(page)
-        .map(|h| (h + crate::ui::theme::PAGE_SPACING) * tab.zoom)
-        .sum();
+    let y_offset = tab.page_offset(page);
     iced::widget::operation::scroll_to(
         "pdf_scroll",
         iced::widget::scrollable::AbsoluteOffset {
@@ -36,12 +31,7 @@ pub fn scroll_to_search_result(
 ) -> Task<Message> {
     if let Some(result) = tab.search_results.get(result_idx) {
         let page = result.page;
-        let y_page_start: f32 = tab
-            .page_heights
-            .iter()
-            .take(page)
-            .map(|h| (h + crate::ui::theme::PAGE_SPACING) * tab.zoom)
-            .sum();
+        let y_page_start = tab.page_offset(page);
 
         let actual_page = tab.page_mapping.get(page).copied().unwrap_or(page);
         let page_rotation = tab
@@ -108,24 +98,9 @@ pub fn handle_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
         if let Some(path) = cli_path {
             tasks.push(app.update(Message::OpenFile(path)));
         } else if app.settings.restore_session
-            && let Some(mut session_data) = session
+            && let Some(session_data) = session
         {
-            let target_tab = session_data.active_tab;
-            for entry in session_data.open_tabs.drain(..) {
-                let path: std::path::PathBuf = entry.clone().into();
-                tasks.push(app.update(Message::OpenFile(path)));
-                if let crate::models::SessionTabEntry::Detailed(detailed) = entry {
-                    if let Some(tab) = app.tabs.last_mut() {
-                        tab.pending_session = Some(detailed);
-                    }
-                }
-            }
-            if !tasks.is_empty() {
-                tasks.push(Task::perform(
-                    async move { Message::SwitchTab(target_tab) },
-                    |m| m,
-                ));
-            }
+            tasks.push(app.restore_session(session_data));
         }
 
         if !tasks.is_empty() {
@@ -143,6 +118,12 @@ pub fn handle_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
         | Message::ToggleFormsSidebar
         | Message::ToggleFullscreen
         | Message::ToggleKeyboardHelp
+        | Message::ToggleMetricsOverlay
+        | Message::RefreshMetrics
+        | Message::MetricsCollected(_)
+        | Message::DumpMetrics
+        | Message::MetricsDumped(_)
+        | Message::CheckMemory
         | Message::RotateClockwise
         | Message::RotateCounterClockwise
         | Message::ToggleMetadata
@@ -175,13 +156,14 @@ pub fn handle_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
         | Message::EditAnnotationText(_, _) => annotations::handle_annotation_message(app, message),
         Message::SetFilter(_)
         | Message::ToggleAutoCrop
-        | Message::ViewportChanged(_, _)
+        | Message::ViewportChanged(_, _, _, _)
         | Message::SidebarViewportChanged(_)
         | Message::RequestRender(_)
-        | Message::PageRendered(_, _, _, _)
-        | Message::ThumbnailRendered(_, _, _, _)
-        | Message::TextItemsLoaded(_, _, _)
-        | Message::TablesDetected(_, _, _) => render::handle_render_message(app, message),
+        | Message::PageRendered(..)
+        | Message::PagePreviewRendered(..)
+        | Message::TilesRendered(..)
+        | Message::ThumbnailsRendered(..)
+        | Message::PageOverlaysLoaded(_, _) => render::handle_render_message(app, message),
         Message::OpenDocument
         | Message::DocumentOpenedWithPath(_)
         | Message::DocumentOpened(_, _)
@@ -193,6 +175,7 @@ pub fn handle_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
         | Message::TabReordered(_)
         | Message::DocumentModifiedExternally(_)
         | Message::ReloadDocument(_)
+        | Message::DocumentReloaded(_, _)
         | Message::PasswordInputChanged(_)
         | Message::SubmitPassword
         | Message::CancelPasswordPrompt
@@ -210,7 +193,7 @@ pub fn handle_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
         | Message::PageInputSubmitted => navigation::handle_nav_message(app, message),
         Message::Search(_)
         | Message::PerformSearch(_)
-        | Message::SearchResult(_, _)
+        | Message::SearchResult(_, _, _)
         | Message::NextSearchResult
         | Message::PrevSearchResult
         | Message::ClearSearch => search::handle_search_message(app, message),
@@ -222,6 +205,7 @@ pub fn handle_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
         | Message::ExportImage
         | Message::ImageExported(_)
         | Message::ExportImages
+        | Message::ImagesExportProgress(_)
         | Message::SaveOrganizedPDF
         | Message::OrganizedPDFSaved(_)
         | Message::Print
@@ -325,6 +309,7 @@ pub fn handle_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
                     if page_idx < tab.page_heights.len() {
                         tab.page_heights.remove(page_idx);
                     }
+                    tab.rebuild_layout();
                     // Remove annotations on the deleted page and shift remaining ones
                     tab.annotations.retain(|ann| ann.page != page_idx);
                     for ann in &mut tab.annotations {
@@ -334,7 +319,7 @@ pub fn handle_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
                     }
                     tab.total_pages = tab.page_mapping.len();
                     tab.current_page = tab.current_page.min(tab.total_pages.saturating_sub(1));
-                    tab.view_state.rendered_pages.clear();
+                    tab.view_state.clear_rendered();
                     tab.view_state.thumbnails.clear();
                 }
             }
@@ -349,7 +334,8 @@ pub fn handle_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
                     if *current_rot < 0 {
                         *current_rot += 360;
                     }
-                    tab.view_state.rendered_pages.clear();
+                    tab.relayout_page(page_idx);
+                    tab.view_state.clear_rendered();
                     tab.view_state.thumbnails.clear();
                 }
             }
@@ -364,6 +350,8 @@ pub fn handle_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
                         {
                             tab.page_heights.swap(page_idx, target_idx);
                         }
+                        tab.relayout_page(page_idx);
+                        tab.relayout_page(target_idx);
                         // Swap annotation page indices to keep them bound to the physical page content
                         for ann in &mut tab.annotations {
                             if ann.page == page_idx {
@@ -372,7 +360,7 @@ pub fn handle_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
                                 ann.page = page_idx;
                             }
                         }
-                        tab.view_state.rendered_pages.clear();
+                        tab.view_state.clear_rendered();
                         tab.view_state.thumbnails.clear();
                     }
                 }
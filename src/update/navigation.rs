@@ -212,7 +212,7 @@ mod tests {
         app.loaded = true;
         let mut tab = DocumentTab::new(std::path::PathBuf::from("test.pdf"));
         tab.total_pages = 10;
-        tab.page_heights = vec![800.0; 10];
+        tab.set_page_heights(vec![800.0; 10]);
         app.tabs.push(tab);
         app.active_tab = 0;
         app
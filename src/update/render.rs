@@ -2,7 +2,6 @@ use crate::app::PdfBullApp;
 use crate::message::Message;
 use crate::models::PdfError;
 use iced::Task;
-use iced::widget::image as iced_image;
 
 pub fn handle_render_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
     match message {
@@ -11,23 +10,29 @@ pub fn handle_render_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
                 && tab.render_filter != filter
             {
                 tab.render_filter = filter;
-                tab.view_state.rendered_pages.clear();
+                tab.view_state.clear_rendered();
             }
             app.render_visible_pages()
         }
         Message::ToggleAutoCrop => {
             if let Some(tab) = app.current_tab_mut() {
                 tab.auto_crop = !tab.auto_crop;
-                tab.view_state.rendered_pages.clear();
+                tab.view_state.clear_rendered();
             }
             app.render_visible_pages()
         }
-        Message::ViewportChanged(y, height) => {
+        Message::ViewportChanged(x, y, width, height) => {
             if let Some(tab) = app.current_tab_mut() {
-                tab.view_state.viewport_y = y;
+                tab.view_state.viewport_x = x;
+                tab.view_state.track_scroll(y);
+                tab.view_state.viewport_width = width;
                 tab.view_state.viewport_height = height;
+                let previous_range = tab.view_state.visible_range;
                 tab.update_visible_range();
                 tab.cleanup_distant_pages();
+                if tab.view_state.visible_range != previous_range {
+                    cancel_offscreen_renders(app);
+                }
             }
             for tab in &mut app.tabs {
                 if tab.needs_periodic_cleanup() {
@@ -43,7 +48,7 @@ pub fn handle_render_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
             Task::none()
         }
         Message::RequestRender(page_idx) => {
-            let (doc_id, zoom, rotation, filter, auto_crop, quality) = {
+            let (doc_id, generation, zoom, rotation, filter, auto_crop, quality) = {
                 let Some(tab) = app.current_tab() else {
                     return Task::none();
                 };
@@ -65,6 +70,7 @@ pub fn handle_render_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
 
                 (
                     tab.id,
+                    tab.generation,
                     tab.zoom,
                     tab.rotation,
                     tab.render_filter,
@@ -91,164 +97,149 @@ pub fn handle_render_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
                         auto_crop,
                         quality,
                     };
-                    if let Err(e) = cmd_tx.try_send(crate::commands::PdfCommand::Render(
-                        doc_id, page_idx, options, resp_tx,
-                    )) {
+                    if let Err(e) = cmd_tx
+                        .send(crate::commands::PdfCommand::Render(
+                            doc_id,
+                            page_idx,
+                            options,
+                            crate::commands::JobPriority::Visible,
+                            None,
+                            resp_tx,
+                        ))
+                        .await
+                    {
                         tracing::warn!("Failed to send Render command: {e}");
-                        return Err(crate::models::PdfError::Cancelled);
+                        return Err(crate::models::PdfError::ChannelClosed);
                     }
                     resp_rx
                         .await
                         .unwrap_or(Err(crate::models::PdfError::ChannelClosed))
                 },
-                move |res| Message::PageRendered(doc_id, page_idx, zoom, res),
+                move |res| Message::PageRendered(doc_id, generation, page_idx, zoom, res),
             )
         }
-        Message::PageRendered(doc_id, page_idx, scale, result) => {
+        Message::PageRendered(doc_id, generation, page_idx, scale, result) => {
             app.rendering_set
                 .remove(&crate::app::RenderTarget::Page(doc_id, page_idx));
 
-            let mut text_tasks: Vec<Task<Message>> = Vec::new();
+            let mut overlay_task = Task::none();
 
-            if let Some(tab) = app.tabs.iter_mut().find(|t| t.id == doc_id) {
+            // A render of the file as it was before a reload is dropped; the
+            // page is requested again below.
+            if let Some(tab) = app
+                .tabs
+                .iter_mut()
+                .find(|t| t.id == doc_id && t.generation == generation)
+            {
                 match result {
                     Ok(res) => {
-                        let width = res.width;
-                        let height = res.height;
-                        let pixel_data = res.data.to_vec();
-                        tab.view_state.rendered_pages.insert(
-                            page_idx,
-                            (
-                                scale,
-                                iced_image::Handle::from_rgba(width, height, pixel_data),
-                            ),
-                        );
+                        tab.view_state
+                            .rendered_pages
+                            .insert(page_idx, (scale, res.to_handle()));
 
-                        // Lazily fetch text (selection / accessibility) so the
-                        // image paints without blocking on glyph extraction.
-                        if !tab.view_state.text_layers.contains_key(&page_idx)
-                            && !app.pending_text.contains(&(doc_id, page_idx))
-                        {
-                            app.pending_text.insert((doc_id, page_idx));
-                            if let Some(engine) = &app.engine {
-                                let cmd_tx = engine.cmd_tx.clone();
-                                text_tasks.push(Task::perform(
-                                    async move {
-                                        let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
-                                        let _ = cmd_tx
-                                            .send(crate::commands::PdfCommand::GetTextItems(
-                                                doc_id, page_idx, resp_tx,
-                                            ))
-                                            .await;
-                                        match resp_rx.await {
-                                            Ok(r) => (doc_id, page_idx, r),
-                                            Err(_) => {
-                                                (doc_id, page_idx, Err(PdfError::ChannelClosed))
-                                            }
-                                        }
-                                    },
-                                    |(d, p, r)| Message::TextItemsLoaded(d, p, r),
-                                ));
-                            }
-                        }
-
-                        if app.table_mode_active
-                            && !tab.view_state.detected_tables.contains_key(&page_idx)
-                        {
-                            if let Some(engine) = &app.engine {
-                                let cmd_tx = engine.cmd_tx.clone();
-                                text_tasks.push(Task::perform(
-                                    async move {
-                                        let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
-                                        let _ = cmd_tx
-                                            .send(crate::commands::PdfCommand::DetectTables(
-                                                doc_id, page_idx, resp_tx,
-                                            ))
-                                            .await;
-                                        match resp_rx.await {
-                                            Ok(r) => (doc_id, page_idx, r),
-                                            Err(_) => {
-                                                (doc_id, page_idx, Err(PdfError::ChannelClosed))
-                                            }
-                                        }
-                                    },
-                                    |(d, p, r)| Message::TablesDetected(d, p, r),
-                                ));
-                            }
-                        }
+                        overlay_task = page_overlay_task(app, doc_id, page_idx);
                     }
-                    Err(e) => {
-                        tracing::error!(
-                            "PageRendered error for page {} of {:?}: {:?}",
-                            page_idx,
-                            doc_id,
-                            e
-                        );
-                        if matches!(
-                            e,
-                            crate::models::PdfError::EngineDied
-                                | crate::models::PdfError::ChannelClosed
-                        ) {
-                            tracing::error!(
-                                "Engine channel closed — setting engine to None for restart"
-                            );
-                            app.engine = None;
-                            app.status_message = Some(
-                                "PDF engine crashed. Please try your action again to restart it."
-                                    .into(),
+                    Err(e) => report_render_error(app, doc_id, page_idx, &e),
+                }
+            }
+
+            Task::batch([overlay_task, app.render_visible_pages()])
+        }
+        Message::PagePreviewRendered(doc_id, generation, page_idx, result) => {
+            // A preview that lost the race to the full render, or was not
+            // needed, is simply dropped.
+            let Ok(res) = result else {
+                return Task::none();
+            };
+            if let Some(tab) = app
+                .tabs
+                .iter_mut()
+                .find(|t| t.id == doc_id && t.generation == generation)
+            {
+                let zoom = tab.zoom;
+                let has_full = tab
+                    .view_state
+                    .rendered_pages
+                    .get(&page_idx)
+                    .is_some_and(|&(s, _)| (s - zoom).abs() < 0.001);
+                if !has_full {
+                    tab.view_state
+                        .rendered_pages
+                        .insert(page_idx, (0.0, res.to_handle()));
+                }
+            }
+            Task::none()
+        }
+        Message::TilesRendered(doc_id, generation, page_idx, scale, result) => {
+            app.rendering_set
+                .remove(&crate::app::RenderTarget::Tiles(doc_id, page_idx));
+
+            let mut overlay_task = Task::none();
+
+            if let Some(tab) = app
+                .tabs
+                .iter_mut()
+                .find(|t| t.id == doc_id && t.generation == generation)
+            {
+                match result {
+                    Ok(tiles) => {
+                        for tile in tiles {
+                            tab.view_state.rendered_tiles.insert(
+                                (page_idx, tile.col, tile.row),
+                                (scale, tile.result.to_handle()),
                             );
                         }
+                        overlay_task = page_overlay_task(app, doc_id, page_idx);
                     }
+                    Err(e) => report_render_error(app, doc_id, page_idx, &e),
                 }
             }
 
-            let render_task = app.render_visible_pages();
-            if text_tasks.is_empty() {
-                render_task
-            } else {
-                text_tasks.push(render_task);
-                Task::batch(text_tasks)
-            }
+            Task::batch([overlay_task, app.render_visible_pages()])
         }
-        Message::TextItemsLoaded(doc_id, page_idx, result) => {
-            app.pending_text.remove(&(doc_id, page_idx));
-            if let Ok(items) = result {
-                if let Some(tab) = app.tabs.iter_mut().find(|t| t.id == doc_id) {
-                    tab.view_state.text_layers.insert(page_idx, items);
+        Message::PageOverlaysLoaded(doc_id, overlays) => {
+            for overlay in &overlays {
+                if overlay.text_items.is_some() {
+                    app.pending_text.remove(&(doc_id, overlay.page));
                 }
             }
-            Task::none()
-        }
-        Message::TablesDetected(doc_id, page_idx, result) => {
-            if let Ok(tables) = result {
-                if let Some(tab) = app.tabs.iter_mut().find(|t| t.id == doc_id) {
-                    tab.view_state.detected_tables.insert(page_idx, tables);
+            if let Some(tab) = app.tabs.iter_mut().find(|t| t.id == doc_id) {
+                for overlay in overlays {
+                    if let Some(Ok(items)) = overlay.text_items {
+                        tab.view_state.text_layers.insert(overlay.page, items);
+                    }
+                    if let Some(Ok(tables)) = overlay.tables {
+                        tab.view_state.detected_tables.insert(overlay.page, tables);
+                    }
                 }
             }
             Task::none()
         }
-        Message::ThumbnailRendered(doc_id, page_idx, scale, result) => {
-            app.rendering_set
-                .remove(&crate::app::RenderTarget::Thumbnail(doc_id, page_idx));
+        Message::ThumbnailsRendered(doc_id, generation, scale, results) => {
+            for (page_idx, _) in &results {
+                app.rendering_set
+                    .remove(&crate::app::RenderTarget::Thumbnail(doc_id, *page_idx));
+            }
 
-            if let Some(tab) = app.tabs.iter_mut().find(|t| t.id == doc_id) {
+            if let Some(tab) = app
+                .tabs
+                .iter_mut()
+                .find(|t| t.id == doc_id && t.generation == generation)
+            {
                 let expected_thumb_zoom = (120.0 / tab.page_width.max(1.0)).min(5.0);
                 if (expected_thumb_zoom - scale).abs() > 0.001 {
                     return Task::none();
                 }
 
-                match result {
-                    Ok(res) => {
-                        let width = res.width;
-                        let height = res.height;
-                        let pixel_data = res.data.to_vec();
-                        tab.view_state.thumbnails.insert(
-                            page_idx,
-                            iced_image::Handle::from_rgba(width, height, pixel_data),
-                        );
-                    }
-                    Err(e) => {
-                        tracing::error!("Thumbnail render error: {e}");
+                for (page_idx, result) in results {
+                    match result {
+                        Ok(res) => {
+                            tab.view_state.thumbnails.insert(page_idx, res.to_handle());
+                        }
+                        Err(PdfError::Cancelled) => {}
+                        Err(e) => {
+                            tracing::error!("Thumbnail render error: {e}");
+                        }
                     }
                 }
             }
@@ -257,3 +248,110 @@ pub fn handle_render_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
         _ => Task::none(),
     }
 }
+
+/// Fetches the text layer, and tables in table mode, for a page that just
+/// got pixels, so the image paints without blocking on glyph extraction.
+/// Both are built from the text spans the render usually left behind in
+/// the engine, so this does not interpret the page again.
+fn page_overlay_task(
+    app: &mut PdfBullApp,
+    doc_id: crate::models::DocumentId,
+    page_idx: usize,
+) -> Task<Message> {
+    let Some(tab) = app.tabs.iter().find(|t| t.id == doc_id) else {
+        return Task::none();
+    };
+    let text = !tab.view_state.text_layers.contains_key(&page_idx)
+        && !app.pending_text.contains(&(doc_id, page_idx));
+    let tables = app.table_mode_active && !tab.view_state.detected_tables.contains_key(&page_idx);
+    if text {
+        app.pending_text.insert((doc_id, page_idx));
+    }
+    request_page_overlays(app, doc_id, vec![page_idx], text, tables)
+}
+
+/// One `GetPageOverlays` round trip for `pages`.
+pub fn request_page_overlays(
+    app: &PdfBullApp,
+    doc_id: crate::models::DocumentId,
+    pages: Vec<usize>,
+    text: bool,
+    tables: bool,
+) -> Task<Message> {
+    let Some(engine) = &app.engine else {
+        return Task::none();
+    };
+    if pages.is_empty() || !(text || tables) {
+        return Task::none();
+    }
+    let cmd_tx = engine.cmd_tx.clone();
+    Task::perform(
+        async move {
+            let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
+            let _ = cmd_tx
+                .send(crate::commands::PdfCommand::GetPageOverlays(
+                    doc_id,
+                    pages.clone(),
+                    text,
+                    tables,
+                    resp_tx,
+                ))
+                .await;
+            resp_rx.await.unwrap_or_else(|_| {
+                pages
+                    .into_iter()
+                    .map(|page| crate::models::PageOverlay {
+                        page,
+                        text_items: text.then_some(Err(PdfError::ChannelClosed)),
+                        tables: tables.then_some(Err(PdfError::ChannelClosed)),
+                    })
+                    .collect()
+            })
+        },
+        move |overlays| Message::PageOverlaysLoaded(doc_id, overlays),
+    )
+}
+
+/// Tells the scheduler which source pages are still near the viewport or
+/// ahead of it, so queued renders of pages scrolled past are dropped.
+fn cancel_offscreen_renders(app: &PdfBullApp) {
+    let (Some(tab), Some(engine)) = (app.current_tab(), &app.engine) else {
+        return;
+    };
+    let (start, end) = tab.view_state.visible_range;
+    let buffer = crate::ui::theme::VIEWPORT_BUFFER;
+    let prefetch = tab.prefetch_pages(app.settings.prefetch_memory_mb * 1024 * 1024);
+    let keep = (start.saturating_sub(buffer)..(end + buffer).min(tab.total_pages))
+        .chain(prefetch)
+        .map(|idx| tab.page_mapping.get(idx).copied().unwrap_or(idx))
+        .collect();
+    // Best effort: if the channel is momentarily full the stale renders
+    // simply run.
+    let _ = engine
+        .cmd_tx
+        .try_send(crate::commands::PdfCommand::SetViewport(tab.id, keep));
+}
+
+fn report_render_error(
+    app: &mut PdfBullApp,
+    doc_id: crate::models::DocumentId,
+    page_idx: usize,
+    e: &PdfError,
+) {
+    if *e == PdfError::Cancelled {
+        tracing::debug!("Render of page {} for {:?} cancelled", page_idx, doc_id);
+        return;
+    }
+    tracing::error!(
+        "PageRendered error for page {} of {:?}: {:?}",
+        page_idx,
+        doc_id,
+        e
+    );
+    if matches!(e, PdfError::EngineDied | PdfError::ChannelClosed) {
+        tracing::error!("Engine channel closed — setting engine to None for restart");
+        app.engine = None;
+        app.status_message =
+            Some("PDF engine crashed. Please try your action again to restart it.".into());
+    }
+}
@@ -2,13 +2,16 @@ use crate::app::PdfBullApp;
 use crate::message::Message;
 use crate::models::SearchResult;
 use iced::Task;
-use tokio::sync::oneshot;
+use iced::futures::channel::mpsc;
+use std::sync::Arc;
+use std::sync::atomic::{AtomicBool, Ordering};
 
 pub fn handle_search_message(app: &mut PdfBullApp, message: Message) -> Task<Message> {
     match message {
         Message::Search(query) => {
             app.search_query.clone_from(&query);
             if query.is_empty() {
+                cancel_search(app);
                 if let Some(tab) = app.current_tab_mut() {
                     tab.search_results.clear();
                     tab.current_search_index = 0;
@@ -32,48 +35,61 @@ pub fn handle_search_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
                 return Task::none();
             }
 
-            let Some(tab) = app.current_tab() else {
+            cancel_search(app);
+
+            let Some(tab) = app.current_tab_mut() else {
                 return Task::none();
             };
-
+            tab.search_results.clear();
+            tab.current_search_index = 0;
             let doc_id = tab.id;
 
             let Some(engine) = &app.engine else {
                 return Task::none();
             };
 
+            let cancel = Arc::new(AtomicBool::new(false));
+            app.search_cancel = Some(cancel.clone());
+            let generation = app.search_generation;
+
+            let (batch_tx, batch_rx) = mpsc::unbounded();
+            let err_tx = batch_tx.clone();
             let cmd_tx = engine.cmd_tx.clone();
-            Task::perform(
-                async move {
-                    let (resp_tx, resp_rx) = oneshot::channel();
-                    if let Err(e) = cmd_tx
-                        .send(crate::commands::PdfCommand::Search(doc_id, query, resp_tx))
-                        .await
-                    {
-                        tracing::error!("Failed to send Search command: {e}");
-                        return Err(crate::models::PdfError::EngineDied);
-                    }
-                    match resp_rx.await {
-                        Ok(res) => res,
-                        Err(_) => Err(crate::models::PdfError::ChannelClosed),
-                    }
-                },
-                move |result| Message::SearchResult(doc_id, result),
-            )
+            let send = Task::future(async move {
+                if let Err(e) = cmd_tx
+                    .send(crate::commands::PdfCommand::Search(
+                        doc_id, query, cancel, batch_tx,
+                    ))
+                    .await
+                {
+                    tracing::error!("Failed to send Search command: {e}");
+                    let _ = err_tx.unbounded_send(Err(crate::models::PdfError::EngineDied));
+                }
+            })
+            .discard();
+
+            Task::batch(vec![
+                send,
+                Task::run(batch_rx, move |batch| {
+                    Message::SearchResult(doc_id, generation, batch)
+                }),
+            ])
         }
-        Message::SearchResult(received_doc_id, result) => {
+        Message::SearchResult(received_doc_id, generation, result) => {
+            if generation != app.search_generation {
+                return Task::none();
+            }
             match result {
-                Ok(results) => {
+                Ok(batch) => {
                     if let Some(tab) = app.current_tab_mut()
                         && tab.id == received_doc_id
                     {
-                        tab.search_results = results
-                            .into_iter()
-                            .map(SearchResult::from_search_result_item)
-                            .collect();
-                        tab.current_search_index = 0;
+                        let first_batch = tab.search_results.is_empty();
+                        tab.search_results
+                            .extend(batch.into_iter().map(SearchResult::from_search_result_item));
 
-                        if !tab.search_results.is_empty() && tab.current_search_index == 0 {
+                        if first_batch && !tab.search_results.is_empty() {
+                            tab.current_search_index = 0;
                             tab.current_page = tab.search_results[0].page;
                         }
                     }
@@ -157,6 +173,7 @@ pub fn handle_search_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
             Task::none()
         }
         Message::ClearSearch => {
+            cancel_search(app);
             if let Some(tab) = app.current_tab_mut() {
                 tab.search_results.clear();
                 tab.current_search_index = 0;
@@ -167,3 +184,11 @@ pub fn handle_search_message(app: &mut PdfBullApp, message: Message) -> Task<Mes
         _ => Task::none(),
     }
 }
+
+/// Stops the in-flight search and drops any of its batches still in transit.
+fn cancel_search(app: &mut PdfBullApp) {
+    if let Some(cancel) = app.search_cancel.take() {
+        cancel.store(true, Ordering::Relaxed);
+    }
+    app.search_generation = app.search_generation.wrapping_add(1);
+}
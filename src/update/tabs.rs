@@ -9,9 +9,7 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
     match message {
         Message::OpenDocument => {
             if app.engine.is_none() {
-                let cache_size = app.settings.cache_size as u64;
-                let max_mem = app.settings.max_cache_memory as u64;
-                app.engine = Some(crate::engine::spawn_engine_thread(cache_size, max_mem));
+                app.engine = Some(crate::engine::spawn_engine_thread(&app.settings));
             }
 
             if let Some(engine) = &app.engine {
@@ -78,8 +76,6 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
                 let count = res.page_count;
                 let heights = res.page_heights;
                 let width = res.max_width;
-                let outline = res.outline;
-                let links = res.links;
 
                 let default_zoom = app.settings.default_zoom;
                 let default_filter = app.settings.default_filter;
@@ -88,16 +84,18 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
 
                 if let Some(tab) = app.tabs.iter_mut().find(|t| t.id == doc_id) {
                     tab.total_pages = count;
-                    tab.page_heights = heights;
-                    tab.page_width = width;
-                    tab.outline = outline;
-                    tab.links = links;
-                    tab.page_labels = res.page_labels.clone();
+                    // Heights restored from a snapshot are measured; the
+                    // ones `Open` returns past the first screen are not.
+                    if !tab.restored_layout || tab.page_heights.len() != count {
+                        tab.page_heights = heights;
+                        tab.page_width = width;
+                    }
+                    tab.metadata = res.metadata;
                     tab.is_encrypted = res.is_encrypted;
-                    tab.signatures = res.signatures.clone();
-                    tab.attachments = res.attachments.clone();
-                    tab.layers = res.layers.clone();
-                    tab.oc_config = res.oc_config.clone();
+                    tab.generation = res.generation;
+                    tab.file_bytes = res.file_bytes;
+                    tab.fingerprint = res.fingerprint;
+                    tab.page_labels = (1..=count).map(|i| i.to_string()).collect();
                     tab.view_state.is_loading = false;
                     tab.page_mapping = (0..count).collect();
 
@@ -108,10 +106,11 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
                         tab.auto_crop = session.auto_crop;
                         tab.view_state.viewport_y = session.viewport_y;
                         scroll_task = crate::update::scroll_to_y(session.viewport_y);
-                    } else {
+                    } else if !tab.restored_layout {
                         tab.zoom = default_zoom;
                         tab.render_filter = default_filter;
                     }
+                    tab.rebuild_layout();
                 }
 
                 let pdf_path = app
@@ -142,21 +141,14 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
                     }
 
                     let cmd_tx = engine.cmd_tx.clone();
-                    tasks.push(Task::perform(
-                        async move {
-                            let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
-                            let _ = cmd_tx
-                                .send(crate::commands::PdfCommand::LoadDocumentMeta(
-                                    doc_id, resp_tx,
-                                ))
-                                .await;
-                            match resp_rx.await {
-                                Ok(meta) => (doc_id, meta),
-                                Err(_) => (doc_id, Err(PdfError::ChannelClosed)),
-                            }
-                        },
-                        |(doc_id, meta)| Message::DocumentMetaLoaded(doc_id, meta),
-                    ));
+                    let persist = app.settings.persist_text_index;
+                    tokio::spawn(async move {
+                        let _ = cmd_tx
+                            .send(crate::commands::PdfCommand::BuildTextIndex(doc_id, persist))
+                            .await;
+                    });
+
+                    tasks.push(load_document_meta(engine, doc_id));
                 }
 
                 tasks.push(app.render_visible_pages());
@@ -198,6 +190,20 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
         Message::DocumentMetaLoaded(doc_id, result) => {
             if let Ok(meta) = result {
                 if let Some(tab) = app.tabs.iter_mut().find(|t| t.id == doc_id) {
+                    // The walk measured pages in file order; pages deleted or
+                    // moved while it ran are looked up through `page_mapping`.
+                    let heights: Option<Vec<f32>> = tab
+                        .page_mapping
+                        .iter()
+                        .map(|&page| meta.page_heights.get(page).copied())
+                        .collect();
+                    if let Some(heights) = heights
+                        && heights.len() == tab.page_heights.len()
+                    {
+                        tab.page_width = meta.max_width;
+                        tab.set_page_heights(heights);
+                        tab.update_visible_range();
+                    }
                     tab.outline = meta.outline;
                     tab.links = meta.links;
                     tab.metadata = meta.metadata;
@@ -213,9 +219,7 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
         }
         Message::OpenFile(path) => {
             if app.engine.is_none() {
-                let cache_size = app.settings.cache_size as u64;
-                let max_mem = app.settings.max_cache_memory as u64;
-                app.engine = Some(crate::engine::spawn_engine_thread(cache_size, max_mem));
+                app.engine = Some(crate::engine::spawn_engine_thread(&app.settings));
             }
 
             let tab = DocumentTab::new(path.clone());
@@ -225,33 +229,7 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
             app.add_recent_file(&path);
 
             if let Some(engine) = &app.engine {
-                let cmd_tx = engine.cmd_tx.clone();
-                let path_s = path.to_string_lossy().to_string();
-                return Task::perform(
-                    async move {
-                        let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
-                        if let Err(e) = cmd_tx
-                            .send(crate::commands::PdfCommand::Open(
-                                path_s, None, doc_id, resp_tx,
-                            ))
-                            .await
-                        {
-                            tracing::error!("Failed to send Open command: {e}");
-                            return Err(crate::models::PdfError::EngineDied);
-                        }
-                        let res = resp_rx
-                            .await
-                            .unwrap_or(Err(crate::models::PdfError::EngineDied));
-                        Ok((doc_id, res))
-                    },
-                    |res| match res {
-                        Ok((id, r)) => Message::DocumentOpened(id, r),
-                        Err(_) => Message::DocumentOpened(
-                            crate::models::DocumentId(0),
-                            Err(crate::models::PdfError::EngineDied),
-                        ),
-                    },
-                );
+                return open_document(engine, &path, doc_id);
             }
             Task::none()
         }
@@ -290,14 +268,19 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
                 app.active_tab = app.tabs.len() - 1;
             }
             app.save_session();
-            Task::none()
+            app.open_pending_tab()
         }
         Message::SwitchTab(idx) => {
             if !app.tabs.is_empty() {
                 let safe_idx = idx.min(app.tabs.len() - 1);
                 if safe_idx != app.active_tab {
+                    if let Some(tab) = app.current_tab_mut() {
+                        tab.view_state.last_active = std::time::Instant::now();
+                    }
                     app.active_tab = safe_idx;
                     app.save_session();
+                    app.enforce_memory_budget();
+                    return Task::batch([app.open_pending_tab(), app.render_visible_pages()]);
                 }
             }
             Task::none()
@@ -335,6 +318,15 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
         }
 
         Message::DocumentModifiedExternally(path) => {
+            // Without unsaved annotations there is nothing to lose, so the
+            // view follows the file; regenerated reports preview live.
+            if app
+                .tabs
+                .iter()
+                .any(|t| t.path == path && !t.annotations_dirty)
+            {
+                return Task::done(Message::ReloadDocument(path));
+            }
             if app.tabs.iter().any(|t| t.path == path) {
                 let path_clone = path.clone();
                 let file_name = path
@@ -365,49 +357,83 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
             Task::none()
         }
         Message::ReloadDocument(path) => {
-            if let Some(idx) = app.tabs.iter().position(|t| t.path == path) {
-                let doc_id = app.tabs[idx].id;
-                if let Some(engine) = &app.engine {
-                    let new_tab = DocumentTab::new(path.clone());
-                    let new_doc_id = new_tab.id;
-                    app.tabs[idx] = new_tab;
-                    app.active_tab = idx;
-
-                    let cmd_tx = engine.cmd_tx.clone();
-                    let path_s = path.to_string_lossy().to_string();
-                    return Task::perform(
-                        async move {
-                            let _ = cmd_tx
-                                .send(crate::commands::PdfCommand::Close(doc_id))
-                                .await;
-
-                            let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
-                            if let Err(e) = cmd_tx
-                                .send(crate::commands::PdfCommand::Open(
-                                    path_s, None, new_doc_id, resp_tx,
-                                ))
-                                .await
-                            {
-                                tracing::error!("Failed to send Open command: {e}");
-                                return Err(crate::models::PdfError::EngineDied);
-                            }
-                            let res = resp_rx
-                                .await
-                                .unwrap_or(Err(crate::models::PdfError::EngineDied));
-                            Ok((new_doc_id, res))
-                        },
-                        |res| match res {
-                            Ok((id, r)) => Message::DocumentOpened(id, r),
-                            Err(_) => Message::DocumentOpened(
-                                crate::models::DocumentId(0),
-                                Err(crate::models::PdfError::EngineDied),
-                            ),
-                        },
-                    );
-                }
+            if let Some(tab) = app.tabs.iter().find(|t| t.path == path)
+                && let Some(engine) = &app.engine
+            {
+                let doc_id = tab.id;
+                let cmd_tx = engine.cmd_tx.clone();
+                return Task::perform(
+                    async move {
+                        let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
+                        if cmd_tx
+                            .send(crate::commands::PdfCommand::Reload(doc_id, resp_tx))
+                            .await
+                            .is_err()
+                        {
+                            return Err(PdfError::EngineDied);
+                        }
+                        resp_rx.await.unwrap_or(Err(PdfError::EngineDied))
+                    },
+                    move |res| Message::DocumentReloaded(doc_id, res),
+                );
             }
             Task::none()
         }
+        Message::DocumentReloaded(doc_id, result) => {
+            let Some(idx) = app.tabs.iter().position(|t| t.id == doc_id) else {
+                return Task::none();
+            };
+            let res = match result {
+                Ok(res) => res,
+                Err(e) => {
+                    tracing::warn!("Incremental reload failed, reopening: {e}");
+                    return reopen_document(app, idx);
+                }
+            };
+
+            let tab = &mut app.tabs[idx];
+            let count = res.open.page_count;
+            let changed: std::collections::HashSet<usize> = res.changed_pages.into_iter().collect();
+            if count != tab.total_pages {
+                tab.page_mapping = (0..count).collect();
+                tab.page_labels = (1..=count).map(|i| i.to_string()).collect();
+                tab.page_rotations.retain(|&page, _| page < count);
+                tab.current_page = tab.current_page.min(count.saturating_sub(1));
+            }
+            tab.total_pages = count;
+            tab.page_width = res.open.max_width;
+            tab.metadata = res.open.metadata;
+            tab.is_encrypted = res.open.is_encrypted;
+            tab.generation = res.open.generation;
+            tab.file_bytes = res.open.file_bytes;
+            tab.fingerprint = res.open.fingerprint;
+            tab.search_results
+                .retain(|r| r.page < count && !changed.contains(&r.page));
+            tab.current_search_index = tab
+                .current_search_index
+                .min(tab.search_results.len().saturating_sub(1));
+            tab.view_state.forget_pages(&changed, count);
+            tab.set_page_heights(res.open.page_heights);
+            tab.update_visible_range();
+            app.status_message = Some(format!(
+                "Reloaded {}: {} of {count} pages changed",
+                tab.name,
+                changed.len()
+            ));
+
+            let mut tasks = vec![app.render_visible_pages()];
+            if let Some(engine) = &app.engine {
+                tasks.push(load_document_meta(engine, doc_id));
+                let cmd_tx = engine.cmd_tx.clone();
+                let persist = app.settings.persist_text_index;
+                tokio::spawn(async move {
+                    let _ = cmd_tx
+                        .send(crate::commands::PdfCommand::BuildTextIndex(doc_id, persist))
+                        .await;
+                });
+            }
+            Task::batch(tasks)
+        }
         Message::PasswordInputChanged(input) => {
             app.password_input = input;
             Task::none()
@@ -545,7 +571,7 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
                 let obj_id = layer.object_id;
                 let doc_id = tab.id;
 
-                tab.view_state.rendered_pages.clear();
+                tab.view_state.clear_rendered();
                 tab.view_state.thumbnails.clear();
 
                 if let Some(engine) = &app.engine {
@@ -568,3 +594,85 @@ pub fn handle_tab_message(app: &mut PdfBullApp, message: Message) -> Task<Messag
         _ => Task::none(),
     }
 }
+
+/// Replaces the tab at `idx` with a fresh one on a new document id, dropping
+/// every cached render of the old one. Used when a reload cannot keep them.
+fn reopen_document(app: &mut PdfBullApp, idx: usize) -> Task<Message> {
+    let Some(engine) = &app.engine else {
+        return Task::none();
+    };
+    let path = app.tabs[idx].path.clone();
+    let doc_id = app.tabs[idx].id;
+    let new_tab = DocumentTab::new(path.clone());
+
+    // The old id is closed before the file is opened under the new one.
+    let cmd_tx = engine.cmd_tx.clone();
+    let close = Task::future(async move {
+        let _ = cmd_tx
+            .send(crate::commands::PdfCommand::Close(doc_id))
+            .await;
+    })
+    .discard();
+    let open = open_document(engine, &path, new_tab.id);
+
+    app.tabs[idx] = new_tab;
+    app.active_tab = idx;
+    close.chain(open)
+}
+
+/// Sends `Open` for a tab that already exists under `doc_id`.
+pub fn open_document(
+    engine: &crate::engine::EngineState,
+    path: &std::path::Path,
+    doc_id: crate::models::DocumentId,
+) -> Task<Message> {
+    let cmd_tx = engine.cmd_tx.clone();
+    let path_s = path.to_string_lossy().to_string();
+    Task::perform(
+        async move {
+            let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
+            if let Err(e) = cmd_tx
+                .send(crate::commands::PdfCommand::Open(
+                    path_s, None, doc_id, resp_tx,
+                ))
+                .await
+            {
+                tracing::error!("Failed to send Open command: {e}");
+                return Err(crate::models::PdfError::EngineDied);
+            }
+            let res = resp_rx
+                .await
+                .unwrap_or(Err(crate::models::PdfError::EngineDied));
+            Ok((doc_id, res))
+        },
+        |res| match res {
+            Ok((id, r)) => Message::DocumentOpened(id, r),
+            Err(_) => Message::DocumentOpened(
+                crate::models::DocumentId(0),
+                Err(crate::models::PdfError::EngineDied),
+            ),
+        },
+    )
+}
+
+fn load_document_meta(
+    engine: &crate::engine::EngineState,
+    doc_id: crate::models::DocumentId,
+) -> Task<Message> {
+    let cmd_tx = engine.cmd_tx.clone();
+    Task::perform(
+        async move {
+            let (resp_tx, resp_rx) = tokio::sync::oneshot::channel();
+            let _ = cmd_tx
+                .send(crate::commands::PdfCommand::LoadDocumentMeta(
+                    doc_id, resp_tx,
+                ))
+                .await;
+            match resp_rx.await {
+                Ok(meta) => (doc_id, meta),
+                Err(_) => (doc_id, Err(PdfError::ChannelClosed)),
+            }
+        },
+        |(doc_id, meta)| Message::DocumentMetaLoaded(doc_id, meta),
+    )
+}
@@ -153,15 +153,11 @@ async fn test_open_document_flow() {
         page_count: 5,
         page_heights: vec![800.0; 5],
         max_width: 600.0,
-        outline: Vec::new(),
-        links: Vec::new(),
         metadata: pdfbull::models::DocumentMetadata::default(),
-        page_labels: Vec::new(),
         is_encrypted: false,
-        signatures: Vec::new(),
-        attachments: Vec::new(),
-        layers: Vec::new(),
-        oc_config: None,
+        generation: 0,
+        file_bytes: 0,
+        fingerprint: None,
     };
 
     // Send DocumentOpenedWithPath message